@@ -0,0 +1,266 @@
+//
+// Time of every exact summation we have -- exsum with all its expansions and
+// backends, xsum, Zhu's ExactSum -- against naive and Kahan sums, on the same
+// buffers. Writes one JSON document to stdout.
+//
+// usage: bench_exactsum [-d dist,...] [-n log2 N | min:max[:step]] [-t threads,...]
+//                       [-r reps] [-m method,...] [-c dataset directory]
+//
+//   dist is naive, uniform[:range], lognormal[:stddev] or illcond[:condition],
+//   as generated by the tests. Defaults: -d uniform:50 -n 16:24:4 -t <max> -r 20
+//   With -c, the inputs are mapped from dataset files, written the first time.
+//
+
+#include <mm_malloc.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stdint.h>
+#include <memory>
+#include <omp.h>
+#include <unistd.h>
+#include <tbb/task_scheduler_init.h>
+
+#include "blas1.hpp"
+#include "common.hpp"
+
+// xsum is written in C99
+extern "C" {
+#define restrict __restrict__
+#include "xsum.h"
+#undef restrict
+}
+
+using namespace std;
+
+static double naive(int N, double* a) {
+    double s = 0.;
+    #pragma omp parallel for reduction(+:s)
+    for (int i = 0; i < N; i++)
+        s += a[i];
+    return s;
+}
+
+// Kahan's compensated sum on each thread, whose results are added naively
+static double kahan(int N, double* a) {
+    double s = 0.;
+    #pragma omp parallel reduction(+:s)
+    {
+        double sum = 0., c = 0.;
+        #pragma omp for
+        for (int i = 0; i < N; i++) {
+            double y = a[i] - c;
+            double t = sum + y;
+            c = (t - sum) - y;
+            sum = t;
+        }
+        s += sum;
+    }
+    return s;
+}
+
+static double xsum_small(int N, double* a) {
+    xsum_small_accumulator acc;
+    xsum_small_init(&acc);
+    xsum_small_addv(&acc, a, N);
+    return xsum_small_round(&acc);
+}
+
+static double xsum_large(int N, double* a) {
+    static xsum_large_accumulator acc;
+    xsum_large_init(&acc);
+    xsum_large_addv(&acc, a, N);
+    return xsum_large_round(&acc);
+}
+
+struct Method {
+    const char* name;
+    bool parallel;       // uses the OpenMP threads
+    bool exact;          // its result must be the correctly rounded sum
+    int fpe;             // for exsum
+    bool early_exit;
+    double (*run)(int, double*);
+    bool tbb;            // runs on TBB threads rather than OpenMP ones
+};
+
+static const Method methods[] = {
+    {"naive",              true,  false, 0, false, naive},
+    {"kahan",              true,  false, 0, false, kahan},
+    {"exsum_superacc",     true,  true,  0, false, 0, true},
+    {"exsum_fpe2",         true,  true,  2, false, 0},
+    {"exsum_fpe3",         true,  true,  3, false, 0},
+    {"exsum_fpe4",         true,  true,  4, false, 0},
+    {"exsum_fpe5",         true,  true,  5, false, 0},
+    {"exsum_fpe6",         true,  true,  6, false, 0},
+    {"exsum_fpe7",         true,  true,  7, false, 0},
+    {"exsum_fpe8",         true,  true,  8, false, 0},
+    {"exsum_fpe4ee",       true,  true,  4, true,  0},
+    {"exsum_fpe6ee",       true,  true,  6, true,  0},
+    {"exsum_fpe8ee",       true,  true,  8, true,  0},
+    {"exsum_auto",         true,  true,  fpe_auto, false, 0},
+    {"exsum_xsum_large",   true,  true,  fpe_xsum_large, false, 0},
+    {"exsum_online_exact", true,  true,  fpe_online_exact, false, 0},
+    {"exsum_ifastsum",     false, true,  fpe_ifastsum, false, 0},
+    {"xsum_small",         false, true,  0, false, xsum_small},
+    {"xsum_large",         false, true,  0, false, xsum_large},
+};
+static const int nmethods = sizeof(methods) / sizeof(methods[0]);
+
+static double call(const Method& m, int N, double* a) {
+    if (m.run)
+        return m.run(N, a);
+    return exsum(N, a, 1, 0, m.fpe, m.early_exit);
+}
+
+static vector<string> split(const string& s, char sep) {
+    vector<string> parts;
+    size_t start = 0, end;
+    while ((end = s.find(sep, start)) != string::npos) {
+        parts.push_back(s.substr(start, end - start));
+        start = end + 1;
+    }
+    parts.push_back(s.substr(start));
+    return parts;
+}
+
+// Describes the dataset of the distribution named by spec; false if it is unknown
+static bool dataset(const string& spec, int N, __dataset_header& h) {
+    vector<string> p = split(spec, ':');
+    bool has_arg = p.size() > 1;
+    if (p[0] == "naive")
+        h = dataset_spec(dataset_naive, N);
+    else if (p[0] == "uniform")
+        h = dataset_spec(dataset_fpuniform, N, has_arg ? atoi(p[1].c_str()) : 50, 0);
+    else if (p[0] == "lognormal")
+        h = dataset_spec(dataset_lognormal, N, 0., has_arg ? strtod(p[1].c_str(), 0) : 2.);
+    else if (p[0] == "illcond")
+        h = dataset_spec(dataset_ill_cond, N, has_arg ? strtod(p[1].c_str(), 0) : 1e50);
+    else
+        return false;
+    return true;
+}
+
+static double percentile(const vector<double>& sorted, int q) {
+    size_t i = (sorted.size() * q) / 100;
+    return sorted[min(i, sorted.size() - 1)];
+}
+
+int main(int argc, char** argv) {
+    vector<string> dists(1, "uniform:50");
+    int lmin = 16, lmax = 24, lstep = 4;
+    vector<int> threads(1, omp_get_max_threads());
+    int reps = 20;
+    vector<string> selected;
+    int maxthreads = omp_get_max_threads();
+    const char* datasets = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:n:t:r:m:c:")) != -1) {
+        if (opt == 'd') {
+            dists = split(optarg, ',');
+        } else if (opt == 'n') {
+            vector<string> p = split(optarg, ':');
+            lmin = lmax = atoi(p[0].c_str());
+            if (p.size() > 1)
+                lmax = atoi(p[1].c_str());
+            lstep = (p.size() > 2) ? max(1, atoi(p[2].c_str())) : 1;
+        } else if (opt == 't') {
+            vector<string> p = split(optarg, ',');
+            threads.clear();
+            for (size_t i = 0; i < p.size(); i++)
+                threads.push_back(max(1, atoi(p[i].c_str())));
+        } else if (opt == 'r') {
+            reps = max(1, atoi(optarg));
+        } else if (opt == 'm') {
+            selected = split(optarg, ',');
+        } else if (opt == 'c') {
+            datasets = optarg;
+        } else {
+            fprintf(stderr, "usage: %s [-d dist,...] [-n log2 N | min:max[:step]] [-t threads,...] [-r reps] [-m method,...] [-c dir]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    double* buffer = (double*) _mm_malloc((size_t(1) << lmax) * sizeof(double), 32);
+    if (!buffer) {
+        fprintf(stderr, "Cannot allocate memory for the main array\n");
+        return 1;
+    }
+
+    printf("{\n  \"cores\": %ld,\n  \"max_threads\": %d,\n  \"reps\": %d,\n  \"results\": [",
+           sysconf(_SC_NPROCESSORS_ONLN), maxthreads, reps);
+    const char* sep = "\n";
+    volatile double sink = 0.;
+    for (size_t d = 0; d < dists.size(); d++) {
+        for (int l = lmin; l <= lmax; l += lstep) {
+            int N = 1 << l;
+            __dataset_header spec;
+            if (!dataset(dists[d], N, spec)) {
+                fprintf(stderr, "Unknown distribution %s\n", dists[d].c_str());
+                return 1;
+            }
+            double* a = datasets ? dataset_open(datasets, spec) : 0;
+            bool mapped = a != 0;
+            if (!mapped) {
+                a = buffer;
+                dataset_generate(spec, a);
+            }
+            double ref = exsum(N, a, 1, 0, 0);
+
+            for (int k = 0; k < nmethods; k++) {
+                const Method& m = methods[k];
+                if (!selected.empty() && find(selected.begin(), selected.end(), m.name) == selected.end())
+                    continue;
+                double p50_1 = 0.;
+                for (size_t t = 0; t < threads.size(); t++) {
+                    // sequential methods are timed once
+                    if (!m.parallel && t > 0)
+                        break;
+                    int nt = m.parallel ? threads[t] : 1;
+                    omp_set_num_threads(nt);
+                    // The first scheduler of the thread sets the number of TBB
+                    // threads; the one of the kernel only joins it
+                    std::unique_ptr<tbb::task_scheduler_init> tbbinit;
+                    if (m.tbb)
+                        tbbinit.reset(new tbb::task_scheduler_init(nt));
+
+                    double s = call(m, N, a);
+                    sink = sink + call(m, N, a);
+                    vector<double> time(reps);
+                    for (int i = 0; i < reps; i++) {
+                        double start = omp_get_wtime();
+                        sink = sink + call(m, N, a);
+                        time[i] = omp_get_wtime() - start;
+                    }
+                    sort(time.begin(), time.end());
+                    double p50 = percentile(time, 50);
+                    if (nt == 1)
+                        p50_1 = p50;
+
+                    printf("%s    {\"dist\": \"%s\", \"n\": %d, \"method\": \"%s\", \"threads\": %d, "
+                           "\"sum\": %.17g, \"correctly_rounded\": %s, "
+                           "\"ns_per_element\": %.4f, \"gb_per_s\": %.3f, ",
+                           sep, dists[d].c_str(), N, m.name, nt,
+                           s, same_bits(s, ref) ? "true" : "false",
+                           1e9 * p50 / N, 8e-9 * N / p50);
+                    if (p50_1 > 0.)
+                        printf("\"speedup\": %.3f, ", p50_1 / p50);
+                    printf("\"time_s\": {\"min\": %.9f, \"p10\": %.9f, \"p50\": %.9f, \"p90\": %.9f, \"p99\": %.9f, \"max\": %.9f}}",
+                           time[0], percentile(time, 10), p50, percentile(time, 90), percentile(time, 99), time[reps - 1]);
+                    sep = ",\n";
+                    if (m.exact && !same_bits(s, ref))
+                        fprintf(stderr, "%s on %s, N = %d: %.17g is not the correctly rounded %.17g\n",
+                                m.name, dists[d].c_str(), N, s, ref);
+                }
+            }
+            omp_set_num_threads(maxthreads);
+            if (mapped)
+                dataset_close(a, spec);
+        }
+    }
+    printf("\n  ]\n}\n");
+
+    _mm_free(buffer);
+    return 0;
+}
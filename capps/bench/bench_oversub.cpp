@@ -0,0 +1,76 @@
+//
+// Latency of exsum / exmts when OpenMP threads outnumber the cores.
+//
+// usage: bench_oversub [log2 N = 14] [calls = 1000] [oversubscription factor = 2]
+//
+
+#include <mm_malloc.h>
+#include <algorithm>
+#include <vector>
+#include <omp.h>
+#include <unistd.h>
+
+#include "blas1.hpp"
+#include "common.hpp"
+
+using namespace std;
+
+static void print_latencies(const char* name, int nthreads, vector<double>& lat) {
+    sort(lat.begin(), lat.end());
+    size_t n = lat.size();
+    printf("%-6s threads = %3d \t p50 = %9.1f us \t p90 = %9.1f us \t p99 = %9.1f us \t max = %9.1f us\n",
+           name, nthreads,
+           1e6 * lat[n / 2], 1e6 * lat[(n * 90) / 100], 1e6 * lat[(n * 99) / 100], 1e6 * lat[n - 1]);
+}
+
+static void run(int N, double* a, int calls, int nthreads) {
+    omp_set_num_threads(nthreads);
+    vector<double> lat_sum(calls), lat_mts(calls);
+    volatile double sink = 0.;
+
+    // Warmup: spawn the thread pool
+    for (int i = 0; i < 10; i++) {
+        sink = sink + exsum(N, a, 1, 0, 4, true);
+    }
+
+    for (int i = 0; i < calls; i++) {
+        double start = omp_get_wtime();
+        sink = sink + exsum(N, a, 1, 0, 4, true);
+        lat_sum[i] = omp_get_wtime() - start;
+    }
+    for (int i = 0; i < calls; i++) {
+        double start = omp_get_wtime();
+        sink = sink + exmts(N, a, 4, true).mts;
+        lat_mts[i] = omp_get_wtime() - start;
+    }
+
+    print_latencies("exsum", nthreads, lat_sum);
+    print_latencies("exmts", nthreads, lat_mts);
+}
+
+int main(int argc, char** argv) {
+    int N = 1 << 14;
+    int calls = 1000;
+    int factor = 2;
+    if (argc > 1)
+        N = 1 << atoi(argv[1]);
+    if (argc > 2)
+        calls = atoi(argv[2]);
+    if (argc > 3)
+        factor = atoi(argv[3]);
+
+    double* a = (double*) _mm_malloc(N * sizeof(double), 32);
+    if (!a) {
+        fprintf(stderr, "Cannot allocate memory for the main array\n");
+        return 1;
+    }
+    init_fpuniform(N, a, 50, 0);
+
+    int ncores = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    printf("N = %d \t calls = %d \t cores = %d\n", N, calls, ncores);
+    run(N, a, calls, ncores);
+    run(N, a, calls, factor * ncores);
+
+    _mm_free(a);
+    return 0;
+}
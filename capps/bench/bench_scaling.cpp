@@ -0,0 +1,240 @@
+//
+// Thread scaling of exsum, exmts, dsum_par and inexact_parallel_mts against
+// the bandwidth roofline of the machine. For each size, placement and number
+// of threads, a STREAM triad of the same footprint gives the bandwidth the
+// kernels could reach; each kernel reports its fraction of it, and of the
+// best triad over all threads and placements. Writes CSV to stdout.
+//
+// usage: bench_scaling [-n log2 N,...] [-t threads,...] [-p compact,scatter]
+//                      [-k kernel,...] [-s min seconds]
+//
+//   By default, N keeps the data half in L1, half in L2, half in the LLC,
+//   then 4 times the LLC (DRAM), and threads go by powers of 2 to all CPUs.
+//
+
+#include <mm_malloc.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <omp.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "blas1.hpp"
+#include "common.hpp"
+#include "pfpbench.hpp"
+#include "par_precise_fp.hpp"
+#include "test_mts.h"
+
+using namespace std;
+
+struct Kernel {
+    const char* name;
+    double (*run)(int, double*);
+};
+
+static double run_exsum(int N, double* a) {
+    return exsum(N, a, 1, 0, 4, true);
+}
+
+static double run_exmts(int N, double* a) {
+    return exmts(N, a, 4, true).mts;
+}
+
+static double run_dsum_par(int N, double* a) {
+    return dsum_par(a, N);
+}
+
+static double run_inexact_mts(int N, double* a) {
+    return inexact_parallel_mts(N, a).mts;
+}
+
+static const Kernel kernels[] = {
+    {"exsum_fpe4ee", run_exsum},
+    {"exmts_fpe4ee", run_exmts},
+    {"dsum_par", run_dsum_par},
+    {"inexact_parallel_mts", run_inexact_mts},
+};
+static const int nkernels = sizeof(kernels) / sizeof(kernels[0]);
+
+// STREAM triad on arrays of n elements: 3 * 8 * n bytes move
+static void triad(long n, double* x, const double* y, const double* z) {
+    const double q = 3.;
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < n; i++)
+        x[i] = y[i] + q * z[i];
+}
+
+struct Size {
+    string level;
+    long n;
+};
+
+static long cache_size(int name, long fallback) {
+    long s = sysconf(name);
+    return s > 0 ? s : fallback;
+}
+
+static vector<Size> default_sizes() {
+    long l1 = cache_size(_SC_LEVEL1_DCACHE_SIZE, 32 << 10);
+    long l2 = cache_size(_SC_LEVEL2_CACHE_SIZE, 1 << 20);
+    long llc = cache_size(_SC_LEVEL3_CACHE_SIZE, l2);
+    vector<Size> sizes;
+    Size s[] = {{"l1", l1 / 16}, {"l2", l2 / 16}, {"llc", llc / 16}, {"dram", llc / 2}};
+    for (int i = 0; i < 4; i++)
+        sizes.push_back(s[i]);
+    return sizes;
+}
+
+static vector<string> split(const string& s, char sep) {
+    vector<string> parts;
+    size_t start = 0, end;
+    while ((end = s.find(sep, start)) != string::npos) {
+        parts.push_back(s.substr(start, end - start));
+        start = end + 1;
+    }
+    parts.push_back(s.substr(start));
+    return parts;
+}
+
+// Pins the threads, then logs the CPU each one runs on to stderr. False unless
+// they run on distinct CPUs, or on all of them when there are more threads
+static bool check_placement(pfp_placement placement, const char* name) {
+    size_t ncpus = pfp_cpu_order(placement).size();
+    bool pinned = pfp_pin_threads(placement);
+    vector<int> cpus(omp_get_max_threads(), -1);
+#pragma omp parallel
+    cpus[omp_get_thread_num()] = sched_getcpu();
+    fprintf(stderr, "# %s, %d threads on CPUs", name, (int) cpus.size());
+    for (size_t i = 0; i < cpus.size(); i++)
+        fprintf(stderr, " %d", cpus[i]);
+    fprintf(stderr, "\n");
+    sort(cpus.begin(), cpus.end());
+    size_t distinct = unique(cpus.begin(), cpus.end()) - cpus.begin();
+    return pinned && distinct == min(cpus.size(), ncpus);
+}
+
+static void print_row(const Size& size, const char* placement, double gbs, double triad_gbs,
+                      double roofline_gbs, const pfp_bench_result& r) {
+    printf("%s,%ld,%ld,%s,%.3f,%.3f,%.4f,%.3f,%.4f,", size.level.c_str(), size.n, 8 * size.n, placement,
+           gbs, triad_gbs, gbs / triad_gbs, roofline_gbs, gbs / roofline_gbs);
+    pfp_bench_csv(stdout, r);
+}
+
+int main(int argc, char** argv) {
+    vector<Size> sizes = default_sizes();
+    int ncpus = omp_get_num_procs();
+    vector<int> threads;
+    for (int t = 1; t < ncpus; t *= 2)
+        threads.push_back(t);
+    threads.push_back(ncpus);
+    vector<pfp_placement> placements;
+    placements.push_back(pfp_compact);
+    placements.push_back(pfp_scatter);
+    vector<string> selected;
+    pfp_bench_options opt;
+    opt.min_time = 0.05;
+    int maxthreads = omp_get_max_threads();
+
+    int c;
+    while ((c = getopt(argc, argv, "n:t:p:k:s:")) != -1) {
+        if (c == 'n') {
+            vector<string> p = split(optarg, ',');
+            sizes.clear();
+            for (size_t i = 0; i < p.size(); i++) {
+                Size s = {"2^" + p[i], 1L << atoi(p[i].c_str())};
+                sizes.push_back(s);
+            }
+        } else if (c == 't') {
+            vector<string> p = split(optarg, ',');
+            threads.clear();
+            for (size_t i = 0; i < p.size(); i++)
+                threads.push_back(max(1, atoi(p[i].c_str())));
+        } else if (c == 'p') {
+            vector<string> p = split(optarg, ',');
+            placements.clear();
+            for (size_t i = 0; i < p.size(); i++)
+                placements.push_back(p[i] == "scatter" ? pfp_scatter : pfp_compact);
+        } else if (c == 'k') {
+            selected = split(optarg, ',');
+        } else if (c == 's') {
+            opt.min_time = strtod(optarg, 0);
+        } else {
+            fprintf(stderr, "usage: %s [-n log2 N,...] [-t threads,...] [-p compact,scatter] [-k kernel,...] [-s seconds]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    long nmax = 0;
+    for (size_t i = 0; i < sizes.size(); i++)
+        nmax = max(nmax, sizes[i].n);
+    double* a = (double*) _mm_malloc(nmax * sizeof(double), 64);
+    double* x = (double*) _mm_malloc((nmax / 3 + 1) * sizeof(double), 64);
+    double* y = (double*) _mm_malloc((nmax / 3 + 1) * sizeof(double), 64);
+    double* z = (double*) _mm_malloc((nmax / 3 + 1) * sizeof(double), 64);
+    if (!a || !x || !y || !z) {
+        fprintf(stderr, "Cannot allocate memory for the main array\n");
+        return 1;
+    }
+    // First touch by all the threads, as the kernels and triads read the data
+    #pragma omp parallel for schedule(static)
+    for (long i = 0; i < nmax / 3 + 1; i++) {
+        x[i] = 0.;
+        y[i] = 1.;
+        z[i] = 2.;
+    }
+
+    printf("level,n,bytes,placement,gb_s,triad_gb_s,of_triad,roofline_gb_s,of_roofline,");
+    pfp_bench_csv_header(stdout);
+    volatile double sink = 0.;
+    for (size_t s = 0; s < sizes.size(); s++) {
+        const Size& size = sizes[s];
+        int N = (int) size.n;
+        init_fpuniform(N, a, 50, 0);
+        // The triad has the footprint of the kernels, which read 8 * N bytes
+        long n3 = max(1L, size.n / 3);
+
+        vector<vector<double> > triad_gbs(placements.size(), vector<double>(threads.size()));
+        vector<vector<pfp_bench_result> > triad_res(placements.size(), vector<pfp_bench_result>(threads.size()));
+        double roofline_gbs = 0.;
+        for (size_t p = 0; p < placements.size(); p++) {
+            opt.placement = placements[p];
+            for (size_t t = 0; t < threads.size(); t++) {
+                omp_set_num_threads(threads[t]);
+                triad_res[p][t] = pfp_bench("triad", [&] { triad(n3, x, y, z); }, opt);
+                triad_gbs[p][t] = 24e-9 * n3 / triad_res[p][t].median;
+                roofline_gbs = max(roofline_gbs, triad_gbs[p][t]);
+            }
+        }
+
+        for (size_t p = 0; p < placements.size(); p++) {
+            opt.placement = placements[p];
+            const char* placement = placements[p] == pfp_scatter ? "scatter" : "compact";
+            for (size_t t = 0; t < threads.size(); t++) {
+                omp_set_num_threads(threads[t]);
+                if (!check_placement(placements[p], placement)) {
+                    fprintf(stderr, "%s placement of %d threads does not use distinct CPUs\n", placement, threads[t]);
+                    return 1;
+                }
+                print_row(size, placement, triad_gbs[p][t], triad_gbs[p][t], roofline_gbs, triad_res[p][t]);
+                for (int k = 0; k < nkernels; k++) {
+                    const Kernel& kernel = kernels[k];
+                    if (!selected.empty() && find(selected.begin(), selected.end(), kernel.name) == selected.end())
+                        continue;
+                    pfp_bench_result r = pfp_bench(kernel.name, [&] { sink = sink + kernel.run(N, a); }, opt);
+                    print_row(size, placement, 8e-9 * N / r.median, triad_gbs[p][t], roofline_gbs, r);
+                }
+                fflush(stdout);
+            }
+        }
+    }
+    omp_set_num_threads(maxthreads);
+
+    _mm_free(a);
+    _mm_free(x);
+    _mm_free(y);
+    _mm_free(z);
+    return 0;
+}
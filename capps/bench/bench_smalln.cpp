@@ -0,0 +1,56 @@
+//
+// Per-call time of exsum / exmts for N from 10^3 to 10^6, where the fixed
+// cost of a call (allocation, thread start, reduction tree) matters.
+//
+// usage: bench_smalln [calls = 2000]
+//
+
+#include <mm_malloc.h>
+#include <algorithm>
+#include <vector>
+#include <omp.h>
+
+#include "blas1.hpp"
+#include "common.hpp"
+
+using namespace std;
+
+static double median(vector<double>& t) {
+    sort(t.begin(), t.end());
+    return t[t.size() / 2];
+}
+
+int main(int argc, char** argv) {
+    int calls = 2000;
+    if (argc > 1)
+        calls = atoi(argv[1]);
+
+    int const Nmax = 1000000;
+    double* a = (double*) _mm_malloc(Nmax * sizeof(double), 32);
+    if (!a) {
+        fprintf(stderr, "Cannot allocate memory for the main array\n");
+        return 1;
+    }
+    init_fpuniform(Nmax, a, 50, 0);
+
+    printf("threads = %d\n", omp_get_max_threads());
+    volatile double sink = 0.;
+    for (int N = 1000; N <= Nmax; N *= 10) {
+        int reps = max(10, calls / (N / 1000));
+        vector<double> tsum(reps), tmts(reps);
+        for (int i = 0; i < reps; i++) {
+            double start = omp_get_wtime();
+            sink = sink + exsum(N, a, 1, 0, 4, true);
+            tsum[i] = omp_get_wtime() - start;
+        }
+        for (int i = 0; i < reps; i++) {
+            double start = omp_get_wtime();
+            sink = sink + exmts(N, a, 4, true).mts;
+            tmts[i] = omp_get_wtime() - start;
+        }
+        printf("N = %7d \t exsum = %10.2f us \t exmts = %10.2f us\n", N, 1e6 * median(tsum), 1e6 * median(tmts));
+    }
+
+    _mm_free(a);
+    return 0;
+}
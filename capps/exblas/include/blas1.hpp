@@ -18,6 +18,7 @@
 
 // config from cmake
 #include "config.h"
+#include <stdint.h>
 
 
 struct __mts {
@@ -25,6 +26,54 @@ struct __mts {
     double mts;
 };
 
+struct __moments {
+    int count;
+    double sum;
+    double sumsq;
+    double mean;
+    double variance;
+};
+
+struct __covariance {
+    int count;
+    double sumx;
+    double sumy;
+    double sumxy;
+    double meanx;
+    double meany;
+    double varx;
+    double vary;
+    double covariance;
+};
+
+/**
+ * \ingroup ExSUM
+ * \brief Value of fpe that lets exsum choose the floating-point expansion size
+ *     and early-exit technique from the data
+ */
+const int fpe_auto = -1;
+
+/**
+ * \ingroup ExSUM
+ * \brief Value of fpe that makes exsum sum with the large accumulators of xsum,
+ *     one per thread, instead of floating-point expansions and superaccumulators
+ */
+const int fpe_xsum_large = -2;
+
+/**
+ * \ingroup ExSUM
+ * \brief Value of fpe that makes exsum sum with the accumulators of OnlineExactSum,
+ *     one object per thread, instead of floating-point expansions and superaccumulators
+ */
+const int fpe_online_exact = -3;
+
+/**
+ * \ingroup ExSUM
+ * \brief Value of fpe that makes exsum sum with iFastSum, on one thread, over a copy
+ *     of the vector
+ */
+const int fpe_ifastsum = -4;
+
 /**
  * \defgroup blas1 BLAS Level-1 Functions
  */
@@ -40,11 +89,23 @@ struct __mts {
  *     multi-level reproducible and accurate algorithm.
  *
  *     If fpe < 2, it uses superaccumulators only. Otherwise, it relies on 
- *     floating-point expansions of size FPE with superaccumulators when needed
+ *     floating-point expansions of size FPE with superaccumulators when needed.
+ *     If fpe == fpe_auto, the size and early-exit technique are adapted along the
+ *     vector to the rate of flushes to the superaccumulators; early_exit is ignored.
+ *     If fpe == fpe_xsum_large, each thread sums its part of the vector with a large
+ *     accumulator of xsum, and their exact sums are added and rounded once.
+ *     If fpe == fpe_online_exact, the same holds for the accumulators of
+ *     OnlineExactSum, and if fpe == fpe_ifastsum, iFastSum sums a copy of the vector.
+ *     The remaining traits of the expansion come from the tuning profile written by
+ *     "make tune" (or named by EXBLAS_TUNING_PROFILE), when there is one.
+ *     Every value of fpe sums the elements ag[offset + i * inca], i < Ng; the
+ *     expansions read them with aligned vector loads only when inca == 1 and
+ *     ag + offset is aligned on 32 bytes.
+ *     With MPI, the sum is returned by the first process, and the others return 0
  *
  * \param Ng vector size
  * \param ag vector
- * \param inca specifies the increment for the elements of a
+ * \param inca specifies the increment for the elements of a, positive
  * \param offset specifies position in the vector from its start
  * \param fpe stands for the floating-point expansions size (used in conjuction with superaccumulators)
  * \param early_exit specifies the optimization technique. By default, it is disabled
@@ -52,6 +113,126 @@ struct __mts {
  */
 double exsum(const int Ng, double *ag, const int inca, const int offset, const int fpe, const bool early_exit = false);
 
+/**
+ * \ingroup ExSUM
+ * \brief Parallel nrm2 computes the Euclidean norm of a real vector with our
+ *     multi-level reproducible and accurate algorithm.
+ *
+ *     The squares of the elements are accumulated exactly, as in exsum, their sum
+ *     is rounded once and its square root is correctly rounded. There is no
+ *     scaling pass, unless a square overflows or the sum of squares falls below
+ *     2^-860; the square root is then scaled back by a power of two, which is
+ *     exact unless the norm is subnormal, where it rounds a second time.
+ *     The only contributions that are not accounted for are the parts of squares
+ *     below 2^-1074, which cannot change the rounding of a sum above 2^-860
+ *
+ * \param N vector size
+ * \param x vector
+ * \param inc specifies the increment for the elements of x
+ * \param fpe stands for the floating-point expansions size (used in conjuction with superaccumulators)
+ * \param early_exit specifies the optimization technique. By default, it is disabled
+ * \return Contains the reproducible and accurate norm of a real vector
+ */
+double exnrm2(const int N, double *x, const int inc, const int fpe, const bool early_exit = false);
+
+/**
+ * \ingroup ExSUM
+ * \brief Parallel asum computes the sum of absolute values of elements of a real
+ *     vector with our multi-level reproducible and accurate algorithm.
+ *
+ *     The absolute values are taken in the loop of exsum, in a single pass over x.
+ *     The meaning of fpe is that of exsum
+ *
+ * \param N vector size
+ * \param x vector
+ * \param inc specifies the increment for the elements of x
+ * \param fpe stands for the floating-point expansions size (used in conjuction with superaccumulators)
+ * \param early_exit specifies the optimization technique. By default, it is disabled
+ * \return Contains the reproducible and accurate sum of absolute values
+ */
+double exasum(const int N, double *x, const int inc, const int fpe, const bool early_exit = false);
+
+/**
+ * \ingroup ExSUM
+ * \brief Parallel weighted sum computes the sum of w[i]*x[i] with our multi-level
+ *     reproducible and accurate algorithm.
+ *
+ *     The products are accumulated exactly, as a product and its rounding error,
+ *     in a single pass over w and x. The meaning of fpe is that of exsum
+ *
+ * \param N vector size
+ * \param w weights
+ * \param incw specifies the increment for the elements of w
+ * \param x vector
+ * \param incx specifies the increment for the elements of x
+ * \param fpe stands for the floating-point expansions size (used in conjuction with superaccumulators)
+ * \param early_exit specifies the optimization technique. By default, it is disabled
+ * \return Contains the reproducible and accurate weighted sum
+ */
+double exwsum(const int N, double *w, const int incw, double *x, const int incx, const int fpe, const bool early_exit = false);
+
+/**
+ * \ingroup ExSUM
+ * \brief Parallel summation of a single-precision vector with our multi-level
+ *     reproducible and accurate algorithm.
+ *
+ *     The elements are loaded eight at a time and widened to double in registers,
+ *     which is exact. The superaccumulators only span the range of floats: six
+ *     words instead of 39. The meaning of fpe is that of exsum; the backends
+ *     selected by fpe < 0 sum a copy of the elements widened to double
+ *
+ * \param Ng vector size
+ * \param ag vector
+ * \param inca specifies the increment for the elements of a
+ * \param offset specifies position in the vector from its start
+ * \param fpe stands for the floating-point expansions size (used in conjuction with superaccumulators)
+ * \param early_exit specifies the optimization technique. By default, it is disabled
+ * \return Contains the reproducible sum of elements, correctly rounded to double
+ */
+double exsum_f32(const int Ng, float *ag, const int inca, const int offset, const int fpe, const bool early_exit = false);
+
+/**
+ * \ingroup ExSUM
+ * \brief Parallel summation of a half-precision vector with our multi-level
+ *     reproducible and accurate algorithm.
+ *
+ *     The elements are IEEE binary16 bit patterns, converted in the loop with
+ *     F16C when available. If fpe < 2, they are summed in fixed point: half-precision
+ *     numbers are multiples of 2^-24 below 2^16, so that double lanes hold exact
+ *     partial sums that move to a 128-bit integer from time to time. Otherwise,
+ *     the elements go through floating-point expansions of size FPE and the
+ *     superaccumulators of exsum_f32. The backends selected by fpe < 0 sum a
+ *     copy of the elements widened to double, as in exsum_f32
+ *
+ * \param Ng vector size
+ * \param ag vector of binary16 numbers
+ * \param inca specifies the increment for the elements of a
+ * \param offset specifies position in the vector from its start
+ * \param fpe stands for the floating-point expansions size (used in conjuction with superaccumulators)
+ * \param early_exit specifies the optimization technique. By default, it is disabled
+ * \return Contains the reproducible sum of elements, correctly rounded to double
+ */
+double exsum_f16(const int Ng, uint16_t *ag, const int inca, const int offset, const int fpe, const bool early_exit = false);
+
+/**
+ * \ingroup ExSUM
+ * \brief Parallel summation of a bfloat16 vector with our multi-level
+ *     reproducible and accurate algorithm.
+ *
+ *     The elements are the upper halves of floats, widened in the loop. As they
+ *     span the range of floats, they are accumulated as in exsum_f32, with the
+ *     same meaning of fpe
+ *
+ * \param Ng vector size
+ * \param ag vector of bfloat16 numbers
+ * \param inca specifies the increment for the elements of a
+ * \param offset specifies position in the vector from its start
+ * \param fpe stands for the floating-point expansions size (used in conjuction with superaccumulators)
+ * \param early_exit specifies the optimization technique. By default, it is disabled
+ * \return Contains the reproducible sum of elements, correctly rounded to double
+ */
+double exsum_bf16(const int Ng, uint16_t *ag, const int inca, const int offset, const int fpe, const bool early_exit = false);
+
 /**
  * \defgroup ExDOT Dot Product Functions
  * \ingroup blas1
@@ -78,6 +259,30 @@ double exsum(const int Ng, double *ag, const int inca, const int offset, const i
  */
 double exdot(const int Ng, double *ag, const int inca, const int offseta, double *bg, const int incb, const int offsetb, const int fpe, const bool early_exit = false);
 
+/**
+ * \ingroup ExDOT
+ * \brief Parallel dot product of two single-precision vectors with our
+ *     multi-level reproducible and accurate algorithm.
+ *
+ *     The elements are widened to double, where their products are exact, so
+ *     that each product enters the floating-point expansions as a single double.
+ *     The superaccumulators span the range of these products: twelve words.
+ *     The meaning of fpe is that of exsum; the backends selected by fpe < 0 sum
+ *     a copy of the products
+ *
+ * \param Ng vector size
+ * \param ag vector
+ * \param inca specifies the increment for the elements of a
+ * \param offseta specifies position in the vector a from its start
+ * \param bg vector
+ * \param incb specifies the increment for the elements of b
+ * \param offsetb specifies position in the vector b from its start
+ * \param fpe stands for the floating-point expansions size (used in conjuction with superaccumulators)
+ * \param early_exit specifies the optimization technique. By default, it is disabled
+ * \return Contains the reproducible dot product, correctly rounded to double
+ */
+double exdot_f32(const int Ng, float *ag, const int inca, const int offseta, float *bg, const int incb, const int offsetb, const int fpe, const bool early_exit = false);
+
 
 /**
  * \defgroup Ex MTS Sum combined with Max function (maximum tail sum)
@@ -101,5 +306,193 @@ double exdot(const int Ng, double *ag, const int inca, const int offseta, double
 __mts exmts(const int Ng, double *ag, const int fpe, const bool early_exit = false);
 
 
+/**
+ * \defgroup ExMOMENTS Statistics Functions
+ * \ingroup blas1
+ */
+
+/**
+ * \ingroup ExMOMENTS
+ * \brief Parallel moments compute the count, the sum and the sum of squares of
+ *     the elements of a real vector in a single pass, with our multi-level
+ *     reproducible and accurate algorithm, and derive their mean and variance.
+ *
+ *     The sum is exact until the final rounding, and the mean is the correctly
+ *     rounded sum/count, subnormal or not. The sum of squares is exact until the
+ *     final rounding, and the variance the correctly rounded (count*sumsq - sum^2)
+ *     / (count*(count - ddof)), when the square of each element is exact: that is
+ *     when the elements are multiples of 2^-537, which holds for those of magnitude
+ *     2^-485 or more. When the squares overflow, or their sum is below 2^-860 or
+ *     at least 2^960, this bound applies to the elements scaled by the power of
+ *     two that brings the largest magnitude into [1, 2). Below it, the bits of
+ *     the squares under 2^-1074 are lost, as with exnrm2.
+ *     If fpe < 2, it uses superaccumulators only. Otherwise, it relies on
+ *     floating-point expansions of size FPE with superaccumulators when needed
+ *
+ * \param N vector size
+ * \param x vector
+ * \param inc the increment for the elements of x
+ * \param ddof delta degrees of freedom: 0 for the population variance, 1 for the
+ *     sample variance. The variance is NaN if N <= ddof
+ * \param fpe stands for the floating-point expansions size (used in conjuction with superaccumulators)
+ * \param early_exit specifies the optimization technique. By default, it is disabled
+ * \return Contains the reproducible and accurate count, sum, sum of squares, mean and variance
+ */
+__moments exmoments(const int N, double *x, const int inc, const int ddof, const int fpe, const bool early_exit = false);
+
+/**
+ * \ingroup ExMOMENTS
+ * \brief Parallel covariance computes the sums, means and variances of two real
+ *     vectors and their covariance in a single pass, with our multi-level
+ *     reproducible and accurate algorithm.
+ *
+ *     The covariance is the correctly rounded (count*sumxy - sumx*sumy) /
+ *     (count*(count - ddof)), computed from the exact sums; the means and
+ *     variances are those of exmoments. As the variances, the covariance is
+ *     correctly rounded when the elements of both vectors, each scaled on its
+ *     own as in exmoments, are multiples of 2^-537
+ *
+ * \param N vector size
+ * \param x vector
+ * \param incx the increment for the elements of x
+ * \param y vector
+ * \param incy the increment for the elements of y
+ * \param ddof delta degrees of freedom, as in exmoments
+ * \param fpe stands for the floating-point expansions size (used in conjuction with superaccumulators)
+ * \param early_exit specifies the optimization technique. By default, it is disabled
+ * \return Contains the reproducible and accurate sums, means, variances and covariance
+ */
+__covariance excovariance(const int N, double *x, const int incx, double *y, const int incy, const int ddof, const int fpe, const bool early_exit = false);
+
+
+/**
+ * \defgroup Profiling Profiling of the Kernels
+ * \ingroup blas1
+ */
+
+/**
+ * \ingroup Profiling
+ * \brief Phases of exsum and of the kernels that share its reduction
+ */
+enum {
+    exprofile_accumulate,   ///< floating-point expansion loop, excluding its flushes
+    exprofile_flush,        ///< FlushVector: expansion overflows moved to the superaccumulator
+    exprofile_normalize,    ///< normalization of the per-thread superaccumulators
+    exprofile_reduction,    ///< reduction tree among threads, including the waits
+    exprofile_round,        ///< rounding of the final superaccumulator
+    exprofile_phases
+};
+
+/**
+ * \ingroup Profiling
+ * \brief Bits of __profile::available, one per hardware counter
+ */
+enum {
+    exprofile_cycles = 1 << 0,
+    exprofile_instructions = 1 << 1,
+    exprofile_l1d_misses = 1 << 2,
+    exprofile_l2_misses = 1 << 3,
+    exprofile_llc_misses = 1 << 4,
+    exprofile_branch_misses = 1 << 5
+};
+
+struct __profile_counters {
+    uint64_t calls;          // times the phase was entered
+    uint64_t ticks;          // time stamp counter, always available
+    uint64_t cycles;
+    uint64_t instructions;
+    uint64_t l1d_misses;     // L1 data cache read misses
+    uint64_t l2_misses;      // last-level cache read accesses, that is L2 misses
+    uint64_t llc_misses;     // last-level cache read misses
+    uint64_t branch_misses;
+};
+
+struct __profile {
+    __profile_counters phase[exprofile_phases];  // summed over threads
+    unsigned int available;  // counters that perf_event_open provided on every thread
+};
+
+/**
+ * \ingroup Profiling
+ * \brief Enables or disables profiling at run time.
+ *
+ *     While it is enabled, each thread counts with perf_event_open the cycles,
+ *     instructions, cache and branch misses of the phase it is in. Counters the
+ *     kernel or the processor does not provide stay zero and are missing from
+ *     __profile::available. When disabled, the phases cost one test of a flag.
+ *     When enabled, each change of phase reads the counters, with rdpmc if the
+ *     kernel allows it and with a read() system call otherwise: the counts of
+ *     short phases, such as flush, then mostly measure the profiler itself.
+ *     The flush phase is only counted when ExBLAS is built with
+ *     EXBLAS_FPE_COUNTERS; otherwise its flushes count towards accumulate
+ *
+ * \param on true to enable profiling
+ */
+void exprofile_enable(const bool on);
+
+/**
+ * \ingroup Profiling
+ * \brief Sets the counts of all phases to zero
+ */
+void exprofile_reset();
+
+/**
+ * \ingroup Profiling
+ * \brief Returns the counts of each phase since the last exprofile_reset. Must not
+ *     be called while a kernel runs
+ *
+ * \return Contains the counts of each phase, summed over all threads
+ */
+__profile exprofile_get();
+
+/**
+ * \ingroup Profiling
+ * \brief Returns the name of a phase, such as "flush"
+ */
+const char * exprofile_phase_name(const int phase);
+
+
+/**
+ * \ingroup Profiling
+ * \brief Size of the early-exit depth histogram: expansions have up to 8 levels
+ */
+const int exfpestats_depths = 9;
+
+struct __fpe_stats {
+    uint64_t inputs;         // vectors of 4 (exsum) or numbers (exmts) entering an expansion
+    uint64_t flushes;        // vectors or numbers that reached a superaccumulator
+    uint64_t depth[exfpestats_depths];  // inputs that went through that many levels:
+                             // fewer than fpe with early-exit, 0 if flushed first
+    uint64_t carries;        // carry propagation steps between superaccumulator words
+};
+
+/**
+ * \ingroup Profiling
+ * \brief Enables or disables the statistics of the floating-point expansions at
+ *     run time.
+ *
+ *     While they are enabled, exsum, exmts and the kernels that share their
+ *     reduction count the inputs of their expansions, the flushes to the
+ *     superaccumulators, how many levels each input went through, and the carry
+ *     propagations in the superaccumulators. flushes / inputs is the rate of
+ *     overflow of the expansions, which tells which fpe suits the data.
+ *     The counts are only kept when ExBLAS is built with EXBLAS_FPE_COUNTERS,
+ *     and stay zero otherwise. When built with them but disabled, each input
+ *     costs one test of a pointer; when built without, nothing
+ *
+ * \param on true to enable the statistics
+ */
+void exfpestats_enable(const bool on);
+
+/**
+ * \ingroup Profiling
+ * \brief Returns the statistics of the last call to a kernel, summed over its
+ *     threads. Calls from several threads at once are not told apart
+ *
+ * \return Contains the counts of the last call
+ */
+__fpe_stats exfpestats_last();
+
+
 #endif // BLAS1_HPP_
 
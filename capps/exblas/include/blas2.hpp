@@ -40,6 +40,12 @@
  *  If fpe < 3, it relies on superaccumulators only. Otherwise, it relies on 
  *  floating-point expansions of size FPE with superaccumulators when needed
  *
+ *  On CPUs, fpe = 0 relies on superaccumulators only, fpe = 1 on the plain
+ *  algorithm, and 2 <= fpe <= 8 on floating-point expansions of size FPE.
+ *  10 <= fpe <= 18 adds one step of iterative refinement with an exact residual
+ *  to the result obtained with fpe - 10, and 21 <= fpe <= 28 to the result of the
+ *  plain algorithm (fpe = 20 is the plain algorithm alone)
+ *
  * \param uplo 'U' or 'L' an upper or a lower triangular matrix A
  * \param transa 'T' or 'N' a transpose or a non-transpose matrix A
  * \param diag 'U' or 'N' a unit or non-unit triangular matrix A
@@ -94,5 +100,39 @@ int extrsv(const char uplo, const char transa, const char diag, const int n, dou
  */
 int exgemv(const char transa, const int m, const int n, const double alpha, double *a, const int lda, const int offseta, double *x, const int incx, const int offsetx, const double beta, double *y, const int incy, const int offsety, const int fpe, const bool early_exit = false);
 
+
+/**
+ * \defgroup ExSPMV Sparse Matrix-Vector Functions
+ * \ingroup blas2
+ */
+
+/**
+ * \ingroup ExSPMV
+ * \brief ExSPMV_CSR performs the sparse matrix-vector operation
+ *
+ *      y := A*x,
+ *
+ *  where A is stored in the compressed sparse row (CSR) format, using our
+ *  multi-level reproducible and accurate algorithm.
+ *
+ *  The nonzeros are split evenly among threads, whatever the lengths of the
+ *  rows; a long row is accumulated by several threads and their superaccumulators
+ *  are merged exactly, so that y does not depend on the number of threads.
+ *  fpe = 0 relies on superaccumulators only, fpe = 1 on the plain algorithm, and
+ *  2 <= fpe <= 8 on floating-point expansions of size FPE
+ *
+ * \param nrows the number of rows of matrix A
+ * \param rowptr positions of the first nonzero of each row, nrows + 1 entries;
+ *      rowptr[nrows] is past the last nonzero
+ * \param colidx column of each nonzero
+ * \param vals value of each nonzero
+ * \param x vector
+ * \param y vector, nrows elements
+ * \param fpe size of floating-point expansion
+ * \param early_exit specifies the optimization technique. By default, it is disabled
+ * \return vector y contains the reproducible and accurate result of the product
+ */
+int exspmv_csr(const int nrows, int *rowptr, int *colidx, double *vals, double *x, double *y, const int fpe, const bool early_exit = false);
+
 #endif // BLAS2_HPP_
 
@@ -36,6 +36,11 @@
  *     If fpe < 2, it relies on superaccumulators only. Otherwise, it relies on floating-point expansions
  *     of size FPE with superaccumulators when needed
  *
+ *     On CPUs, matrices are column-major, fpe = 1 selects the plain algorithm, and beta*C is
+ *     accumulated exactly with alpha*op(A)*op(B). The elements of alpha*op(A) are rounded
+ *     before their products are accumulated, so that each element of C is rounded once
+ *     only when alpha is a power of two (and alpha*op(A) does not underflow)
+ *
  * \param transa 'T' or 'N' -- transpose or non-transpose matrix A
  * \param transb 'T' or 'N' -- transpose or non-transpose matrix B
  * \param m nb of rows of matrix C
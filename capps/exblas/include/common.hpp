@@ -19,6 +19,8 @@
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
+#include <stdint.h>
+#include <omp.h>
 
 /**
  * \defgroup common Common Definitions and Functions
@@ -43,6 +45,36 @@ const int f_bits = 1023 + 52;   // 300
 const int bin_count = 39;
 
 
+/**
+ * \ingroup common
+ * \brief Seed of the vector generators when none is given. The vectors only
+ *  depend on their seed and size, not on the number of threads
+ */
+const uint64_t init_default_seed = 20160101;
+
+/**
+ * \ingroup common
+ * \brief Counter-based generator: the Philox4x32-10 bijection of Salmon et al.,
+ *  Parallel random numbers: as easy as 1, 2, 3, SC'11. Element i of a stream
+ *  is computed on its own, so that threads may generate any part of a vector
+ *
+ * \param seed key of the generator
+ * \param stream independent sequence for the same seed
+ * \param i index of the element in the stream
+ * \param r output: 128 random bits
+ */
+void counter_random(const uint64_t seed, const uint32_t stream, const uint64_t i, uint32_t r[4]);
+
+/**
+ * \ingroup common
+ * \brief Element i of a uniform distribution in [0, 1), from counter_random
+ *
+ * \param seed key of the generator
+ * \param i index of the element
+ * \return The generated number
+ */
+double counter_uniform(const uint64_t seed, const uint64_t i);
+
 /**
  * \ingroup common
  * \brief Generates a random number for log-uniform distribution
@@ -70,8 +102,9 @@ double randDouble(int emin, int emax, int neg_ratio);
  * \param a input/output vector
  * \param range dynamic range of generated elements
  * \param emax maximum exponent (emax + range < EMAX)
+ * \param seed of the generator
  */
-void init_fpuniform(const int n, double *a, int range, int emax);
+void init_fpuniform(const int n, double *a, int range, int emax, const uint64_t seed = init_default_seed);
 
 /**
  * \ingroup common
@@ -108,8 +141,9 @@ void init_fpuniform_tr_matrix(const char uplo, const char diag, const int n, dou
  * \param a input/output vector
  * \param mean 
  * \param stddev
+ * \param seed of the generator
  */
-void init_lognormal(const int n, double *a, double mean, double stddev);
+void init_lognormal(const int n, double *a, double mean, double stddev, const uint64_t seed = init_default_seed);
 
 /**
  * \ingroup common
@@ -148,16 +182,124 @@ void init_lognormal_tr_matrix(const char uplo, const char diag, const int n, dou
  * \param n vector size
  * \param a input/output vector
  * \param c anticipated condition number
+ * \param seed of the generator
  */
-void init_ill_cond(const int n, double *a, double c);
+void init_ill_cond(const int n, double *a, double c, const uint64_t seed = init_default_seed);
 
 /**
  * \ingroup common
- * \brief Generates a real vector with all ellements set to 1.1
+ * \brief Generates a real vector with ellements among -2.1, -1.1, -0.1 and 0.9
  *
  * \param n vector size
  * \param a input/output vector
+ * \param seed of the generator
+ */
+void init_naive(const int n, double *a, const uint64_t seed = init_default_seed);
+
+/**
+ * \ingroup common
+ * \brief Tells whether two doubles have the same bits, as reproducibility
+ *  requires: unlike ==, tells -0 from +0 and compares NaNs
+ *
+ * \param x first number
+ * \param y second number
+ * \return true if x and y have the same representation
+ */
+bool same_bits(double x, double y);
+
+/**
+ * \ingroup common
+ * \brief Calls f with nthreads OpenMP threads, then restores their number
+ *
+ * \param nthreads number of threads
+ * \param f function without arguments
+ * \return The result of f
+ */
+template<typename F>
+auto with_threads(int nthreads, F f) -> decltype(f()) {
+    struct Restore {
+        int n;
+        ~Restore() { omp_set_num_threads(n); }
+    } restore = {omp_get_max_threads()};
+    omp_set_num_threads(nthreads);
+    return f();
+}
+
+/**
+ * \ingroup common
+ * \brief Distributions of the datasets, and the generators that fill them
+ */
+enum {
+    dataset_naive,      ///< init_naive
+    dataset_fpuniform,  ///< init_fpuniform, params: range, emax
+    dataset_lognormal,  ///< init_lognormal, params: mean, stddev
+    dataset_ill_cond,   ///< init_ill_cond, params: condition number
+    dataset_uniform     ///< uniform in [0, params[0]), as counter_uniform
+};
+
+/**
+ * \ingroup common
+ * \brief Alignment of the data in a dataset file and in memory: a huge page
+ */
+const uint64_t dataset_alignment = 2 << 20;
+
+/**
+ * \ingroup common
+ * \brief Header of a dataset file, followed by the n doubles at data_offset
+ */
+struct __dataset_header {
+    char magic[8];           // "EXBLASDS"
+    uint32_t version;
+    uint32_t distribution;
+    uint64_t n;
+    uint64_t seed;
+    double params[2];
+    uint64_t data_offset;    // dataset_alignment
+};
+
+/**
+ * \ingroup common
+ * \brief Describes a dataset
+ *
+ * \param distribution one of dataset_naive, ..., dataset_uniform
+ * \param n vector size
+ * \param p0 first parameter of the distribution
+ * \param p1 second parameter of the distribution
+ * \param seed of the generator
+ * \return The header of the dataset
+ */
+__dataset_header dataset_spec(const int distribution, const uint64_t n, const double p0 = 0., const double p1 = 0.,
+    const uint64_t seed = init_default_seed);
+
+/**
+ * \ingroup common
+ * \brief Generates the data of a dataset in memory
+ *
+ * \param spec the dataset
+ * \param a output vector of spec.n elements
+ */
+void dataset_generate(const __dataset_header &spec, double *a);
+
+/**
+ * \ingroup common
+ * \brief Maps a dataset from its file in dir, which is generated and written
+ *  the first time. The data is mapped privately: writing to it does not change
+ *  the file. It lies on huge pages when dir is on hugetlbfs or on a tmpfs
+ *  mounted with huge=always, such as /dev/shm on some systems
+ *
+ * \param dir directory of the dataset files
+ * \param spec the dataset
+ * \return The data, aligned on dataset_alignment, or 0 if it cannot be mapped
+ */
+double * dataset_open(const char *dir, const __dataset_header &spec);
+
+/**
+ * \ingroup common
+ * \brief Unmaps a dataset returned by dataset_open
+ *
+ * \param a the data
+ * \param spec the dataset
  */
-void init_naive(const int n, double *a);
+void dataset_close(double *a, const __dataset_header &spec);
 
 #endif // COMMON_H
@@ -5,11 +5,69 @@
 
 #include <cstdlib>
 #include <cstdio>
+#include <cstring>
 #include <random>
 #include <math.h>
 #include "common.hpp"
 
 
+// Streams of counter_random, one per generator
+enum {
+    stream_uniform,
+    stream_naive,
+    stream_fpuniform,
+    stream_lognormal,
+    stream_ill_cond_first,
+    stream_ill_cond_second
+};
+
+// Inlined in the generators, so that their loops vectorise
+static inline void philox(const uint64_t seed, const uint32_t stream, const uint64_t i, uint32_t r[4]) {
+    const uint32_t m0 = 0xD2511F53, m1 = 0xCD9E8D57;
+    const uint32_t w0 = 0x9E3779B9, w1 = 0xBB67AE85;
+    uint32_t c0 = uint32_t(i), c1 = uint32_t(i >> 32), c2 = stream, c3 = 0;
+    uint32_t k0 = uint32_t(seed), k1 = uint32_t(seed >> 32);
+    for(int round = 0; round != 10; ++round) {
+        uint64_t p0 = uint64_t(m0) * c0;
+        uint64_t p1 = uint64_t(m1) * c2;
+        c0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+        c1 = uint32_t(p1);
+        c2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+        c3 = uint32_t(p0);
+        k0 += w0;
+        k1 += w1;
+    }
+    r[0] = c0;
+    r[1] = c1;
+    r[2] = c2;
+    r[3] = c3;
+}
+
+void counter_random(const uint64_t seed, const uint32_t stream, const uint64_t i, uint32_t r[4]) {
+    philox(seed, stream, i, r);
+}
+
+// 53 random bits of two words, as a double in [0, 1)
+static inline double to_unit(uint32_t hi, uint32_t lo) {
+    return double((uint64_t(hi) << 21) | (lo >> 11)) / 9007199254740992.;
+}
+
+// 2^e, for any exponent of a normal double
+static inline double pow2(int e) {
+    if(e < -1022 || e > 1023)
+        return ldexp(1., e);
+    union { uint64_t u; double d; } x;
+    x.u = uint64_t(e + 1023) << 52;
+    return x.d;
+}
+
+double counter_uniform(const uint64_t seed, const uint64_t i) {
+    uint32_t r[4];
+    philox(seed, stream_uniform, i, r);
+    return to_unit(r[0], r[1]);
+}
+
+
 double randDoubleUniform() {
     // Uniform distribution for now
     return double(rand() - RAND_MAX/4) * 12345.678901234;
@@ -27,9 +85,19 @@ double randDouble(int emin, int emax, int neg_ratio) {
     return ldexp(x, e);
 }
 
-void init_fpuniform(const int n, double *a, int range, int emax) {
-    for(int i = 0; i != n; ++i)
-        a[i] = randDouble(emax-range, emax, 1);
+bool same_bits(double x, double y) {
+    return memcmp(&x, &y, sizeof(double)) == 0;
+}
+
+void init_fpuniform(const int n, double *a, int range, int emax, const uint64_t seed) {
+    // Positive, with a uniform mantissa in [1, 2) and a uniform exponent in [emax-range, emax)
+    #pragma omp parallel for schedule(static)
+    for(int i = 0; i < n; ++i) {
+        uint32_t r[4];
+        philox(seed, stream_fpuniform, i, r);
+        int e = emax - range + int((uint64_t(r[2]) * uint32_t(range > 0 ? range : 0)) >> 32);
+        a[i] = (1. + to_unit(r[0], r[1])) * pow2(e);
+    }
 }
 
 void init_fpuniform_matrix(const bool iscolumnwise, const int m, const int n, double *a, const int lda, const int range, const int emax) {
@@ -63,13 +131,17 @@ void init_fpuniform_tr_matrix(const char uplo, const char diag, const int n, dou
     }
 }
 
-void init_lognormal(const int n, double * a, double mean, double stddev) {
-    std::random_device rd;
-    std::default_random_engine gen(rd());
-    std::lognormal_distribution<> d(mean, stddev);
-
-    for(int i = 0; i != n; ++i)
-        a[i] = d(gen);
+void init_lognormal(const int n, double * a, double mean, double stddev, const uint64_t seed) {
+    // Box-Muller transform of two uniform numbers, the first in (0, 1]
+    #pragma omp parallel for schedule(static)
+    for(int i = 0; i < n; ++i) {
+        uint32_t r[4];
+        philox(seed, stream_lognormal, i, r);
+        double u = 1. - to_unit(r[0], r[1]);
+        double v = to_unit(r[2], r[3]);
+        double z = sqrt(-2. * log(u)) * cos(2. * M_PI * v);
+        a[i] = exp(mean + stddev * z);
+    }
 }
 
 void init_lognormal_matrix(const bool iscolumnwise, const int m, const int n, double *a, const int lda, const double mean, const double stddev) {
@@ -110,42 +182,35 @@ void init_lognormal_tr_matrix(const char uplo, const char diag, const int n, dou
     }
 }
 
-void init_ill_cond(const int n, double *a, double c) {
-    int n2 = round(n / 2);
-
-    for(int i = 0; i != n; ++i)
-        a[i] = 0.0;
-
-    // init the first half of exponents
-    double *e, x;
-    e = (double *) malloc(n * sizeof(double));
+void init_ill_cond(const int n, double *a, double c, const uint64_t seed) {
+    int n2 = n / 2;
     double b = log2(c);
-    for(int i = 0; i != n2; ++i) {
-        x = double(rand()) / double(RAND_MAX);
-        e[i] = round(x * b / 2);
-    }
-    e[0] = round(b / 2) + 1.;
-    e[n-1] = 0;
 
-    // init the first half of the vector
-    for(int i = 0; i != n2; ++i) {
-        double x = double(rand()) / double(RAND_MAX);
-        a[i] = (2. * x - 1.) * pow(2., e[i]);
+    // First phase: the first half of the vector, with random exponents up to b / 2
+    #pragma omp parallel for schedule(static)
+    for(int i = 0; i < n2; ++i) {
+        uint32_t r[4];
+        philox(seed, stream_ill_cond_first, i, r);
+        double e = (i == 0) ? round(b / 2) + 1. : round(to_unit(r[0], r[1]) * b / 2);
+        a[i] = (2. * to_unit(r[2], r[3]) - 1.) * pow2(int(e));
     }
 
-    // init the second half of the vector
+    // Second phase: the second half, with exponents growing from 0 to b / 2
     double step = (b / 2) / (n - n2);
-    for(int i = n2; i != n; ++i) {
-        double x = double(rand()) / double(RAND_MAX);
-        e[i] = step * (i - n2);
-        a[i] = (2. * x - 1.) * pow(2., e[i]); 
+    #pragma omp parallel for schedule(static)
+    for(int i = n2; i < n; ++i) {
+        uint32_t r[4];
+        philox(seed, stream_ill_cond_second, i, r);
+        a[i] = (2. * to_unit(r[0], r[1]) - 1.) * exp2(step * (i - n2));
     }
-
-    free(e);
 }
 
-void init_naive(const int n, double *a) {
-    for(int i = 0; i != n; ++i)
-        a[i] = (rand() % 4) - 2.1;
+void init_naive(const int n, double *a, const uint64_t seed) {
+    #pragma omp parallel for schedule(static)
+    for(int i = 0; i < n; ++i) {
+        uint32_t r[4];
+        philox(seed, stream_naive, i, r);
+        a[i] = (r[0] % 4) - 2.1;
+    }
 }
 
@@ -0,0 +1,177 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "common.hpp"
+
+
+static const char dataset_magic[8] = {'E', 'X', 'B', 'L', 'A', 'S', 'D', 'S'};
+static const uint32_t dataset_version = 1;
+
+// Header, then the data from the next huge page, in whole huge pages
+static uint64_t file_length(const __dataset_header &spec) {
+    uint64_t len = spec.data_offset + spec.n * sizeof(double);
+    return (len + dataset_alignment - 1) / dataset_alignment * dataset_alignment;
+}
+
+static std::string file_name(const char *dir, const __dataset_header &spec) {
+    static const char * names[] = {"naive", "fpuniform", "lognormal", "illcond", "uniform"};
+    char name[256];
+    snprintf(name, sizeof(name), "/%s-n%llu-%.17g-%.17g-s%llu.exds",
+        spec.distribution < 5 ? names[spec.distribution] : "unknown", (unsigned long long) spec.n,
+        spec.params[0], spec.params[1], (unsigned long long) spec.seed);
+    return std::string(dir) + name;
+}
+
+__dataset_header dataset_spec(const int distribution, const uint64_t n, const double p0, const double p1,
+    const uint64_t seed) {
+    __dataset_header spec;
+    memset(&spec, 0, sizeof(spec));
+    memcpy(spec.magic, dataset_magic, sizeof(spec.magic));
+    spec.version = dataset_version;
+    spec.distribution = distribution;
+    spec.n = n;
+    spec.seed = seed;
+    spec.params[0] = p0;
+    spec.params[1] = p1;
+    spec.data_offset = dataset_alignment;
+    return spec;
+}
+
+void dataset_generate(const __dataset_header &spec, double *a) {
+    int n = int(spec.n);
+    switch (spec.distribution) {
+        case dataset_naive:
+            init_naive(n, a, spec.seed);
+            break;
+        case dataset_fpuniform:
+            init_fpuniform(n, a, int(spec.params[0]), int(spec.params[1]), spec.seed);
+            break;
+        case dataset_lognormal:
+            init_lognormal(n, a, spec.params[0], spec.params[1], spec.seed);
+            break;
+        case dataset_ill_cond:
+            init_ill_cond(n, a, spec.params[0], spec.seed);
+            break;
+        case dataset_uniform:
+            #pragma omp parallel for schedule(static)
+            for(int i = 0; i < n; ++i)
+                a[i] = spec.params[0] * counter_uniform(spec.seed, i);
+            break;
+        default:
+            fprintf(stderr, "Unknown dataset distribution %u\n", spec.distribution);
+            break;
+    }
+}
+
+// True if the file of fd holds spec
+static bool matches(int fd, const __dataset_header &spec) {
+    __dataset_header header;
+    struct stat st;
+    if (pread(fd, &header, sizeof(header), 0) != sizeof(header) || fstat(fd, &st) != 0)
+        return false;
+    return memcmp(&header, &spec, sizeof(spec)) == 0 && uint64_t(st.st_size) >= file_length(spec);
+}
+
+// Generates the data straight into the file, through a shared mapping, so
+// that it works on hugetlbfs too. The file only appears once complete
+static bool write_file(const std::string &path, const __dataset_header &spec) {
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%d.tmp", int(getpid()));
+    std::string tmp = path + suffix;
+    int fd = open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+        return false;
+    uint64_t len = file_length(spec);
+    void *p = MAP_FAILED;
+    if (ftruncate(fd, len) == 0)
+        p = mmap(0, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    memcpy(p, &spec, sizeof(spec));
+    dataset_generate(spec, (double *) ((char *) p + spec.data_offset));
+    munmap(p, len);
+    return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+// Maps the file at an address aligned on dataset_alignment
+static char * map_file(int fd, uint64_t len) {
+    void *reserved = mmap(0, len + dataset_alignment, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (reserved == MAP_FAILED)
+        return 0;
+    char *base = (char *) (((uintptr_t) reserved + dataset_alignment - 1) & ~(uintptr_t) (dataset_alignment - 1));
+    void *p = mmap(base, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    if (p == MAP_FAILED) {
+        munmap(reserved, len + dataset_alignment);
+        return 0;
+    }
+    // Release the rest of the reservation
+    if (base != reserved)
+        munmap(reserved, base - (char *) reserved);
+    munmap(base + len, (char *) reserved + dataset_alignment - base);
+    return base;
+}
+
+double * dataset_open(const char *dir, const __dataset_header &spec) {
+    if (spec.n > uint64_t(INT_MAX)) {
+        fprintf(stderr, "Dataset of %llu elements is too large\n", (unsigned long long) spec.n);
+        return 0;
+    }
+    std::string path = file_name(dir, spec);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1 || !matches(fd, spec)) {
+        if (fd != -1)
+            close(fd);
+        if (!write_file(path, spec)) {
+            fprintf(stderr, "Cannot write dataset %s\n", path.c_str());
+            return 0;
+        }
+        fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1 || !matches(fd, spec)) {
+            fprintf(stderr, "Cannot read dataset %s\n", path.c_str());
+            if (fd != -1)
+                close(fd);
+            return 0;
+        }
+    }
+
+    uint64_t len = file_length(spec);
+    char *base = map_file(fd, len);
+    close(fd);
+    if (!base) {
+        fprintf(stderr, "Cannot map dataset %s\n", path.c_str());
+        return 0;
+    }
+    madvise(base, len, MADV_HUGEPAGE);
+    madvise(base, len, MADV_WILLNEED);
+
+    // Fault the pages in now rather than in the timed calls. Reads map the
+    // page cache, they do not copy it
+    double *a = (double *) (base + spec.data_offset);
+    const long stride = 4096 / sizeof(double);
+    long n = long(spec.n);
+    double sink = 0.;
+    #pragma omp parallel for schedule(static) reduction(+:sink)
+    for(long i = 0; i < n; i += stride)
+        sink += a[i];
+    volatile double keep = sink;
+    (void) keep;
+    return a;
+}
+
+void dataset_close(double *a, const __dataset_header &spec) {
+    if (a)
+        munmap((char *) a - spec.data_offset, file_length(spec));
+}
@@ -0,0 +1,314 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <vector>
+#include <atomic>
+
+#include "ExMOMENTS.hpp"
+#include "blas1.hpp"
+
+
+/*
+ * Accumulates the product x*y exactly, as two doubles
+ */
+static void AccumulateProduct(Superaccumulator & acc, double x, double y) {
+    double p = x * y;
+    double e = std::fma(x, y, -p);
+    if (p != 0)
+        acc.Accumulate(p);
+    if (e != 0)
+        acc.Accumulate(e);
+}
+
+/*
+ * Accumulates the product x*a*b exactly, as four doubles
+ */
+static void AccumulateProduct(Superaccumulator & acc, double x, double a, double b) {
+    double p = x * a;
+    double e = std::fma(x, a, -p);
+    AccumulateProduct(acc, p, b);
+    AccumulateProduct(acc, e, b);
+}
+
+/*
+ * Takes the value held by acc out as a sum of non-overlapping doubles, leading
+ * term first. The superaccumulator is left empty, unless its value is beyond
+ * the range of doubles
+ */
+static std::vector<double> Expansion(Superaccumulator & acc) {
+    std::vector<double> t;
+    for (;;) {
+        double v = acc.Round();
+        if (v == 0 || !std::isfinite(v))
+            break;
+        t.push_back(v);
+        acc.Accumulate(-v);
+    }
+    return t;
+}
+
+/*
+ * Sign of A - (q + h)*a*b, computed exactly. The products are accumulated in
+ * two halves, so that they do not overflow when A is close to the largest double
+ */
+static int CompareQuotient(Superaccumulator const & A, double q, double h, double a, double b) {
+    Superaccumulator r(A);
+    for (int i = 0; i != 2; ++i) {
+        AccumulateProduct(r, -q / 2, a, b);
+        AccumulateProduct(r, -h / 2, a, b);
+    }
+    double v = r.Round();
+    return (v > 0) - (v < 0);
+}
+
+static bool IsEven(double q) {
+    uint64_t bits;
+    memcpy(&bits, &q, sizeof(double));
+    return (bits & 1) == 0;
+}
+
+/*
+ * Signed distance from q to the next candidate towards dir: the next double, or
+ * the next multiple of g where doubles are closer than g. Beyond the largest
+ * double, the distance is the one below it
+ */
+static double Step(double q, double dir, double g) {
+    double next = std::nextafter(q, dir);
+    double d = std::isinf(next) ? q - std::nextafter(q, -dir) : next - q;
+    return (std::fabs(d) < g) ? std::copysign(g, d) : d;
+}
+
+/*
+ * Correctly rounded 2^s times the quotient of the exact value held by A by a*b,
+ * where a and b are positive integers below 2^53. The quotient of the rounded
+ * value of A is within a few units in the last place; it moves to the next
+ * candidate while the exact quotient lies beyond one of its midpoints.
+ * Dividends below 1 are scaled up first, exactly, so that the candidates and
+ * their midpoints are normal. Candidates are taken on the grid of the results
+ * that are subnormal once scaled by 2^s, so that those are rounded only once
+ */
+static double RoundQuotient(Superaccumulator & A, double a, double b, int s) {
+    double d = A.Round();
+    if (d == 0 || !std::isfinite(d))
+        return std::ldexp(d / a / b, s);
+
+    int k = std::max(0, -ilogb(d));
+    Superaccumulator S(A);
+    if (k != 0) {
+        std::vector<double> t = Expansion(S);
+        for (size_t i = 0; i != t.size(); ++i)
+            S.Accumulate(std::ldexp(t[i], k));
+    }
+    double q = std::ldexp(d, k) / a / b;
+
+    // The result is 2^(s - k) times the quotient of S
+    int e = ilogb(q) + s - k;
+    if (e < -1076)
+        return std::copysign(0.0, d);
+    if (e > 1024)
+        return std::copysign(std::numeric_limits<double>::infinity(), d);
+    double g = (k - s >= 0) ? std::ldexp(1.0, k - s - 1074) : 0.0;
+    if (g > 0 && ilogb(q) < ilogb(g) + 53)
+        q = std::nearbyint(q / g) * g;
+
+    double inf = std::numeric_limits<double>::infinity();
+    for (;;) {
+        if (!std::isfinite(q))
+            return q;
+        double hup = Step(q, inf, g) / 2;
+        double hdown = Step(q, -inf, g) / 2;
+        int cup = CompareQuotient(S, q, hup, a, b);
+        if (cup > 0) {
+            q += 2 * hup;
+            continue;
+        }
+        int cdown = CompareQuotient(S, q, hdown, a, b);
+        if (cdown < 0) {
+            q += 2 * hdown;
+            continue;
+        }
+        // Ties to even
+        double r = std::ldexp(q, s - k);
+        if (cup == 0)
+            return IsEven(r) ? r : std::ldexp(q + 2 * hup, s - k);
+        if (cdown == 0)
+            return IsEven(r) ? r : std::ldexp(q + 2 * hdown, s - k);
+        return r;
+    }
+}
+
+/*
+ * Correctly rounded 2^s (n*P - A*B) / (n*m), where P holds the exact sum of the
+ * products of the elements of two vectors, and A and B the exact sums of their
+ * elements. A is scaled by 2^-ta and B by 2^-tb before the products are formed,
+ * so that their trailing terms do not underflow; ta and tb are not positive,
+ * which keeps the scaling exact
+ */
+static double CenteredQuotient(Superaccumulator P, Superaccumulator A, Superaccumulator B, int ta, int tb, double n, double m, int s) {
+    std::vector<double> p = Expansion(P), a = Expansion(A), b = Expansion(B);
+    Superaccumulator D;
+    for (size_t i = 0; i != p.size(); ++i)
+        AccumulateProduct(D, std::ldexp(p[i], -(ta + tb)), n);
+    for (size_t i = 0; i != a.size(); ++i) {
+        for (size_t j = 0; j != b.size(); ++j)
+            AccumulateProduct(D, -std::ldexp(a[i], -ta), std::ldexp(b[j], -tb));
+    }
+    return RoundQuotient(D, n, m, ta + tb + s);
+}
+
+/*
+ * Half the exponent of the sum of squares held by acc, when it is below 1:
+ * scaling the elements by its opposite brings their sum of squares close to 1.
+ * Larger sums are not scaled down, which could drop their trailing bits
+ */
+static int HalfExponent(Superaccumulator & acc) {
+    double q = acc.Round();
+    return (q > 0) ? std::min(ilogb(q) / 2, 0) : 0;
+}
+
+/*
+ * Power of two that brings the largest magnitude m close to 1, as in exnrm2
+ */
+static int ScaleExponent(double m) {
+    return (m == 0) ? 0 : std::min(-ilogb(m), 1022);
+}
+
+/*
+ * Statistics of a real vector using our algorithm: the sum of its elements and
+ * the sum of their squares are accumulated exactly, in a single pass over x.
+ * When a square overflows, when the sum of squares is too large to be
+ * multiplied by the count, or when the squares are so small that they may have
+ * lost bits to subnormals, a second pass scales the vector by a power of two,
+ * as in exnrm2. Elements that are not finite propagate as in IEEE arithmetic
+ */
+__moments exmoments(int N, double *x, int inc, int ddof, int fpe, bool early_exit) {
+    if (fpe < 0) {
+        fprintf(stderr, "Size of floating-point expansion should be a positive number. Preferably, it should be in the interval [2, 8]\n");
+        exit(1);
+    }
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    __moments r = {0, 0.0, 0.0, nan, nan};
+    if (N < 1 || inc < 1)
+        return r;
+
+    double n = N, m = double(N) - ddof;
+    r.count = N;
+    std::atomic<bool> overflow(false);
+    std::vector<Superaccumulator> acc;
+    ExSUMRangesFPE(N, MomentsInput(x, inc, 1.0, &overflow), acc, fpe, early_exit);
+    r.sum = acc[0].Round();
+    r.sumsq = acc[1].Round();
+    r.mean = RoundQuotient(acc[0], n, 1.0, 0);
+
+    // Beyond huge, count*sumsq may overflow
+    int e = 0;
+    double tiny = std::ldexp(1.0, -860), huge = std::ldexp(1.0, 960);
+    if (overflow || r.sumsq >= huge || (r.sumsq != 0 && r.sumsq < tiny)) {
+        double mx = MaxAbs(N, x, inc);
+        if (mx != mx || std::isinf(mx)) {
+            double s = 0.0, s2 = 0.0;
+            #pragma omp parallel for reduction(+:s, s2)
+            for (int64_t i = 0; i < N; i++) {
+                double v = x[i * inc];
+                if (!std::isfinite(v))
+                    s += v;
+                if (!std::isfinite(v * v))
+                    s2 += v * v;
+            }
+            r.sum = s;
+            r.sumsq = s2;
+            r.mean = s / n;
+            return r;
+        }
+        e = ScaleExponent(mx);
+        overflow = false;
+        ExSUMRangesFPE(N, MomentsInput(x, inc, std::ldexp(1.0, e), &overflow), acc, fpe, early_exit);
+        r.sumsq = std::ldexp(acc[1].Round(), -2 * e);
+    }
+
+    if (m > 0) {
+        int t = HalfExponent(acc[1]);
+        r.variance = CenteredQuotient(acc[1], acc[0], acc[0], t, t, n, m, -2 * e);
+    }
+    return r;
+}
+
+/*
+ * Statistics of two real vectors using our algorithm: the sums of their
+ * elements, of their squares and of their products are accumulated exactly,
+ * in a single pass over x and y. Each vector is scaled on its own when a
+ * second pass is needed, as in exmoments
+ */
+__covariance excovariance(int N, double *x, int incx, double *y, int incy, int ddof, int fpe, bool early_exit) {
+    if (fpe < 0) {
+        fprintf(stderr, "Size of floating-point expansion should be a positive number. Preferably, it should be in the interval [2, 8]\n");
+        exit(1);
+    }
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    __covariance r = {0, 0.0, 0.0, 0.0, nan, nan, nan, nan, nan};
+    if (N < 1 || incx < 1 || incy < 1)
+        return r;
+
+    double n = N, m = double(N) - ddof;
+    r.count = N;
+    std::atomic<bool> overflow(false);
+    std::vector<Superaccumulator> acc;
+    ExSUMRangesFPE(N, CovarianceInput(x, incx, 1.0, y, incy, 1.0, &overflow), acc, fpe, early_exit);
+    r.sumx = acc[0].Round();
+    r.sumy = acc[1].Round();
+    r.sumxy = acc[4].Round();
+    r.meanx = RoundQuotient(acc[0], n, 1.0, 0);
+    r.meany = RoundQuotient(acc[1], n, 1.0, 0);
+
+    int ex = 0, ey = 0;
+    double qx = acc[2].Round(), qy = acc[3].Round();
+    double tiny = std::ldexp(1.0, -860), huge = std::ldexp(1.0, 960);
+    if (overflow || qx >= huge || qy >= huge || (qx != 0 && qx < tiny) || (qy != 0 && qy < tiny)) {
+        double mx = MaxAbs(N, x, incx), my = MaxAbs(N, y, incy);
+        if (mx != mx || std::isinf(mx) || my != my || std::isinf(my)) {
+            double sx = 0.0, sy = 0.0, sxy = 0.0;
+            #pragma omp parallel for reduction(+:sx, sy, sxy)
+            for (int64_t i = 0; i < N; i++) {
+                double u = x[i * incx], v = y[i * incy];
+                if (!std::isfinite(u))
+                    sx += u;
+                if (!std::isfinite(v))
+                    sy += v;
+                if (!std::isfinite(u * v))
+                    sxy += u * v;
+            }
+            if (!std::isfinite(mx)) {
+                r.sumx = sx;
+                r.meanx = sx / n;
+            }
+            if (!std::isfinite(my)) {
+                r.sumy = sy;
+                r.meany = sy / n;
+            }
+            r.sumxy = sxy;
+            return r;
+        }
+        ex = ScaleExponent(mx);
+        ey = ScaleExponent(my);
+        overflow = false;
+        ExSUMRangesFPE(N, CovarianceInput(x, incx, std::ldexp(1.0, ex), y, incy, std::ldexp(1.0, ey), &overflow), acc, fpe, early_exit);
+        r.sumxy = std::ldexp(acc[4].Round(), -(ex + ey));
+    }
+
+    if (m > 0) {
+        int tx = HalfExponent(acc[2]), ty = HalfExponent(acc[3]);
+        r.varx = CenteredQuotient(acc[2], acc[0], acc[0], tx, tx, n, m, -2 * ex);
+        r.vary = CenteredQuotient(acc[3], acc[1], acc[1], ty, ty, n, m, -2 * ey);
+        r.covariance = CenteredQuotient(acc[4], acc[0], acc[1], tx, ty, n, m, -(ex + ey));
+    }
+    return r;
+}
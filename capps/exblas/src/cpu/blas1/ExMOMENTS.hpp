@@ -0,0 +1,136 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas1/ExMOMENTS.hpp
+ *  \brief Provides the inputs of the statistics kernels, which accumulate
+ *         several sums in a single pass over the data
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+#ifndef EXMOMENTS_HPP_
+#define EXMOMENTS_HPP_
+
+#include <atomic>
+#include "superaccumulator.hpp"
+#include "ExSUM_FPE.hpp"
+#include "ExSUM_Fused.hpp"
+
+/**
+ * \struct MomentsInput
+ * \ingroup ExMOMENTS
+ * \brief Accumulates the elements of a vector and their exact squares, both
+ *  scaled by a power of two, into two superaccumulators. Each element is loaded
+ *  once and feeds one floating-point expansion per sum. Elements and squares
+ *  that are not finite are dropped and reported through overflow
+ */
+struct MomentsInput
+{
+    static const int sums = 2;      /**< sum, sum of squares */
+
+    double const *x;    /**< vector */
+    int inc;            /**< increment for the elements of x, positive */
+    double scale;       /**< power of two applied to the elements */
+    std::atomic<bool> * overflow; /**< set when an element or a square is not finite */
+
+    MomentsInput(double const *x, int inc, double scale, std::atomic<bool> * overflow) :
+        x(x), inc(inc), scale(scale), overflow(overflow) {}
+
+    /**
+     * Accumulates the elements [l, r) into acc[0] and their squares into acc[1]
+     */
+    template<typename CACHE> void AccumulateRange(Superaccumulator * acc, int64_t l, int64_t r) const {
+        CACHE sum(acc[0]), sumsq(acc[1]);
+        int64_t i;
+        for(i = l; i + 4 <= r; i += 4) {
+            Accumulate(sum, sumsq, LoadStrided(x, inc, i));
+        }
+        if(i < r) {
+            Accumulate(sum, sumsq, LoadPartialStrided(int(r - i), x, inc, i));
+        }
+        sum.Flush();
+        sumsq.Flush();
+    }
+
+private:
+    template<typename CACHE> void Accumulate(CACHE & sum, CACHE & sumsq, Vec4d v) const {
+        Vec4d e;
+        v = v * scale;
+        DropNonFinite(v, overflow);
+        Vec4d p = TwoProductFMA(v, v, e);
+        DropNonFinite(p, e, overflow);
+        sum.Accumulate(v);
+        sumsq.Accumulate(p, e);
+    }
+};
+
+/**
+ * \struct CovarianceInput
+ * \ingroup ExMOMENTS
+ * \brief Accumulates the elements of two vectors, their exact squares and
+ *  their exact products into five superaccumulators, in a single pass. Each
+ *  vector is scaled by its own power of two
+ */
+struct CovarianceInput
+{
+    static const int sums = 5;      /**< sums of x, y, x*x, y*y, x*y */
+
+    double const *x;    /**< first vector */
+    int incx;           /**< increment for the elements of x, positive */
+    double scalex;      /**< power of two applied to the elements of x */
+    double const *y;    /**< second vector */
+    int incy;           /**< increment for the elements of y, positive */
+    double scaley;      /**< power of two applied to the elements of y */
+    std::atomic<bool> * overflow; /**< set when an element or a product is not finite */
+
+    CovarianceInput(double const *x, int incx, double scalex, double const *y, int incy, double scaley, std::atomic<bool> * overflow) :
+        x(x), incx(incx), scalex(scalex), y(y), incy(incy), scaley(scaley), overflow(overflow) {}
+
+    /**
+     * Accumulates the sums of the elements [l, r) into acc[0] to acc[4]
+     */
+    template<typename CACHE> void AccumulateRange(Superaccumulator * acc, int64_t l, int64_t r) const {
+        CACHE sx(acc[0]), sy(acc[1]), sxx(acc[2]), syy(acc[3]), sxy(acc[4]);
+        int64_t i;
+        for(i = l; i + 4 <= r; i += 4) {
+            Vec4d a = LoadStrided(x, incx, i) * scalex;
+            Vec4d b = LoadStrided(y, incy, i) * scaley;
+            Accumulate(sx, sy, sxx, syy, sxy, a, b);
+        }
+        if(i < r) {
+            Vec4d a = LoadPartialStrided(int(r - i), x, incx, i) * scalex;
+            Vec4d b = LoadPartialStrided(int(r - i), y, incy, i) * scaley;
+            Accumulate(sx, sy, sxx, syy, sxy, a, b);
+        }
+        sx.Flush();
+        sy.Flush();
+        sxx.Flush();
+        syy.Flush();
+        sxy.Flush();
+    }
+
+private:
+    template<typename CACHE> void Accumulate(CACHE & sx, CACHE & sy, CACHE & sxx, CACHE & syy, CACHE & sxy, Vec4d a, Vec4d b) const {
+        Vec4d e;
+        DropNonFinite(a, overflow);
+        DropNonFinite(b, overflow);
+        sx.Accumulate(a);
+        sy.Accumulate(b);
+        Vec4d p = TwoProductFMA(a, a, e);
+        DropNonFinite(p, e, overflow);
+        sxx.Accumulate(p, e);
+        p = TwoProductFMA(b, b, e);
+        DropNonFinite(p, e, overflow);
+        syy.Accumulate(p, e);
+        p = TwoProductFMA(a, b, e);
+        DropNonFinite(p, e, overflow);
+        sxy.Accumulate(p, e);
+    }
+};
+
+#endif // EXMOMENTS_HPP_
@@ -137,6 +137,27 @@ __mts ExMTSSuperacc(int N, double *a) {
     return {dacc,dmts};
 }
 
+/**
+ * \brief Appends a segment of the vector to the segment preceding it
+ *
+ * \param acc1 superaccumulator of the first segment, updated
+ * \param mtsacc1 mts superaccumulator of the first segment, updated
+ * \param acc2 superaccumulator of the second segment
+ * \param mtsacc2 mts superaccumulator of the second segment
+ */
+inline static void JoinMTS(Superaccumulator & acc1, Superaccumulator & mtsacc1,
+                           Superaccumulator & acc2, Superaccumulator & mtsacc2)
+{
+    double mtsl, mtsr;
+    mtsr = mtsacc2.Round();
+    mtsacc1.Accumulate(acc2);
+    acc1.Accumulate(acc2);
+    mtsl = mtsacc1.Round();
+    if(mtsr > mtsl){
+        mtsacc1 = mtsacc2;
+    }
+}
+
 /**
  * \brief Parallel reduction step
  *
@@ -145,26 +166,18 @@ __mts ExMTSSuperacc(int N, double *a) {
  * \param tid2 id of the second thread
  * \param acc1 superaccumulator of the first thread
  * \param acc2 superaccumulator of the second thread
+ * \param mtsacc1 mts superaccumulator of the first thread
+ * \param mtsacc2 mts superaccumulator of the second thread
+ * \param ready2 ready flag of the second thread
  */
 inline static void ReductionStep(int step, int tid1, int tid2,
                                  Superaccumulator * acc1, Superaccumulator * acc2,
                                  Superaccumulator * mtsacc1, Superaccumulator * mtsacc2,
-                                 int volatile * ready1, int volatile * ready2)
+                                 ReadyFlag * ready2)
 {
-    _mm_prefetch((char const*)ready2, _MM_HINT_T0);
     // Wait for thread 2
-    while(*ready2 < step) {
-        // wait
-        _mm_pause();
-    }
-    double mtsl, mtsr;
-    mtsr = mtsacc2->Round();
-    mtsacc1->Accumulate(*acc2);
-    acc1->Accumulate(*acc2);
-    mtsl = mtsacc1->Round();
-    if(mtsr > mtsl){
-        *mtsacc1 = *mtsacc2;
-    }
+    ready2->Wait(step);
+    JoinMTS(*acc1, *mtsacc1, *acc2, *mtsacc2);
 }
 
 /**
@@ -172,35 +185,45 @@ inline static void ReductionStep(int step, int tid1, int tid2,
  *
  * \param tid thread ID
  * \param tnum number of threads
- * \param acc superaccumulator
+ * \param ws per-thread superaccumulators and ready flags
  */
-inline static void Reduction(unsigned int tid, unsigned int tnum, std::vector<int32_t>& ready,
-                             std::vector<Superaccumulator>& acc,
-                             std::vector<Superaccumulator>& mtsacc,
-                             int const linesize)
+inline static void Reduction(unsigned int tid, unsigned int tnum, Workspace & ws)
 {
     // Custom reduction
     for(unsigned int s = 1; (1 << (s-1)) < tnum; ++s)
     {
-        int32_t volatile * c = &ready[tid * linesize];
-        ++*c;
+        ws[tid].ready.Signal(s);
         if(tid % (1 << s) == 0) {
             unsigned int tid2 = tid | (1 << (s-1));
             if(tid2 < tnum) {
                 //acc[tid2].Prefetch(); // No effect...
                 ReductionStep(s, tid, tid2,
-                              &acc[tid], &acc[tid2],
-                              &mtsacc[tid], &mtsacc[tid2],
-                              &ready[tid * linesize],
-                              &ready[tid2 * linesize]);
+                              &ws[tid].acc, &ws[tid2].acc,
+                              &ws[tid].mtsacc, &ws[tid2].mtsacc,
+                              &ws[tid2].ready);
             }
         }
     }
 }
 
+/**
+ * \brief Accumulates the elements [l, r) of a real vector into the floating-point expansion
+ *
+ * \param cache floating-point expansion
+ * \param a vector
+ * \param l position of the first element
+ * \param r position past the last element
+ */
+template<typename CACHE> inline static void XAccumulateChunk(CACHE & cache, double *a, int64_t l, int64_t r)
+{
+    for(int64_t i = l; i < r; i++) {
+        asm ("# myloop");
+        cache.XAccumulate(a[i]);
+    }
+}
+
 template<typename CACHE> __mts ExMTSFPE(int N, double *a) {
     // OpenMP sum+reduction
-    int const linesize = 16;    // * sizeof(int32_t)
     int maxthreads = omp_get_max_threads(); // Force maxthreads
     double dacc, dmtsacc;
 #ifdef EXBLAS_TIMING
@@ -209,42 +232,81 @@ template<typename CACHE> __mts ExMTSFPE(int N, double *a) {
     for(int iter = 0; iter != iterations; ++iter) {
         tstart = rdtsc();
 #endif
-    std::vector<Superaccumulator> acc(maxthreads);
-    std::vector<Superaccumulator> mtsacc(maxthreads);
-    std::vector<int32_t> ready(maxthreads * linesize);
+    Workspace & ws = Workspace::Get(maxthreads);
+    ChunkScheduler & sched = ws.Scheduler();
+    std::vector<ChunkAccumulators*> * stolenacc = 0;
+    FPEStatsBegin();
 
 #pragma omp parallel
     {
         unsigned int tid = omp_get_thread_num();
         unsigned int tnum = omp_get_num_threads();
+        Superaccumulator & acc = ws[tid].acc;
+        Superaccumulator & mtsacc = ws[tid].mtsacc;
 
-        CACHE cache(acc[tid], mtsacc[tid]);
-        *(int32_t volatile *)(&ready[tid * linesize]) = 0;  // Race here, who cares?
+        // Implicit barrier of the single: all states are reset
+        // before any other thread reads them
+        ws[tid].Reset();
+#pragma omp single
+        {
+            sched.Reset(N, tnum, ChunkScheduler::DefaultChunkSize(N, tnum));
+            stolenacc = &ws.Chunks(sched.SliceEnd(tnum - 1));
+        }
 
-        int l = ((tid * int64_t(N)) / tnum) & ~7ul;
-        int r = ((((tid+1) * int64_t(N)) / tnum) & ~7ul) - 1;
+        // Our own chunks are contiguous, they share one expansion
+        {
+            CACHE cache(acc, mtsacc);
+            int64_t chunk;
+            while(sched.NextOwn(tid, chunk)) {
+                XAccumulateChunk(cache, a, sched.ChunkBegin(chunk), sched.ChunkEnd(chunk));
+            }
+            cache.Flush();
+        }
+        acc.Normalize();
+        mtsacc.Normalize();
+
+        // mts is order-dependent: each stolen chunk is kept apart
+        // until its owner appends it to its slice
+        unsigned int victim;
+        int64_t chunk;
+        while(sched.Steal(tid, victim, chunk)) {
+            ChunkAccumulators * & c = (*stolenacc)[chunk];
+            if(c) {
+                c->acc.Reset();
+                c->mtsacc.Reset();
+            } else {
+                c = new ChunkAccumulators;
+            }
+            {
+                CACHE cache(c->acc, c->mtsacc);
+                XAccumulateChunk(cache, a, sched.ChunkBegin(chunk), sched.ChunkEnd(chunk));
+                cache.Flush();
+            }
+            c->acc.Normalize();
+            c->mtsacc.Normalize();
+            ws[victim].stolen.Increment();
+        }
 
-        for(int i = l; i < r; i++) {
-            asm ("# myloop");
-            cache.XAccumulate(a[i]);
+        int64_t ownend = sched.OwnEnd(tid);
+        ws[tid].stolen.Wait(int32_t(sched.SliceEnd(tid) - ownend));
+        for(int64_t c = ownend; c != sched.SliceEnd(tid); ++c) {
+            JoinMTS(acc, mtsacc, (*stolenacc)[c]->acc, (*stolenacc)[c]->mtsacc);
         }
-        cache.Flush();
-        acc[tid].Normalize();
-        mtsacc[tid].Normalize();
 
-        Reduction(tid, tnum, ready, acc, mtsacc, linesize);
+        Reduction(tid, tnum, ws);
     }
+    FPEStatsEnd();
 #ifdef EXBLAS_MPI
-    acc[0].Normalize();
-        std::vector<int64_t> result(acc[0].get_f_words() + acc[0].get_e_words(), 0);
-        MPI_Reduce(&(acc[0].get_accumulator()[0]), &(result[0]), acc[0].get_f_words() + acc[0].get_e_words(), MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+    ws[0].acc.Normalize();
+        std::vector<int64_t> result(ws[0].acc.get_f_words() + ws[0].acc.get_e_words(), 0);
+        MPI_Reduce(&(ws[0].acc.get_accumulator()[0]), &(result[0]), ws[0].acc.get_f_words() + ws[0].acc.get_e_words(), MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
         //MPI_Reduce((int64_t *) &acc[0].accumulator[0], (int64_t *) &acc_fin.accumulator[0], get_f_words() + get_e_words(), MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
 
         Superaccumulator acc_fin(result);
         dacc = acc_fin.Round();
 #else
-    dacc = acc[0].Round();
-    dmtsacc = mtsacc[0].Round();
+    dacc = ws[0].acc.Round();
+    dmtsacc = ws[0].mtsacc.Round();
 #endif
 
 #ifdef EXBLAS_TIMING
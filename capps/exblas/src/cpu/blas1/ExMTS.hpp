@@ -18,6 +18,8 @@
 
 #include "superaccumulator.hpp"
 #include "ExMTS_FPE.hpp"
+#include "readyflag.hpp"
+#include "workspace.hpp"
 #define TBB_PREVIEW_DETERMINISTIC_REDUCE 1
 #include <tbb/blocked_range.h>
 #include <tbb/parallel_reduce.h>
@@ -16,6 +16,7 @@
 #define EXMTS_FPE_HPP_
 
 #include "superaccumulator.hpp"
+#include "FPEStats.hpp"
 
 
 struct dmts {
@@ -80,6 +81,7 @@ private:
 
     Superaccumulator & sum_superacc;
     Superaccumulator & mts_superacc;
+    __fpe_stats * stats;
 
     // Most significant digits first!
     // Store the sum
@@ -95,6 +97,7 @@ template<int N, typename TRAITS>
 FPExpansionVectM1<N,TRAITS>::FPExpansionVectM1(Superaccumulator & sa, Superaccumulator & sa2) :
     sum_superacc(sa),
     mts_superacc(sa2),
+    stats(FPEStatsOwn()),
     victim(0.)
 {
     std::fill(sum, sum + N, 0);
@@ -121,6 +124,7 @@ void FPExpansionVectM1<N,TRAITS>::XAccumulate(double x)
     double _sum = 0.;
     double _mts = 0.;
     y = x;
+    unsigned int depth = N;
     for(unsigned int i = 0; i != N; ++i) {
 
         sum[i] = twosum(sum[i], x, s1);
@@ -131,7 +135,10 @@ void FPExpansionVectM1<N,TRAITS>::XAccumulate(double x)
         _mts += mtsbuf[i];
         y = s2;
 
-        if(TRAITS::EarlyExit && i != 0 && x == 0 && y == 0) break;
+        if(TRAITS::EarlyExit && i != 0 && x == 0 && y == 0) {
+            depth = i + 1;
+            break;
+        }
     }
 // This could be optimized a lot...
     if(_mts > 0.) {
@@ -147,6 +154,14 @@ void FPExpansionVectM1<N,TRAITS>::XAccumulate(double x)
     if(x != 0) sum_superacc.Accumulate(x);
 
     if(y != 0) mts_superacc.Accumulate(y);
+
+#ifdef EXBLAS_FPE_COUNTERS
+    if(unlikely(stats != 0)) {
+        ++stats->inputs;
+        ++stats->depth[depth];
+        stats->flushes += (x != 0) + (y != 0);
+    }
+#endif
 }
 
 
@@ -7,8 +7,16 @@
 #include <cstdlib>
 #include <cstdio>
 #include <iostream>
+#include <cmath>
+#include <limits>
+#include <atomic>
 
 #include "ExSUM.hpp"
+#include "ExSUM_Fused.hpp"
+#include "ExSUM_Tuning.hpp"
+#include "ExSUM_XSUM.hpp"
+#include "ExSUM_ExactSum.hpp"
+#include "Profile.hpp"
 #include "blas1.hpp"
 
 #ifdef EXBLAS_TIMING
@@ -31,7 +39,7 @@ double exsum(int Ng, double *ag, int inca, int offset, int fpe, bool early_exit)
     int nthread = tbb::task_scheduler_init::automatic;
     tbb::task_scheduler_init tbbinit(nthread);
 
-    if (fpe < 0) {
+    if (fpe < 0 && fpe != fpe_auto && fpe != fpe_xsum_large && fpe != fpe_online_exact && fpe != fpe_ifastsum) {
         fprintf(stderr, "Size of floating-point expansion should be a positive number. Preferably, it should be in the interval [2, 8]\n");
         exit(1);
     }
@@ -67,10 +75,32 @@ double exsum(int Ng, double *ag, int inca, int offset, int fpe, bool early_exit)
     a = ag;
 #endif
 
+    if (fpe == fpe_auto)
+        return (ExSUMFPE<FPExpansionAuto>)(N, a, inca, offset);
+
+    // with Neal's large accumulators
+    if (fpe == fpe_xsum_large)
+        return ExSUMXsumLarge(N, a, inca, offset);
+
+    // with Zhu's accumulators, or his iFastSum on a copy of the vector
+    if (fpe == fpe_online_exact)
+        return ExSUMOnlineExact(N, a, inca, offset);
+    if (fpe == fpe_ifastsum)
+        return ExSUMiFastSum(N, a, inca, offset);
+
     // with superaccumulators only
     if (fpe < 2)
         return ExSUMSuperacc(N, a, inca, offset);
 
+    // early-exit expansions come in sizes 4, 6 and 8 only
+    if (early_exit && fpe <= 8)
+        fpe = (fpe <= 4) ? 4 : (fpe <= 6) ? 6 : 8;
+
+    // traits measured to be the fastest on this machine, if tuned
+    ExSUMVariant const * tuned = ExSUMTunedVariant(fpe, early_exit);
+    if (tuned)
+        return tuned->run(N, a, inca, offset);
+
     if (early_exit) {
         if (fpe <= 4)
             return (ExSUMFPE<FPExpansionVect<Vec4d, 4, FPExpansionTraits<true> > >)(N, a, inca, offset);
@@ -110,8 +140,8 @@ double ExSUMSuperacc(int N, double *a, int inca, int offset) {
     	tstart = rdtsc();
 #endif
 
-        TBBlongsum tbbsum(a);
-        tbb::parallel_reduce(tbb::blocked_range<size_t>(0, N, inca), tbbsum);
+        TBBlongsum tbbsum(a + offset, inca);
+        tbb::parallel_reduce(tbb::blocked_range<size_t>(0, N), tbbsum);
 #ifdef EXBLAS_MPI
         tbbsum.acc.Normalize();
         std::vector<int64_t> result(tbbsum.acc.get_f_words() + tbbsum.acc.get_e_words(), 0);
@@ -143,16 +173,13 @@ double ExSUMSuperacc(int N, double *a, int inca, int offset) {
  * \param tid2 id of the second thread
  * \param acc1 superaccumulator of the first thread
  * \param acc2 superaccumulator of the second thread
+ * \param ready2 ready flag of the second thread
  */
 inline static void ReductionStep(int step, int tid1, int tid2, Superaccumulator * acc1, Superaccumulator * acc2,
-    int volatile * ready1, int volatile * ready2)
+    ReadyFlag * ready2)
 {
-    _mm_prefetch((char const*)ready2, _MM_HINT_T0);
     // Wait for thread 2
-    while(*ready2 < step) {
-        // wait
-        _mm_pause();
-    }
+    ready2->Wait(step);
     acc1->Accumulate(*acc2);
 }
 
@@ -161,31 +188,180 @@ inline static void ReductionStep(int step, int tid1, int tid2, Superaccumulator
  *
  * \param tid thread ID
  * \param tnum number of threads
- * \param acc superaccumulator
+ * \param ws per-thread superaccumulators and ready flags
  */
-inline static void Reduction(unsigned int tid, unsigned int tnum, std::vector<int32_t>& ready,
-    std::vector<Superaccumulator>& acc, int const linesize)
+inline static void Reduction(unsigned int tid, unsigned int tnum, Workspace & ws)
 {
     // Custom reduction
     for(unsigned int s = 1; (1 << (s-1)) < tnum; ++s) 
     {
-        int32_t volatile * c = &ready[tid * linesize];
-        ++*c;
+        ws[tid].ready.Signal(s);
         if(tid % (1 << s) == 0) {
             unsigned int tid2 = tid | (1 << (s-1));
             if(tid2 < tnum) {
                 //acc[tid2].Prefetch(); // No effect...
-                ReductionStep(s, tid, tid2, &acc[tid], &acc[tid2],
-                    &ready[tid * linesize], &ready[tid2 * linesize]);
+                ReductionStep(s, tid, tid2, &ws[tid].acc, &ws[tid2].acc, &ws[tid2].ready);
+            }
+        }
+    }
+}
+
+/**
+ * \brief Accumulates the elements [l, r) of a real vector into the floating-point expansion
+ *
+ * \param cache floating-point expansion
+ * \param a vector, aligned on 32 bytes
+ * \param l position of the first element, a multiple of 8
+ * \param r position past the last element
+ */
+template<typename CACHE> inline static void AccumulateChunk(CACHE & cache, double *a, int64_t l, int64_t r)
+{
+    int64_t i;
+    for(i = l; i + 8 <= r; i += 8) {
+        asm ("# myloop");
+        cache.Accumulate(Vec4d().load_a(a + i), Vec4d().load_a(a + i + 4));
+    }
+    if(i + 4 <= r) {
+        cache.Accumulate(Vec4d().load_a(a + i));
+        i += 4;
+    }
+    if(i < r) {
+        cache.Accumulate(Vec4d().load_partial(int(r - i), a + i));
+    }
+}
+
+/**
+ * \brief Accumulates the elements [l, r) produced by input into the adaptive
+ *  expansion, one window at a time, at the level it currently selects
+ */
+template<typename INPUT> inline static void AccumulateAuto(FPExpansionAuto & cache, INPUT const & input, int64_t l, int64_t r)
+{
+    for(int64_t w = l; w < r; w += FPExpansionAuto::window) {
+        int64_t e = std::min(r, w + FPExpansionAuto::window);
+        uint64_t flushes = cache.FlushCount();
+        switch(cache.Level()) {
+        case 0:
+            input.AccumulateChunk(cache.Short(), w, e);
+            break;
+        case 1:
+            input.AccumulateChunk(cache.Long(), w, e);
+            break;
+        default:
+            for(int64_t i = w; i != e; ++i) {
+                cache.Superacc().Accumulate(input.Term(i));
+            }
+        }
+        cache.Update(e - w, cache.FlushCount() - flushes);
+    }
+}
+
+/*
+ * Elements of a real vector, as accumulated by exsum
+ */
+struct SumInput
+{
+    double *a;
+
+    SumInput(double *a) : a(a) {}
+
+    double Term(int64_t i) const {
+        return a[i];
+    }
+
+    template<typename CACHE> void AccumulateChunk(CACHE & cache, int64_t l, int64_t r) const {
+        ::AccumulateChunk(cache, a, l, r);
+    }
+
+    void AccumulateChunk(FPExpansionAuto & cache, int64_t l, int64_t r) const {
+        AccumulateAuto(cache, *this, l, r);
+    }
+};
+
+/*
+ * Elements of a real vector with an increment, or not aligned on 32 bytes
+ */
+struct StridedSumInput
+{
+    double const *a;
+    int inc;
+
+    StridedSumInput(double const *a, int inc) : a(a), inc(inc) {}
+
+    double Term(int64_t i) const {
+        return a[i * inc];
+    }
+
+    template<typename CACHE> void AccumulateChunk(CACHE & cache, int64_t l, int64_t r) const {
+        int64_t i;
+        for(i = l; i + 8 <= r; i += 8) {
+            cache.Accumulate(LoadStrided(a, inc, i), LoadStrided(a, inc, i + 4));
+        }
+        if(i + 4 <= r) {
+            cache.Accumulate(LoadStrided(a, inc, i));
+            i += 4;
+        }
+        if(i < r) {
+            cache.Accumulate(LoadPartialStrided(int(r - i), a, inc, i));
+        }
+    }
+
+    void AccumulateChunk(FPExpansionAuto & cache, int64_t l, int64_t r) const {
+        AccumulateAuto(cache, *this, l, r);
+    }
+};
+
+/**
+ * \brief Accumulates the N elements produced by input into the per-thread
+ *  superaccumulators and reduces them among threads
+ *
+ * \param N number of elements
+ * \param input provides AccumulateChunk(cache, l, r) for the elements [l, r)
+ * \return superaccumulator holding the exact sum, valid until the next call
+ */
+template<typename CACHE, typename INPUT> static Superaccumulator & ExSUMReduce(int64_t N, INPUT const & input) {
+    int maxthreads = omp_get_max_threads();
+    Workspace & ws = Workspace::Get(maxthreads);
+    ChunkScheduler & sched = ws.Scheduler();
+    FPEStatsBegin();
+
+    #pragma omp parallel
+    {
+        unsigned int tid = omp_get_thread_num();
+        unsigned int tnum = omp_get_num_threads();
+        Superaccumulator & acc = ws[tid].acc;
+
+        // Implicit barrier of the single: all states are reset
+        // before the reduction tree reads any of them
+        ws[tid].Reset();
+        #pragma omp single
+        sched.Reset(N, tnum, ChunkScheduler::DefaultChunkSize(N, tnum));
+
+        // The superaccumulator makes the result independent of which
+        // thread gets which chunk
+        CACHE cache(acc);
+        {
+            ProfileScope phase(exprofile_accumulate);
+            int64_t chunk;
+            while(sched.Next(tid, chunk)) {
+                input.AccumulateChunk(cache, sched.ChunkBegin(chunk), sched.ChunkEnd(chunk));
             }
+            cache.Flush();
+        }
+        {
+            ProfileScope phase(exprofile_normalize);
+            acc.Normalize();
+        }
+        {
+            ProfileScope phase(exprofile_reduction);
+            Reduction(tid, tnum, ws);
         }
     }
+    FPEStatsEnd();
+    return ws[0].acc;
 }
 
 template<typename CACHE> double ExSUMFPE(int N, double *a, int inca, int offset) {
     // OpenMP sum+reduction
-    int const linesize = 16;    // * sizeof(int32_t)
-    int maxthreads = omp_get_max_threads();
     double dacc;
 #ifdef EXBLAS_TIMING
     double t, mint = 10000;
@@ -193,39 +369,22 @@ template<typename CACHE> double ExSUMFPE(int N, double *a, int inca, int offset)
     for(int iter = 0; iter != iterations; ++iter) {
         tstart = rdtsc();
 #endif
-        std::vector<Superaccumulator> acc(maxthreads);
-        std::vector<int32_t> ready(maxthreads * linesize);
-    
-        #pragma omp parallel
-        {
-            unsigned int tid = omp_get_thread_num();
-            unsigned int tnum = omp_get_num_threads();
-
-            CACHE cache(acc[tid]);
-            *(int32_t volatile *)(&ready[tid * linesize]) = 0;  // Race here, who cares?
-
-            int l = ((tid * int64_t(N)) / tnum) & ~7ul;
-            int r = ((((tid+1) * int64_t(N)) / tnum) & ~7ul) - 1;
-
-            for(int i = l; i < r; i+=8) {
-                asm ("# myloop");
-                cache.Accumulate(Vec4d().load_a(a + i), Vec4d().load_a(a + i + 4));
-            }
-            cache.Flush();
-            acc[tid].Normalize();
-
-            Reduction(tid, tnum, ready, acc, linesize);
-        }
+        // The aligned loads need a contiguous vector on 32 bytes
+        a += offset;
+        Superaccumulator & acc = (inca == 1 && uintptr_t(a) % 32 == 0) ?
+            ExSUMReduce<CACHE>(N, SumInput(a)) : ExSUMReduce<CACHE>(N, StridedSumInput(a, inca));
 #ifdef EXBLAS_MPI
-        acc[0].Normalize();
-        std::vector<int64_t> result(acc[0].get_f_words() + acc[0].get_e_words(), 0);
-        MPI_Reduce(&(acc[0].get_accumulator()[0]), &(result[0]), acc[0].get_f_words() + acc[0].get_e_words(), MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+        acc.Normalize();
+        std::vector<int64_t> result(acc.get_f_words() + acc.get_e_words(), 0);
+        MPI_Reduce(&(acc.get_accumulator()[0]), &(result[0]), acc.get_f_words() + acc.get_e_words(), MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
         //MPI_Reduce((int64_t *) &acc[0].accumulator[0], (int64_t *) &acc_fin.accumulator[0], get_f_words() + get_e_words(), MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
 
         Superaccumulator acc_fin(result);
+        ProfileScope phase(exprofile_round);
         dacc = acc_fin.Round();
 #else
-        dacc = acc[0].Round();
+        ProfileScope phase(exprofile_round);
+        dacc = acc.Round();
 #endif    
 
 #ifdef EXBLAS_TIMING
@@ -239,3 +398,153 @@ template<typename CACHE> double ExSUMFPE(int N, double *a, int inca, int offset)
     return dacc;
 }
 
+/*
+ * Exact sum of the elements produced by input, with the same choice of
+ * floating-point expansion as exsum: superaccumulators only if fpe < 2
+ */
+template<typename INPUT> static Superaccumulator & ExSUMFusedFPE(int64_t N, INPUT const & input, int fpe, bool early_exit) {
+    if (fpe < 2)
+        return ExSUMReduce<SuperaccOnly>(N, input);
+
+    if (early_exit) {
+        if (fpe <= 4)
+            return ExSUMReduce<FPExpansionVect<Vec4d, 4, FPExpansionTraits<true> > >(N, input);
+        if (fpe <= 6)
+            return ExSUMReduce<FPExpansionVect<Vec4d, 6, FPExpansionTraits<true> > >(N, input);
+        return ExSUMReduce<FPExpansionVect<Vec4d, 8, FPExpansionTraits<true> > >(N, input);
+    }
+    switch (fpe) {
+    case 2:
+        return ExSUMReduce<FPExpansionVect<Vec4d, 2> >(N, input);
+    case 3:
+        return ExSUMReduce<FPExpansionVect<Vec4d, 3> >(N, input);
+    case 4:
+        return ExSUMReduce<FPExpansionVect<Vec4d, 4> >(N, input);
+    case 5:
+        return ExSUMReduce<FPExpansionVect<Vec4d, 5> >(N, input);
+    case 6:
+        return ExSUMReduce<FPExpansionVect<Vec4d, 6> >(N, input);
+    case 7:
+        return ExSUMReduce<FPExpansionVect<Vec4d, 7> >(N, input);
+    default:
+        return ExSUMReduce<FPExpansionVect<Vec4d, 8> >(N, input);
+    }
+}
+
+/*
+ * Sum of absolute values using our algorithm, in a single pass over x
+ */
+double exasum(int N, double *x, int inc, int fpe, bool early_exit) {
+    if (fpe < 0) {
+        fprintf(stderr, "Size of floating-point expansion should be a positive number. Preferably, it should be in the interval [2, 8]\n");
+        exit(1);
+    }
+    if (N < 1 || inc < 1)
+        return 0.0;
+
+    std::atomic<bool> overflow(false);
+    AbsInput input(x, inc, &overflow);
+    double s = ExSUMFusedFPE(N, input, fpe, early_exit).Round();
+    if (overflow)
+        return NonFiniteSum(N, input);
+    return s;
+}
+
+/*
+ * Weighted sum using our algorithm: the products w[i]*x[i] are accumulated
+ * exactly, in a single pass over w and x
+ */
+double exwsum(int N, double *w, int incw, double *x, int incx, int fpe, bool early_exit) {
+    if (fpe < 0) {
+        fprintf(stderr, "Size of floating-point expansion should be a positive number. Preferably, it should be in the interval [2, 8]\n");
+        exit(1);
+    }
+    if (N < 1 || incw < 1 || incx < 1)
+        return 0.0;
+
+    std::atomic<bool> overflow(false);
+    ProductInput input(w, incw, x, incx, &overflow);
+    double s = ExSUMFusedFPE(N, input, fpe, early_exit).Round();
+    if (overflow)
+        return NonFiniteSum(N, input);
+    return s;
+}
+
+/*
+ * Euclidean norm using our algorithm: the squares are accumulated exactly,
+ * their sum is rounded once and its square root is correctly rounded.
+ * When a square overflows, or when the rounded sum of squares is so small that
+ * the squares may have lost bits to subnormals, a second pass scales the
+ * vector by a power of two that brings its largest element close to 1
+ */
+double exnrm2(int N, double *x, int inc, int fpe, bool early_exit) {
+    if (fpe < 0) {
+        fprintf(stderr, "Size of floating-point expansion should be a positive number. Preferably, it should be in the interval [2, 8]\n");
+        exit(1);
+    }
+    if (N < 1 || inc < 1)
+        return 0.0;
+
+    std::atomic<bool> overflow(false);
+    double s = ExSUMFusedFPE(N, SquareInput(x, inc, 1.0, &overflow), fpe, early_exit).Round();
+    if (!overflow && s >= std::ldexp(1.0, -860))
+        return std::sqrt(s);
+
+    double m = MaxAbs(N, x, inc);
+    if (m != m || std::isinf(m) || m == 0.0)
+        return m;
+    // 2^1022 is enough for subnormals: the smallest one becomes 2^-52
+    int e = std::min(-ilogb(m), 1022);
+    overflow = false;
+    s = ExSUMFusedFPE(N, SquareInput(x, inc, std::ldexp(1.0, e), &overflow), fpe, early_exit).Round();
+    return std::ldexp(std::sqrt(s), -e);
+}
+
+
+/*
+ * Grid of instantiations benchmarked by the tuner. Biased2Sum is left to its
+ * default, since twosum ignores it when FMA is available
+ */
+static std::string VariantName(int fpe, bool ee, bool flushhi, bool h2sum, bool crf, bool cswap, bool sort, bool vict) {
+    std::string name = "fpe" + std::to_string(fpe);
+    if (ee) name += "-ee";
+    if (flushhi) name += "-flushhi";
+    if (h2sum) name += "-h2sum";
+    if (crf) name += "-crf";
+    if (cswap) name += "-cswap";
+    if (sort) name += "-sort";
+    if (vict) name += "-vict";
+    return name;
+}
+
+template<int N, bool EX, bool FLUSHHI, bool H2SUM, bool CRF, bool CSWAP, bool SORT, bool VICT>
+static ExSUMVariant MakeVariant() {
+    typedef FPExpansionTraits<EX, FLUSHHI, H2SUM, CRF, CSWAP, true, SORT, VICT> TRAITS;
+    ExSUMVariant v = {
+        VariantName(N, EX, FLUSHHI, H2SUM, CRF, CSWAP, SORT, VICT), N, EX,
+        ExSUMFPE<FPExpansionVect<Vec4d, N, TRAITS> >
+    };
+    return v;
+}
+
+#define EXSUM_TRAITS_GRID(N, EX) \
+    MakeVariant<N, EX, false, false, false, false, false, false>(), \
+    MakeVariant<N, EX, false, false, true,  false, false, false>(), \
+    MakeVariant<N, EX, true,  false, false, false, false, false>(), \
+    MakeVariant<N, EX, true,  false, true,  false, false, false>(), \
+    MakeVariant<N, EX, true,  false, false, true,  false, false>(), \
+    MakeVariant<N, EX, true,  false, false, false, true,  false>(), \
+    MakeVariant<N, EX, false, true,  false, false, false, false>(), \
+    MakeVariant<N, EX, false, true,  false, false, false, true >()
+
+std::vector<ExSUMVariant> const & ExSUMVariants() {
+    static std::vector<ExSUMVariant> const variants = {
+        EXSUM_TRAITS_GRID(2, false),
+        EXSUM_TRAITS_GRID(4, false),
+        EXSUM_TRAITS_GRID(8, false),
+        EXSUM_TRAITS_GRID(4, true),
+        EXSUM_TRAITS_GRID(6, true),
+        EXSUM_TRAITS_GRID(8, true)
+    };
+    return variants;
+}
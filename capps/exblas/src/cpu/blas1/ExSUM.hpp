@@ -18,6 +18,9 @@
 
 #include "superaccumulator.hpp"
 #include "ExSUM_FPE.hpp"
+#include "ExSUM_FPEAuto.hpp"
+#include "readyflag.hpp"
+#include "workspace.hpp"
 #define TBB_PREVIEW_DETERMINISTIC_REDUCE 1
 #include <tbb/blocked_range.h>
 #include <tbb/parallel_reduce.h>
@@ -38,6 +41,7 @@
  */
 class TBBlongsum {
     double* a; /**< a real vector to sum */
+    int inc;   /**< increment for the elements of a */
 public:
     Superaccumulator acc; /**< supperaccumulator */
 
@@ -46,15 +50,15 @@ public:
      * superaccumulator
      */
     void operator()(tbb::blocked_range<size_t> const & r) {
-        for(size_t i = r.begin(); i != r.end(); i += r.grainsize()) 
-            acc.Accumulate(a[i]);
+        for(size_t i = r.begin(); i != r.end(); ++i)
+            acc.Accumulate(a[int64_t(i) * inc]);
     }
 
     /** 
      * Construction that uses another object of TBBlongsum for initialization
      * \param x a TBBlongsum instance
      */
-    TBBlongsum(TBBlongsum & x, tbb::split) : a(x.a), acc(e_bits, f_bits) {}
+    TBBlongsum(TBBlongsum & x, tbb::split) : a(x.a), inc(x.inc), acc(e_bits, f_bits) {}
 
     /** 
      * Joins two superaccumulators of two different instances
@@ -65,9 +69,10 @@ public:
     /** 
      * Construction that initiates a real vector to sum and a supperacccumulator
      * \param a a real vector
+     * \param inc increment for the elements of a
      */
-    TBBlongsum(double a[]) :
-        a(a), acc(e_bits, f_bits)
+    TBBlongsum(double a[], int inc = 1) :
+        a(a), inc(inc), acc(e_bits, f_bits)
     {}
 };
 
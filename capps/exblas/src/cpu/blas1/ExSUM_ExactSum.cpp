@@ -0,0 +1,125 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <vector>
+#include <stdint.h>
+#include <omp.h>
+
+#ifdef EXBLAS_MPI
+    #include <mpi.h>
+#endif
+
+#include "ExSUM_ExactSum.hpp"
+
+
+/*
+ * Zhu's OnlineExactSum, one object per thread. Each thread adds an equal range
+ * of the vector to the accumulators of its own object. The accumulators hold
+ * exact sums, so that merging them in a fixed order and rounding once gives a
+ * result that does not depend on the number of threads
+ */
+double ExSUMOnlineExact(int N, double *a, int inca, int offset) {
+    int maxthreads = omp_get_max_threads();
+    std::vector<ExactSum *> part(maxthreads, (ExactSum *) 0);
+    a += offset;
+
+    #pragma omp parallel
+    {
+        unsigned int tid = omp_get_thread_num();
+        unsigned int tnum = omp_get_num_threads();
+        int64_t l = int64_t(N) * tid / tnum, r = int64_t(N) * (tid + 1) / tnum;
+
+        // Allocated by its thread, so that its pages are local
+        ExactSum * own = new ExactSum();
+        if (inca == 1) {
+            // AddArray reads its array from [1], so that the first element
+            // is added alone rather than reading before the vector
+            if (r > l)
+                own->AddNumber(a[l]);
+            if (r > l + 1)
+                own->AddArray(a + l, int(r - l - 1));
+        } else {
+            for (int64_t i = l; i < r; i++)
+                own->AddNumber(a[i * inca]);
+        }
+        part[tid] = own;
+    }
+
+    ExactSum acc;
+    for (int t = 0; t != maxthreads; ++t) {
+        if (part[t]) {
+            acc.AddSum(*part[t]);
+            delete part[t];
+        }
+    }
+
+#ifdef EXBLAS_MPI
+    int np = 1, p;
+    MPI_Comm_rank(MPI_COMM_WORLD, &p);
+    MPI_Comm_size(MPI_COMM_WORLD, &np);
+    // The non-zero accumulators of each process, padded with zeros
+    std::vector<double> own(N2_EXPONENT + 1, .0);
+    acc.GetAccumulators(&own[0]);
+    std::vector<double> all(p == 0 ? np * N2_EXPONENT : 1);
+    MPI_Gather(&own[1], N2_EXPONENT, MPI_DOUBLE, &all[0], N2_EXPONENT, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (p == 0) {
+        acc.Reset();
+        acc.AddNumber(all[0]);
+        acc.AddArray(&all[0], np * N2_EXPONENT - 1);
+    } else {
+        // Only the first process holds the sum, as with superaccumulators
+        return 0.0;
+    }
+#endif
+
+    return acc.GetSum();
+}
+
+/*
+ * Zhu's iFastSum, which sums an array it overwrites. The elements are copied
+ * to a scratch arena first, which also gathers strided elements
+ */
+double ExSUMiFastSum(int N, double *a, int inca, int offset) {
+    a += offset;
+    int n = N;
+
+#ifdef EXBLAS_MPI
+    // iFastSum returns a rounded sum only: the processes send their elements
+    // to the first one, which sums all of them
+    int np = 1, p;
+    MPI_Comm_rank(MPI_COMM_WORLD, &p);
+    MPI_Comm_size(MPI_COMM_WORLD, &np);
+    std::vector<double> own(N);
+    for (int i = 0; i < N; i++)
+        own[i] = a[int64_t(i) * inca];
+    std::vector<int> counts(np), displs(np);
+    MPI_Gather(&N, 1, MPI_INT, &counts[0], 1, MPI_INT, 0, MPI_COMM_WORLD);
+    n = 0;
+    for (int i = 0; i < np; i++) {
+        displs[i] = n;
+        n += counts[i];
+    }
+    std::vector<double> all(p == 0 ? n + 1 : 1);
+    MPI_Gatherv(own.empty() ? 0 : &own[0], N, MPI_DOUBLE, &all[0], &counts[0], &displs[0], MPI_DOUBLE, 0, MPI_COMM_WORLD);
+    if (p != 0)
+        return 0.0;
+    a = &all[0];
+    inca = 1;
+#endif
+
+    if (n < 1)
+        return 0.0;
+
+    // iFastSum stores its errors from [1], and its last partial sum at [n + 1]
+    std::vector<double> arena(int64_t(n) + 2);
+    ExactSum es;
+    if (inca == 1)
+        return es.iFastSum(a, n, &arena[0]);
+    for (int64_t i = 0; i < n; i++)
+        arena[i + 1] = a[i * inca];
+    return es.iFastSum(&arena[0], n);
+}
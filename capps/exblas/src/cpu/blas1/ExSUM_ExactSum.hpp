@@ -0,0 +1,48 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas1/ExSUM_ExactSum.hpp
+ *  \brief Provides the summation backends built on OnlineExactSum and iFastSum,
+ *         by Yong-Kang Zhu, from capps/xsum_slacc
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+#ifndef EXSUM_EXACTSUM_HPP_
+#define EXSUM_EXACTSUM_HPP_
+
+#include "ExactSum.h"
+
+/**
+ * \ingroup ExSUM
+ * \brief Parallel summation with the accumulators of OnlineExactSum, one
+ *  object per thread. The accumulators of the threads are merged exactly, and
+ *  their sum is rounded once with iFastSum
+ *
+ * \param N vector size
+ * \param a vector
+ * \param inca specifies the increment for the elements of a
+ * \param offset specifies position in the vector to start with 
+ * \return Contains the reproducible and accurate sum of elements of a real vector
+ */
+double ExSUMOnlineExact(int N, double *a, int inca, int offset);
+
+/**
+ * \ingroup ExSUM
+ * \brief Sequential summation with iFastSum, over a copy of the vector in a
+ *  scratch arena, so that the vector does not change
+ *
+ * \param N vector size
+ * \param a vector
+ * \param inca specifies the increment for the elements of a
+ * \param offset specifies position in the vector to start with 
+ * \return Contains the reproducible and accurate sum of elements of a real vector
+ */
+double ExSUMiFastSum(int N, double *a, int inca, int offset);
+
+#endif // EXSUM_EXACTSUM_HPP_
@@ -0,0 +1,238 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include <stdint.h>
+#include <omp.h>
+
+#include "ExSUM_Fused.hpp"
+#include "blas1.hpp"
+
+
+/*
+ * IEEE half precision: 1 sign bit, 5 exponent bits, 10 fraction bits.
+ * Conversions use F16C when the compiler targets it
+ */
+struct Half
+{
+    static float ToFloat(uint16_t h) {
+        int e = (h >> 10) & 0x1f, m = h & 0x3ff;
+        float v;
+        if (e == 0)
+            v = std::ldexp(float(m), -24);
+        else if (e == 0x1f)
+            v = m ? std::numeric_limits<float>::quiet_NaN() : std::numeric_limits<float>::infinity();
+        else
+            v = std::ldexp(float(m | 0x400), e - 25);
+        return (h & 0x8000) ? -v : v;
+    }
+
+    static Vec8f Load(uint16_t const *p) {
+#ifdef __F16C__
+        return _mm256_cvtph_ps(_mm_loadu_si128((__m128i const *)p));
+#else
+        return Vec8f(ToFloat(p[0]), ToFloat(p[1]), ToFloat(p[2]), ToFloat(p[3]),
+            ToFloat(p[4]), ToFloat(p[5]), ToFloat(p[6]), ToFloat(p[7]));
+#endif
+    }
+};
+
+/*
+ * bfloat16: the upper half of a float. AVX-512 BF16 only converts towards
+ * bfloat16; the other way is a shift
+ */
+struct BFloat16
+{
+    static float ToFloat(uint16_t h) {
+        uint32_t bits = uint32_t(h) << 16;
+        float v;
+        memcpy(&v, &bits, sizeof(float));
+        return v;
+    }
+
+    static Vec8f Load(uint16_t const *p) {
+#ifdef __AVX2__
+        __m256i w = _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i const *)p));
+        return _mm256_castsi256_ps(_mm256_slli_epi32(w, 16));
+#else
+        return Vec8f(ToFloat(p[0]), ToFloat(p[1]), ToFloat(p[2]), ToFloat(p[3]),
+            ToFloat(p[4]), ToFloat(p[5]), ToFloat(p[6]), ToFloat(p[7]));
+#endif
+    }
+};
+
+/*
+ * Loads the elements i to i+n-1 of a 16-bit vector with increment inc,
+ * n <= 8, as floats, and sets the remaining lanes to zero
+ */
+template<typename FORMAT>
+static inline Vec8f LoadStrided16(uint16_t const *x, int inc, int64_t i, int n = 8) {
+    if (inc == 1 && n == 8)
+        return FORMAT::Load(x + i);
+    uint16_t v[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    for (int j = 0; j != n; ++j)
+        v[j] = x[(i + j) * inc];
+    return FORMAT::Load(v);
+}
+
+/*
+ * Elements of a 16-bit floating-point vector, converted to float and then to
+ * double in registers, which is exact, for the expansions and the
+ * superaccumulators sized for floats
+ */
+template<typename FORMAT>
+struct Float16Input
+{
+    static const int sums = 1;
+
+    uint16_t const *x;
+    int inc;
+    std::atomic<bool> * overflow;
+
+    Float16Input(uint16_t const *x, int inc, std::atomic<bool> * overflow) :
+        x(x), inc(inc), overflow(overflow) {}
+
+    template<typename CACHE> void AccumulateRange(Superaccumulator * acc, int64_t l, int64_t r) const {
+        CACHE cache(acc[0]);
+        int64_t i;
+        for (i = l; i + 8 <= r; i += 8)
+            AccumulateWidened(cache, LoadStrided16<FORMAT>(x, inc, i), overflow);
+        if (i < r)
+            AccumulateWidened(cache, LoadStrided16<FORMAT>(x, inc, i, int(r - i)), overflow);
+        cache.Flush();
+    }
+
+    double Term(int64_t i) const {
+        return FORMAT::ToFloat(x[i * inc]);
+    }
+};
+
+/*
+ * Half-precision numbers are multiples of 2^-24 below 2^16. A double holds
+ * any multiple of 2^-24 below 2^29 exactly, hence the exact sum of 2^13 of
+ * them: each lane of the fixed-point accumulator adds that many elements
+ * with plain additions before it moves to a 128-bit integer in units of
+ * 2^-24, which no sum of 2^31 elements can overflow
+ */
+static const int64_t HalfLaneTerms = 1 << 13;
+
+typedef __int128 HalfFixed;
+
+/*
+ * Moves the lanes of s into acc and clears them. Lanes that are not finite
+ * are dropped and reported through overflow
+ */
+static inline void FlushHalfLanes(Vec4d * s, int n, HalfFixed & acc, std::atomic<bool> * overflow) {
+    for (int k = 0; k != n; ++k) {
+        DropNonFinite(s[k], overflow);
+        double v[4];
+        (s[k] * std::ldexp(1.0, 24)).store(v);
+        for (int j = 0; j != 4; ++j)
+            acc += int64_t(v[j]);
+        s[k] = Vec4d(0.);
+    }
+}
+
+/*
+ * Exact sum of a half-precision vector with the fixed-point accumulator.
+ * Each thread sums an equal range of elements into its own integer; integer
+ * addition is associative, so that the result does not depend on the number
+ * of threads. The final conversion to double is correctly rounded
+ */
+static double HalfFixedSum(int64_t N, uint16_t const *x, int inc, std::atomic<bool> * overflow) {
+    int maxthreads = omp_get_max_threads();
+    std::vector<HalfFixed> part(maxthreads, 0);
+
+    #pragma omp parallel
+    {
+        unsigned int tid = omp_get_thread_num();
+        unsigned int tnum = omp_get_num_threads();
+        int64_t l = N * tid / tnum, r = N * (tid + 1) / tnum;
+        HalfFixed own = 0;
+        // Four independent chains of additions hide their latency
+        Vec4d s[4] = {Vec4d(0.), Vec4d(0.), Vec4d(0.), Vec4d(0.)};
+        int64_t i = l;
+        while (i < r) {
+            int64_t end = std::min(r, i + 16 * HalfLaneTerms);
+            for (; i + 16 <= end; i += 16) {
+                Vec8f a = LoadStrided16<Half>(x, inc, i);
+                Vec8f b = LoadStrided16<Half>(x, inc, i + 8);
+                s[0] += extend_low(a);
+                s[1] += extend_high(a);
+                s[2] += extend_low(b);
+                s[3] += extend_high(b);
+            }
+            for (; i < end; i += 8) {
+                Vec8f a = LoadStrided16<Half>(x, inc, i, int(std::min<int64_t>(8, end - i)));
+                s[0] += extend_low(a);
+                s[1] += extend_high(a);
+            }
+            FlushHalfLanes(s, 4, own, overflow);
+        }
+        part[tid] = own;
+    }
+
+    HalfFixed acc = 0;
+    for (int t = 0; t != maxthreads; ++t)
+        acc += part[t];
+    return std::ldexp(double(acc), -24);
+}
+
+
+/*
+ * Sum of a half-precision vector using our algorithm, correctly rounded to
+ * double. With fpe < 2, the fixed-point accumulator takes the place of the
+ * superaccumulators, and needs no expansion
+ */
+double exsum_f16(int Ng, uint16_t *ag, int inca, int offset, int fpe, bool early_exit) {
+    if (Ng < 1 || inca < 1)
+        return 0.0;
+
+    std::atomic<bool> overflow(false);
+    Float16Input<Half> input(ag + offset, inca, &overflow);
+    // The backends selected by fpe < 0 take doubles, which hold the elements exactly
+    if (fpe < 0)
+        return WidenedSum(Ng, input, fpe, early_exit);
+    double s;
+    if (fpe < 2) {
+        s = HalfFixedSum(Ng, ag + offset, inca, &overflow);
+    } else {
+        std::vector<Superaccumulator> acc;
+        ExSUMRangesFPE(Ng, input, acc, fpe, early_exit, FloatSuperaccumulator());
+        s = acc[0].Round();
+    }
+    if (overflow)
+        return NonFiniteSum(Ng, input);
+    return s;
+}
+
+/*
+ * Sum of a bfloat16 vector using our algorithm, correctly rounded to double.
+ * bfloat16 spans the range of floats, so that it shares the superaccumulators
+ * of exsum_f32
+ */
+double exsum_bf16(int Ng, uint16_t *ag, int inca, int offset, int fpe, bool early_exit) {
+    if (Ng < 1 || inca < 1)
+        return 0.0;
+
+    std::atomic<bool> overflow(false);
+    Float16Input<BFloat16> input(ag + offset, inca, &overflow);
+    // The backends selected by fpe < 0 take doubles, which hold the elements exactly
+    if (fpe < 0)
+        return WidenedSum(Ng, input, fpe, early_exit);
+    std::vector<Superaccumulator> acc;
+    ExSUMRangesFPE(Ng, input, acc, fpe, early_exit, FloatSuperaccumulator());
+    if (overflow)
+        return NonFiniteSum(Ng, input);
+    return acc[0].Round();
+}
@@ -0,0 +1,160 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <cmath>
+#include <vector>
+#include <atomic>
+
+#include "ExSUM_Fused.hpp"
+#include "blas1.hpp"
+
+
+/*
+ * Superaccumulator sized for the products of two floats, which are multiples
+ * of 2^-298 below 2^256, with room for the carries of up to 2^31 terms
+ */
+static Superaccumulator FloatProductSuperacc() {
+    return Superaccumulator(256 + 32, 298);
+}
+
+/*
+ * Loads the elements i to i+7 of a single-precision vector with increment inc
+ */
+static inline Vec8f LoadStridedF32(float const *x, int inc, int64_t i) {
+    if (inc == 1)
+        return Vec8f().load(x + i);
+    return Vec8f(x[i * inc], x[(i + 1) * inc], x[(i + 2) * inc], x[(i + 3) * inc],
+        x[(i + 4) * inc], x[(i + 5) * inc], x[(i + 6) * inc], x[(i + 7) * inc]);
+}
+
+/*
+ * Loads the elements i to i+n-1, n < 8, and sets the remaining lanes to zero
+ */
+static inline Vec8f LoadPartialStridedF32(int n, float const *x, int inc, int64_t i) {
+    if (inc == 1)
+        return Vec8f().load_partial(n, x + i);
+    float v[8] = {0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.f};
+    for (int j = 0; j != n; ++j)
+        v[j] = x[(i + j) * inc];
+    return Vec8f().load(v);
+}
+
+/*
+ * Elements of a single-precision vector, widened to double in registers: the
+ * conversion is exact, so that the expansions and superaccumulators of exsum
+ * apply unchanged. Elements that are not finite are dropped and reported
+ * through overflow
+ */
+struct FloatSumInput
+{
+    static const int sums = 1;
+
+    float const *x;
+    int inc;
+    std::atomic<bool> * overflow;
+
+    FloatSumInput(float const *x, int inc, std::atomic<bool> * overflow) :
+        x(x), inc(inc), overflow(overflow) {}
+
+    template<typename CACHE> void AccumulateRange(Superaccumulator * acc, int64_t l, int64_t r) const {
+        CACHE cache(acc[0]);
+        int64_t i;
+        for (i = l; i + 8 <= r; i += 8)
+            AccumulateWidened(cache, LoadStridedF32(x, inc, i), overflow);
+        if (i < r)
+            AccumulateWidened(cache, LoadPartialStridedF32(int(r - i), x, inc, i), overflow);
+        cache.Flush();
+    }
+
+    double Term(int64_t i) const {
+        return x[i * inc];
+    }
+};
+
+/*
+ * Products of the elements of two single-precision vectors. Both factors are
+ * widened to double, whose 53 bits hold the 48 bits of their product: each
+ * product is exact and enters the expansion as a single double
+ */
+struct FloatProductInput
+{
+    static const int sums = 1;
+
+    float const *a;
+    int inca;
+    float const *b;
+    int incb;
+    std::atomic<bool> * overflow;
+
+    FloatProductInput(float const *a, int inca, float const *b, int incb, std::atomic<bool> * overflow) :
+        a(a), inca(inca), b(b), incb(incb), overflow(overflow) {}
+
+    template<typename CACHE> void AccumulateRange(Superaccumulator * acc, int64_t l, int64_t r) const {
+        CACHE cache(acc[0]);
+        int64_t i;
+        for (i = l; i + 8 <= r; i += 8)
+            Accumulate(cache, LoadStridedF32(a, inca, i), LoadStridedF32(b, incb, i));
+        if (i < r)
+            Accumulate(cache, LoadPartialStridedF32(int(r - i), a, inca, i), LoadPartialStridedF32(int(r - i), b, incb, i));
+        cache.Flush();
+    }
+
+    double Term(int64_t i) const {
+        return double(a[i * inca]) * double(b[i * incb]);
+    }
+
+private:
+    template<typename CACHE> void Accumulate(CACHE & cache, Vec8f u, Vec8f v) const {
+        Vec4d lo = extend_low(u) * extend_low(v);
+        Vec4d hi = extend_high(u) * extend_high(v);
+        DropNonFinite(lo, overflow);
+        DropNonFinite(hi, overflow);
+        cache.Accumulate(lo, hi);
+    }
+};
+
+
+/*
+ * Sum of a single-precision vector using our algorithm, correctly rounded to
+ * double. The superaccumulators span the range of floats only
+ */
+double exsum_f32(int Ng, float *ag, int inca, int offset, int fpe, bool early_exit) {
+    if (Ng < 1 || inca < 1)
+        return 0.0;
+
+    std::atomic<bool> overflow(false);
+    FloatSumInput input(ag + offset, inca, &overflow);
+    // The backends selected by fpe < 0 take doubles, which hold the elements exactly
+    if (fpe < 0)
+        return WidenedSum(Ng, input, fpe, early_exit);
+    std::vector<Superaccumulator> acc;
+    ExSUMRangesFPE(Ng, input, acc, fpe, early_exit, FloatSuperaccumulator());
+    if (overflow)
+        return NonFiniteSum(Ng, input);
+    return acc[0].Round();
+}
+
+/*
+ * Dot product of two single-precision vectors using our algorithm, correctly
+ * rounded to double. The products are exact in double precision
+ */
+double exdot_f32(int Ng, float *ag, int inca, int offseta, float *bg, int incb, int offsetb, int fpe, bool early_exit) {
+    if (Ng < 1 || inca < 1 || incb < 1)
+        return 0.0;
+
+    std::atomic<bool> overflow(false);
+    FloatProductInput input(ag + offseta, inca, bg + offsetb, incb, &overflow);
+    // The backends selected by fpe < 0 take doubles, which hold the products exactly
+    if (fpe < 0)
+        return WidenedSum(Ng, input, fpe, early_exit);
+    std::vector<Superaccumulator> acc;
+    ExSUMRangesFPE(Ng, input, acc, fpe, early_exit, FloatProductSuperacc());
+    if (overflow)
+        return NonFiniteSum(Ng, input);
+    return acc[0].Round();
+}
@@ -15,6 +15,9 @@
 #ifndef EXSUM_FPE_HPP_
 #define EXSUM_FPE_HPP_
 
+#include "Profile.hpp"
+#include "FPEStats.hpp"
+
 /**
  * \struct FPExpansionTraits
  * \ingroup ExSUM
@@ -70,6 +73,11 @@ struct FPExpansionVect
      * This function is meant to be used for printing the floating-point expansion
      */
     void Dump() const;
+
+    /**
+     * Returns the number of vectors flushed to the superaccumulator so far
+     */
+    uint64_t FlushCount() const { return flushes; }
 private:
     void FlushVector(T x) const;
     void DumpVector(T x) const;
@@ -77,22 +85,38 @@ private:
     void Insert(T & x1, T & x2);
     static void Swap(T & x1, T & x2);
     static T twosum(T a, T b, T & s);
+    void Count(unsigned int depth, int n) const;
 
     Superaccumulator & superacc;
+    __fpe_stats * stats;
 
     // Most significant digits first!
     T a[N] __attribute__((aligned(32)));
     T victim;
+    mutable uint64_t flushes;
 };
 
 template<typename T, int N, typename TRAITS>
 FPExpansionVect<T,N,TRAITS>::FPExpansionVect(Superaccumulator & sa) :
     superacc(sa),
-    victim(0)
+    stats(FPEStatsOwn()),
+    victim(0),
+    flushes(0)
 {
     std::fill(a, a + N, 0);
 }
 
+template<typename T, int N, typename TRAITS> inline
+void FPExpansionVect<T,N,TRAITS>::Count(unsigned int depth, int n) const
+{
+#ifdef EXBLAS_FPE_COUNTERS
+    if(unlikely(stats != 0)) {
+        stats->inputs += n;
+        stats->depth[depth] += n;
+    }
+#endif
+}
+
 // Knuth 2Sum.
 template<typename T>
 inline static T Knuth2Sum(T a, T b, T & s)
@@ -124,12 +148,12 @@ inline static T BiasedSIMD2Sum(T a, T b, T & s)
 }
 
 #if INSTRSET > 7                       // AVX2 and later
-Vec4d fma(Vec4d a, Vec4d b, Vec4d c)
+inline static Vec4d fma(Vec4d a, Vec4d b, Vec4d c)
 {
     return Vec4d(_mm256_fmadd_pd(a, b, c));
 }
 
-Vec4d fms(Vec4d a, Vec4d b, Vec4d c)
+inline static Vec4d fms(Vec4d a, Vec4d b, Vec4d c)
 {
     return Vec4d(_mm256_fmsub_pd(a, b, c));
 }
@@ -146,11 +170,35 @@ inline static T FMA2Sum(T a, T b, T & s)
 }
 #endif
 
+/**
+ * \ingroup ExSUM
+ * \brief Exact product: returns a*b rounded and sets d to the rounding error
+ */
+inline static Vec4d TwoProductFMA(Vec4d a, Vec4d b, Vec4d & d)
+{
+    Vec4d p = a * b;
+#if INSTRSET > 7                       // AVX2 and later
+    d = fms(a, b, p);
+#else
+    // Dekker's product with Veltkamp splitting
+    Vec4d const factor = 134217729.;   // 2^27 + 1
+    Vec4d ah = factor * a;
+    ah = ah - (ah - a);
+    Vec4d al = a - ah;
+    Vec4d bh = factor * b;
+    bh = bh - (bh - b);
+    Vec4d bl = b - bh;
+    d = ((ah * bh - p) + ah * bl + al * bh) + al * bl;
+#endif
+    return p;
+}
+
 template<typename T, int N, typename TRAITS> UNROLL_ATTRIBUTE
 void FPExpansionVect<T,N,TRAITS>::Accumulate(T x)
 {
     // Experimental
     if(TRAITS::CheckRangeFirst && horizontal_or(abs(x) < abs(a[N-1]))) {
+        Count(0, 1);
         FlushVector(x);
         return;
     }
@@ -158,8 +206,12 @@ void FPExpansionVect<T,N,TRAITS>::Accumulate(T x)
     for(unsigned int i = 0; i != N; ++i) {
         a[i] = twosum(a[i], x, s);
         x = s;
-        if(TRAITS::EarlyExit && i != 0 && !horizontal_or(x)) return;
+        if(TRAITS::EarlyExit && i != 0 && !horizontal_or(x)) {
+            Count(i + 1, 1);
+            return;
+        }
     }
+    Count(N, 1);
     if(TRAITS::EarlyExit || horizontal_or(x)) {
         FlushVector(x);
     }
@@ -313,7 +365,7 @@ void FPExpansionVect<T,N,TRAITS>::Insert(T & x1, T & x2)
 
 
 
-template<typename T, int N, typename TRAITS> UNROLL_ATTRIBUTE INLINE_ATTRIBUTE
+template<typename T, int N, typename TRAITS> inline UNROLL_ATTRIBUTE INLINE_ATTRIBUTE
 void FPExpansionVect<T,N,TRAITS>::Accumulate(T x1, T x2)
 {
     if(TRAITS::CheckRangeFirst) {
@@ -339,8 +391,12 @@ void FPExpansionVect<T,N,TRAITS>::Accumulate(T x1, T x2)
         //a[i] = ai;
         x1 = s1;
         x2 = s2;
-        if(TRAITS::EarlyExit && i != 0 && !horizontal_or(x1|x2)) return;
+        if(TRAITS::EarlyExit && i != 0 && !horizontal_or(x1|x2)) {
+            Count(i + 1, 2);
+            return;
+        }
     }
+    Count(N, 2);
 
     
     if(TRAITS::EarlyExit || (TRAITS::Horz2Sum && !TRAITS::Victimcache)) {
@@ -407,8 +463,15 @@ void FPExpansionVect<T,N,TRAITS>::FlushVector(T x) const
 {
     // TODO: update status, handle Inf/Overflow/NaN cases
     // TODO: make it work for other values of 4
+#ifdef EXBLAS_FPE_COUNTERS
+    ProfileScope phase(exprofile_flush);
+    if(unlikely(stats != 0)) {
+        ++stats->flushes;
+    }
+#endif
     double v[4];
     x.store(v);
+    ++flushes;
     
     _mm256_zeroupper();
     for(unsigned int j = 0; j != 4; ++j) {
@@ -0,0 +1,136 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas1/ExSUM_FPEAuto.hpp
+ *  \brief Provides a floating-point expansion that adapts its size to the data
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+#ifndef EXSUM_FPEAUTO_HPP_
+#define EXSUM_FPEAUTO_HPP_
+
+#include "superaccumulator.hpp"
+#include "ExSUM_FPE.hpp"
+#include <algorithm>
+
+/**
+ * \struct FPExpansionAuto
+ * \ingroup ExSUM
+ * \brief Set of floating-point expansions among which the kernel is chosen
+ *  along the vector, from the rate of flushes to the superaccumulator.
+ *
+ *  The vector is processed in windows. Data of close magnitudes rarely leave an
+ *  expansion of size 4 with early-exit. When a window flushes more often, the
+ *  next ones use an expansion of size 8; when nearly every input reaches the
+ *  superaccumulator anyway, they skip the expansion. All levels share the same
+ *  superaccumulator, hence the result stays exact and reproducible.
+ */
+struct FPExpansionAuto
+{
+    typedef FPExpansionVect<Vec4d, 4, FPExpansionTraits<true> > ShortFPE;
+    typedef FPExpansionVect<Vec4d, 8, FPExpansionTraits<true> > LongFPE;
+
+    static const int window = 4096;     /**< number of inputs between two decisions, a multiple of 8 */
+
+    /**
+     * Constructor
+     * \param sa superaccumulator
+     */
+    FPExpansionAuto(Superaccumulator & sa);
+
+    /**
+     * Returns the kernel for the next window: 0 for ShortFPE, 1 for LongFPE,
+     * 2 for the superaccumulator only
+     */
+    int Level() const { return level; }
+
+    ShortFPE & Short() { return fpe4; }
+    LongFPE & Long() { return fpe8; }
+    Superaccumulator & Superacc() { return superacc; }
+
+    /**
+     * Returns the number of vectors flushed to the superaccumulator so far
+     */
+    uint64_t FlushCount() const { return fpe4.FlushCount() + fpe8.FlushCount(); }
+
+    /**
+     * Chooses the kernel of the next window
+     * \param n number of inputs of the last window
+     * \param flushes number of vectors flushed during the last window
+     */
+    void Update(int64_t n, uint64_t flushes);
+
+    /**
+     * This function is used to flush the floating-point expansions to the superaccumulator
+     */
+    void Flush();
+
+private:
+    static const int hold_windows = 8;      // Windows before trying a cheaper level again
+    static const int max_hold_windows = 512;
+
+    Superaccumulator & superacc;
+    ShortFPE fpe4;
+    LongFPE fpe8;
+    int level;
+    int hold;
+    int backoff;    // Hold after the next growth, doubled when a shrink is undone at once
+    bool shrunk;    // The last window was the first one after a shrink
+};
+
+inline FPExpansionAuto::FPExpansionAuto(Superaccumulator & sa) :
+    superacc(sa), fpe4(sa), fpe8(sa), level(0), hold(0), backoff(hold_windows), shrunk(false)
+{
+}
+
+inline void FPExpansionAuto::Update(int64_t n, uint64_t flushes)
+{
+    if(hold > 0) {
+        --hold;
+    }
+    // Each flush sends 4 values to the superaccumulator
+    int64_t flushed = 4 * int64_t(flushes);
+    bool grow = false;
+    switch(level) {
+    case 0:
+        grow = flushed * 16 > n;
+        break;
+    case 1:
+        grow = flushed * 2 > n;
+        break;
+    default:
+        // Nothing to measure here: probe the expansion again from time to time
+        if(hold == 0) {
+            level = 1;
+            shrunk = true;
+        }
+        return;
+    }
+    if(grow) {
+        // Data that defeat the cheaper level as soon as it is tried again
+        // would otherwise pay for a bad window every hold_windows
+        backoff = shrunk ? std::min(2 * backoff, int(max_hold_windows)) : int(hold_windows);
+        level++;
+        hold = backoff;
+        shrunk = false;
+    } else if(level == 1 && flushed * 64 < n && hold == 0) {
+        level = 0;
+        shrunk = true;
+    } else {
+        shrunk = false;
+    }
+}
+
+inline void FPExpansionAuto::Flush()
+{
+    fpe4.Flush();
+    fpe8.Flush();
+}
+
+#endif // EXSUM_FPEAUTO_HPP_
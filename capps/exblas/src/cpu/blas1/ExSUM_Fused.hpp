@@ -0,0 +1,428 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas1/ExSUM_Fused.hpp
+ *  \brief Provides the inputs of the summation kernels that transform the
+ *         elements of a vector on the fly before accumulating them
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+#ifndef EXSUM_FUSED_HPP_
+#define EXSUM_FUSED_HPP_
+
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <vector>
+#include <omp.h>
+#include "superaccumulator.hpp"
+#include "ExSUM_FPE.hpp"
+#include "blas1.hpp"
+
+/**
+ * \struct SuperaccOnly
+ * \ingroup ExSUM
+ * \brief Accumulates vectors straight into the superaccumulator, with the
+ *  interface of FPExpansionVect, so that fpe < 2 shares the driver of the
+ *  floating-point expansions
+ */
+struct SuperaccOnly
+{
+    SuperaccOnly(Superaccumulator & sa) : superacc(sa) {}
+
+    void Accumulate(Vec4d x) {
+        double v[4] __attribute__((aligned(32)));
+        x.store_a(v);
+
+        // The lanes are read back from memory: kept in registers, they may
+        // land in ymm16-31, which vzeroupper leaves dirty, and the SSE code
+        // of the superaccumulator then pays a transition penalty
+        _mm256_zeroupper();
+        for(int j = 0; j != 4; ++j) {
+            double vj = static_cast<double volatile *>(v)[j];
+            if(vj != 0) {
+                superacc.Accumulate(vj);
+            }
+        }
+    }
+
+    void Accumulate(Vec4d x1, Vec4d x2) {
+        Accumulate(x1);
+        Accumulate(x2);
+    }
+
+    void Flush() {}
+
+private:
+    Superaccumulator & superacc;
+};
+
+/**
+ * \ingroup ExSUM
+ * \brief Loads the elements i to i+3 of a vector with increment inc
+ */
+inline static Vec4d LoadStrided(double const *x, int inc, int64_t i)
+{
+    if(inc == 1) {
+        return Vec4d().load(x + i);
+    }
+    return Vec4d(x[i * inc], x[(i + 1) * inc], x[(i + 2) * inc], x[(i + 3) * inc]);
+}
+
+/**
+ * \ingroup ExSUM
+ * \brief Loads the elements i to i+n-1 of a vector with increment inc, n < 4,
+ *  and sets the remaining lanes to zero
+ */
+inline static Vec4d LoadPartialStrided(int n, double const *x, int inc, int64_t i)
+{
+    if(inc == 1) {
+        return Vec4d().load_partial(n, x + i);
+    }
+    double v[4] = {0., 0., 0., 0.};
+    for(int j = 0; j != n; ++j) {
+        v[j] = x[(i + j) * inc];
+    }
+    return Vec4d().load(v);
+}
+
+/**
+ * \ingroup ExSUM
+ * \brief Clears the lanes of x where x is not finite, and sets overflow if
+ *  there are any, as the superaccumulator only holds finite values
+ */
+inline static void DropNonFinite(Vec4d & x, std::atomic<bool> * overflow)
+{
+    Vec4db finite = is_finite(x);
+    if(!horizontal_and(finite)) {
+        overflow->store(true, std::memory_order_relaxed);
+        x = select(finite, x, 0);
+    }
+}
+
+/**
+ * \ingroup ExSUM
+ * \brief Clears the lanes of a product p and its error e where p is not finite
+ */
+inline static void DropNonFinite(Vec4d & p, Vec4d & e, std::atomic<bool> * overflow)
+{
+    Vec4db finite = is_finite(p);
+    if(!horizontal_and(finite)) {
+        overflow->store(true, std::memory_order_relaxed);
+        p = select(finite, p, 0);
+        e = select(finite, e, 0);
+    }
+}
+
+/**
+ * \ingroup ExSUM
+ * \brief Widens eight floats to double, which is exact, and accumulates them.
+ *  Elements that are not finite are dropped and reported through overflow
+ */
+template<typename CACHE> inline static void AccumulateWidened(CACHE & cache, Vec8f v, std::atomic<bool> * overflow)
+{
+    Vec4d lo = extend_low(v), hi = extend_high(v);
+    DropNonFinite(lo, overflow);
+    DropNonFinite(hi, overflow);
+    cache.Accumulate(lo, hi);
+}
+
+/**
+ * \ingroup ExSUM
+ * \brief Returns an empty superaccumulator sized for the sums of floats, which
+ *  are multiples of 2^-149 below 2^128: six words instead of 39. The words
+ *  above the largest float hold the carries of up to 2^31 terms
+ */
+inline static Superaccumulator FloatSuperaccumulator()
+{
+    return Superaccumulator(128, 149);
+}
+
+/**
+ * \ingroup ExSUM
+ * \brief Returns the largest magnitude among the N elements of x, NaN if any
+ *  of them is NaN
+ */
+inline static double MaxAbs(int64_t N, double const *x, int inc)
+{
+    double m = 0.0;
+    bool nan = false;
+    #pragma omp parallel for reduction(max:m) reduction(||:nan)
+    for(int64_t i = 0; i < N; i++) {
+        double v = std::fabs(x[i * inc]);
+        nan = nan || (v != v);
+        m = std::max(m, v);
+    }
+    return nan ? std::numeric_limits<double>::quiet_NaN() : m;
+}
+
+/**
+ * \ingroup ExSUM
+ * \brief Returns the sum of the terms of input that are not finite. It does not
+ *  depend on the order of the terms, as long as they are all infinities or NaNs
+ *
+ * \param N number of terms
+ * \param input provides Term(i)
+ */
+template<typename INPUT> inline static double NonFiniteSum(int64_t N, INPUT const & input)
+{
+    double s = 0.0;
+    #pragma omp parallel for reduction(+:s)
+    for(int64_t i = 0; i < N; i++) {
+        double t = input.Term(i);
+        if(!std::isfinite(t)) {
+            s += t;
+        }
+    }
+    return s;
+}
+
+/**
+ * \ingroup ExSUM
+ * \brief Sums the terms of input with the backend of exsum selected by fpe < 0
+ *  (fpe_auto, fpe_xsum_large, fpe_online_exact or fpe_ifastsum), over a copy
+ *  of them widened to double, which is exact
+ *
+ * \param N number of terms
+ * \param input provides Term(i)
+ */
+template<typename INPUT> inline static double WidenedSum(int64_t N, INPUT const & input, int fpe, bool early_exit)
+{
+    std::vector<double> terms(N);
+    #pragma omp parallel for
+    for(int64_t i = 0; i < N; i++) {
+        terms[i] = input.Term(i);
+    }
+    return exsum(int(N), terms.data(), 1, 0, fpe, early_exit);
+}
+
+/**
+ * \ingroup ExSUM
+ * \brief Accumulates the N elements of input into INPUT::sums superaccumulators
+ *  at once. Each thread gets an equal range of elements, and the sums of the
+ *  threads are merged exactly, so that they do not depend on the number of threads
+ *
+ * \param N number of elements
+ * \param input provides AccumulateRange<CACHE>(acc, l, r), which accumulates the
+ *  elements [l, r) into acc[0] to acc[INPUT::sums - 1]
+ * \param acc holds the sums on return, in its first INPUT::sums entries
+ * \param zero superaccumulator that the sums start from, which sets their range
+ */
+template<typename CACHE, typename INPUT>
+static void ExSUMRanges(int64_t N, INPUT const & input, std::vector<Superaccumulator> & acc, Superaccumulator const & zero)
+{
+    const int K = INPUT::sums;
+    int maxthreads = omp_get_max_threads();
+    acc.assign(size_t(maxthreads) * K, zero);
+
+    #pragma omp parallel
+    {
+        unsigned int tid = omp_get_thread_num();
+        unsigned int tnum = omp_get_num_threads();
+        Superaccumulator * own = &acc[size_t(tid) * K];
+        input.template AccumulateRange<CACHE>(own, N * tid / tnum, N * (tid + 1) / tnum);
+        for(int k = 0; k != K; ++k) {
+            own[k].Normalize();
+        }
+
+        // Reduction tree, as in exsum
+        for(unsigned int s = 1; (1u << (s - 1)) < tnum; ++s) {
+            #pragma omp barrier
+            if(tid % (1u << s) == 0) {
+                unsigned int tid2 = tid | (1u << (s - 1));
+                if(tid2 < tnum) {
+                    for(int k = 0; k != K; ++k) {
+                        own[k].Accumulate(acc[size_t(tid2) * K + k]);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * \ingroup ExSUM
+ * \brief ExSUMRanges with the same choice of floating-point expansion as exsum:
+ *  superaccumulators only if fpe < 2
+ */
+template<typename INPUT>
+static void ExSUMRangesFPE(int64_t N, INPUT const & input, std::vector<Superaccumulator> & acc, int fpe, bool early_exit,
+    Superaccumulator const & zero = Superaccumulator())
+{
+    if(fpe < 2) {
+        return ExSUMRanges<SuperaccOnly>(N, input, acc, zero);
+    }
+    if(early_exit) {
+        if(fpe <= 4) {
+            return ExSUMRanges<FPExpansionVect<Vec4d, 4, FPExpansionTraits<true> > >(N, input, acc, zero);
+        }
+        if(fpe <= 6) {
+            return ExSUMRanges<FPExpansionVect<Vec4d, 6, FPExpansionTraits<true> > >(N, input, acc, zero);
+        }
+        return ExSUMRanges<FPExpansionVect<Vec4d, 8, FPExpansionTraits<true> > >(N, input, acc, zero);
+    }
+    switch(fpe) {
+    case 2:
+        return ExSUMRanges<FPExpansionVect<Vec4d, 2> >(N, input, acc, zero);
+    case 3:
+        return ExSUMRanges<FPExpansionVect<Vec4d, 3> >(N, input, acc, zero);
+    case 4:
+        return ExSUMRanges<FPExpansionVect<Vec4d, 4> >(N, input, acc, zero);
+    case 5:
+        return ExSUMRanges<FPExpansionVect<Vec4d, 5> >(N, input, acc, zero);
+    case 6:
+        return ExSUMRanges<FPExpansionVect<Vec4d, 6> >(N, input, acc, zero);
+    case 7:
+        return ExSUMRanges<FPExpansionVect<Vec4d, 7> >(N, input, acc, zero);
+    default:
+        return ExSUMRanges<FPExpansionVect<Vec4d, 8> >(N, input, acc, zero);
+    }
+}
+
+/**
+ * \struct AbsInput
+ * \ingroup ExSUM
+ * \brief Accumulates the absolute values of the elements of a vector, which
+ *  are exact. Elements that are not finite are dropped and reported through
+ *  overflow
+ */
+struct AbsInput
+{
+    double const *x;    /**< vector */
+    int inc;            /**< increment for the elements of x, positive */
+    std::atomic<bool> * overflow; /**< set when an element is not finite */
+
+    AbsInput(double const *x, int inc, std::atomic<bool> * overflow) : x(x), inc(inc), overflow(overflow) {}
+
+    /**
+     * Returns the term of element i
+     */
+    double Term(int64_t i) const {
+        return std::fabs(x[i * inc]);
+    }
+
+    /**
+     * Accumulates the absolute values of the elements [l, r) into the floating-point expansion
+     */
+    template<typename CACHE> void AccumulateChunk(CACHE & cache, int64_t l, int64_t r) const {
+        int64_t i;
+        for(i = l; i + 8 <= r; i += 8) {
+            Vec4d x1 = abs(LoadStrided(x, inc, i));
+            Vec4d x2 = abs(LoadStrided(x, inc, i + 4));
+            // x1 + x2 is only infinite when one of them is not finite
+            if(!horizontal_and(is_finite(x1 + x2))) {
+                DropNonFinite(x1, overflow);
+                DropNonFinite(x2, overflow);
+            }
+            cache.Accumulate(x1, x2);
+        }
+        if(i + 4 <= r) {
+            Vec4d x1 = abs(LoadStrided(x, inc, i));
+            DropNonFinite(x1, overflow);
+            cache.Accumulate(x1);
+            i += 4;
+        }
+        if(i < r) {
+            Vec4d x1 = abs(LoadPartialStrided(int(r - i), x, inc, i));
+            DropNonFinite(x1, overflow);
+            cache.Accumulate(x1);
+        }
+    }
+};
+
+/**
+ * \struct ProductInput
+ * \ingroup ExSUM
+ * \brief Accumulates the exact products of the elements of two vectors: both
+ *  the product and its rounding error enter the expansion. Products that are
+ *  not finite are dropped and reported through overflow
+ */
+struct ProductInput
+{
+    double const *w;    /**< weights */
+    int incw;           /**< increment for the elements of w, positive */
+    double const *x;    /**< vector */
+    int incx;           /**< increment for the elements of x, positive */
+    std::atomic<bool> * overflow; /**< set when a product is not finite */
+
+    ProductInput(double const *w, int incw, double const *x, int incx, std::atomic<bool> * overflow) :
+        w(w), incw(incw), x(x), incx(incx), overflow(overflow) {}
+
+    /**
+     * Returns the term of element i
+     */
+    double Term(int64_t i) const {
+        return w[i * incw] * x[i * incx];
+    }
+
+    /**
+     * Accumulates the products of the elements [l, r) into the floating-point expansion
+     */
+    template<typename CACHE> void AccumulateChunk(CACHE & cache, int64_t l, int64_t r) const {
+        int64_t i;
+        for(i = l; i + 4 <= r; i += 4) {
+            Accumulate(cache, LoadStrided(w, incw, i), LoadStrided(x, incx, i));
+        }
+        if(i < r) {
+            Accumulate(cache, LoadPartialStrided(int(r - i), w, incw, i), LoadPartialStrided(int(r - i), x, incx, i));
+        }
+    }
+
+private:
+    template<typename CACHE> void Accumulate(CACHE & cache, Vec4d a, Vec4d b) const {
+        Vec4d e;
+        Vec4d p = TwoProductFMA(a, b, e);
+        DropNonFinite(p, e, overflow);
+        cache.Accumulate(p, e);
+    }
+};
+
+/**
+ * \struct SquareInput
+ * \ingroup ExSUM
+ * \brief Accumulates the exact squares of the elements of a vector, scaled by
+ *  a power of two: both the product and its rounding error enter the expansion.
+ *  Squares that are not finite are dropped and reported through overflow, as
+ *  the superaccumulator only holds finite values
+ */
+struct SquareInput
+{
+    double const *x;    /**< vector */
+    int inc;            /**< increment for the elements of x, positive */
+    double scale;       /**< power of two applied to the elements before squaring */
+    std::atomic<bool> * overflow; /**< set when a square is not finite */
+
+    SquareInput(double const *x, int inc, double scale, std::atomic<bool> * overflow) :
+        x(x), inc(inc), scale(scale), overflow(overflow) {}
+
+    /**
+     * Accumulates the squares of the elements [l, r) into the floating-point expansion
+     */
+    template<typename CACHE> void AccumulateChunk(CACHE & cache, int64_t l, int64_t r) const {
+        int64_t i;
+        for(i = l; i + 4 <= r; i += 4) {
+            Accumulate(cache, LoadStrided(x, inc, i));
+        }
+        if(i < r) {
+            Accumulate(cache, LoadPartialStrided(int(r - i), x, inc, i));
+        }
+    }
+
+private:
+    template<typename CACHE> void Accumulate(CACHE & cache, Vec4d v) const {
+        Vec4d e;
+        v = v * scale;
+        Vec4d p = TwoProductFMA(v, v, e);
+        DropNonFinite(p, e, overflow);
+        cache.Accumulate(p, e);
+    }
+};
+
+#endif // EXSUM_FUSED_HPP_
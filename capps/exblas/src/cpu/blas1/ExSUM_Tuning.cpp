@@ -0,0 +1,67 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <utility>
+
+#include "ExSUM_Tuning.hpp"
+#include "config.h"
+
+typedef std::map<std::pair<int, bool>, ExSUMVariant const *> ExSUMProfile;
+
+std::string ExSUMProfilePath() {
+    char const * path = getenv("EXBLAS_TUNING_PROFILE");
+    if (path && path[0])
+        return path;
+    return std::string(EXBLAS_BINARY_DIR) + "/exsum.profile";
+}
+
+/*
+ * Reads lines "fpe early_exit variant"; '#' starts a comment.
+ * Entries naming a variant this build does not provide are ignored
+ */
+static ExSUMProfile LoadProfile(std::string const & path) {
+    ExSUMProfile profile;
+    FILE * f = fopen(path.c_str(), "r");
+    if (!f)
+        return profile;
+
+    std::vector<ExSUMVariant> const & variants = ExSUMVariants();
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char * comment = strchr(line, '#');
+        if (comment)
+            *comment = 0;
+        int fpe, ee;
+        char name[128];
+        if (sscanf(line, "%d %d %127s", &fpe, &ee, name) != 3)
+            continue;
+
+        ExSUMVariant const * v = 0;
+        for (size_t i = 0; i != variants.size(); ++i) {
+            if (variants[i].name == name && variants[i].fpe == fpe && variants[i].early_exit == (ee != 0)) {
+                v = &variants[i];
+                break;
+            }
+        }
+        if (v)
+            profile[std::make_pair(fpe, ee != 0)] = v;
+        else
+            fprintf(stderr, "%s: unknown variant %s for fpe = %d, early_exit = %d, ignored\n", path.c_str(), name, fpe, ee);
+    }
+    fclose(f);
+    return profile;
+}
+
+ExSUMVariant const * ExSUMTunedVariant(int fpe, bool early_exit) {
+    // Initialization of a local static is thread-safe in C++11
+    static ExSUMProfile const profile = LoadProfile(ExSUMProfilePath());
+
+    ExSUMProfile::const_iterator it = profile.find(std::make_pair(fpe, early_exit));
+    return it == profile.end() ? 0 : it->second;
+}
@@ -0,0 +1,63 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas1/ExSUM_Tuning.hpp
+ *  \brief Provides the instantiations of ExSUMFPE that can be selected by a
+ *         tuning profile. For internal use
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+
+#ifndef EXSUM_TUNING_HPP_
+#define EXSUM_TUNING_HPP_
+
+#include <string>
+#include <vector>
+
+/**
+ * \struct ExSUMVariant
+ * \ingroup ExSUM
+ * \brief One instantiation of ExSUMFPE: an expansion size and a combination of
+ *  FPExpansionTraits. All variants return the same, correctly rounded, sum
+ */
+struct ExSUMVariant
+{
+    std::string name;   /**< e.g. fpe4-ee-flushhi, stored in the profile */
+    int fpe;            /**< expansion size */
+    bool early_exit;    /**< value of FPExpansionTraits::EarlyExit */
+    double (*run)(int N, double *a, int inca, int offset); /**< the summation */
+};
+
+/**
+ * \ingroup ExSUM
+ * \brief Returns the grid of instantiations the tuner benchmarks
+ */
+std::vector<ExSUMVariant> const & ExSUMVariants();
+
+/**
+ * \ingroup ExSUM
+ * \brief Returns the variant recorded in the tuning profile for an expansion
+ *  size and early-exit setting, or 0 if there is none.
+ *
+ *  The profile is read on first use from the file named by the environment
+ *  variable EXBLAS_TUNING_PROFILE, or from exsum.profile in the build directory.
+ *  A missing profile is not an error: exsum then uses its default traits
+ *
+ * \param fpe expansion size
+ * \param early_exit early-exit setting
+ */
+ExSUMVariant const * ExSUMTunedVariant(int fpe, bool early_exit);
+
+/**
+ * \ingroup ExSUM
+ * \brief Returns the path of the tuning profile read by ExSUMTunedVariant
+ */
+std::string ExSUMProfilePath();
+
+#endif // EXSUM_TUNING_HPP_
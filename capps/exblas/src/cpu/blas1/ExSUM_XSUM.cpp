@@ -0,0 +1,83 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include <omp.h>
+
+#ifdef EXBLAS_MPI
+    #include <mpi.h>
+#endif
+
+#include "ExSUM_XSUM.hpp"
+
+
+/*
+ * Neal's large accumulator, one per thread. Each thread sums an equal range of
+ * the vector into its own large accumulator, and transfers it to the small
+ * accumulator within it. The small accumulators hold exact sums, and adding
+ * them does not depend on their order, so that the result does not depend on
+ * the number of threads
+ */
+double ExSUMXsumLarge(int N, double *a, int inca, int offset) {
+    a += offset;
+    int maxthreads = omp_get_max_threads();
+    std::vector<xsum_small_accumulator> part(maxthreads);
+
+    #pragma omp parallel
+    {
+        unsigned int tid = omp_get_thread_num();
+        unsigned int tnum = omp_get_num_threads();
+        int64_t l = int64_t(N) * tid / tnum, r = int64_t(N) * (tid + 1) / tnum;
+
+        // Allocated by its thread, so that its pages are local
+        xsum_large_accumulator * lacc = (xsum_large_accumulator *) malloc(sizeof(xsum_large_accumulator));
+        if (!lacc) {
+            fprintf(stderr, "Cannot allocate memory for the large accumulator\n");
+            exit(1);
+        }
+        xsum_large_init(lacc);
+        if (inca == 1) {
+            xsum_large_addv(lacc, a + l, xsum_length(r - l));
+        } else {
+            // Strided elements are gathered by blocks, which are added contiguously
+            xsum_flt block[256];
+            for (int64_t i = l; i < r; i += 256) {
+                int64_t n = std::min<int64_t>(256, r - i);
+                for (int64_t j = 0; j < n; j++)
+                    block[j] = a[(i + j) * inca];
+                xsum_large_addv(lacc, block, xsum_length(n));
+            }
+        }
+        part[tid] = *xsum_large_to_small(lacc);
+        free(lacc);
+    }
+
+    xsum_small_accumulator acc;
+    xsum_small_init(&acc);
+    for (int t = 0; t != maxthreads; ++t) {
+        xsum_small_add_accumulator(&acc, &part[t]);
+    }
+
+#ifdef EXBLAS_MPI
+    int np = 1, p;
+    MPI_Comm_rank(MPI_COMM_WORLD, &p);
+    MPI_Comm_size(MPI_COMM_WORLD, &np);
+    std::vector<xsum_small_accumulator> all(p == 0 ? np : 1);
+    MPI_Gather(&acc, sizeof(acc), MPI_BYTE, &all[0], sizeof(acc), MPI_BYTE, 0, MPI_COMM_WORLD);
+    if (p == 0) {
+        for (int i = 1; i < np; ++i) {
+            xsum_small_add_accumulator(&acc, &all[i]);
+        }
+    } else {
+        // Only the first process holds the sum, as with superaccumulators
+        return 0.0;
+    }
+#endif
+
+    return xsum_small_round(&acc);
+}
@@ -0,0 +1,40 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas1/ExSUM_XSUM.hpp
+ *  \brief Provides the summation backend built on the accumulators of xsum,
+ *         by Radford M. Neal, from capps/xsum_slacc
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+#ifndef EXSUM_XSUM_HPP_
+#define EXSUM_XSUM_HPP_
+
+// xsum is written in C99
+extern "C" {
+#define restrict __restrict__
+#include "xsum.h"
+#undef restrict
+}
+
+/**
+ * \ingroup ExSUM
+ * \brief Parallel summation with one xsum large accumulator per thread. The
+ *  large accumulators are transferred to their small accumulators, which are
+ *  added exactly and rounded once with xsum_small_round
+ *
+ * \param N vector size
+ * \param a vector
+ * \param inca specifies the increment for the elements of a
+ * \param offset specifies position in the vector to start with 
+ * \return Contains the reproducible and accurate sum of elements of a real vector
+ */
+double ExSUMXsumLarge(int N, double *a, int inca, int offset);
+
+#endif // EXSUM_XSUM_HPP_
@@ -0,0 +1,61 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstring>
+#include <vector>
+#include <mutex>
+
+#include "FPEStats.hpp"
+
+
+std::atomic<bool> exfpestats_enabled(false);
+
+static std::mutex registry_mutex;
+static std::vector<__fpe_stats *> registry;
+static thread_local __fpe_stats * own = 0;
+static __fpe_stats last;
+
+__fpe_stats * FPEStatsOwn() {
+    if (!exfpestats_enabled.load(std::memory_order_relaxed))
+        return 0;
+    if (!own) {
+        own = new __fpe_stats();
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.push_back(own);
+    }
+    return own;
+}
+
+void FPEStatsBegin() {
+    if (!exfpestats_enabled.load(std::memory_order_relaxed))
+        return;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (size_t t = 0; t != registry.size(); ++t)
+        memset(registry[t], 0, sizeof(__fpe_stats));
+}
+
+void FPEStatsEnd() {
+    if (!exfpestats_enabled.load(std::memory_order_relaxed))
+        return;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    memset(&last, 0, sizeof(last));
+    for (size_t t = 0; t != registry.size(); ++t) {
+        __fpe_stats const & s = *registry[t];
+        last.inputs += s.inputs;
+        last.flushes += s.flushes;
+        for (int d = 0; d != exfpestats_depths; ++d)
+            last.depth[d] += s.depth[d];
+        last.carries += s.carries;
+    }
+}
+
+void exfpestats_enable(const bool on) {
+    exfpestats_enabled.store(on);
+}
+
+__fpe_stats exfpestats_last() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    return last;
+}
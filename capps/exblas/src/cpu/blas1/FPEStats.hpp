@@ -0,0 +1,53 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas1/FPEStats.hpp
+ *  \brief Counts how deep the inputs go into the floating-point expansions and
+ *         how often they reach the superaccumulators, when enabled with
+ *         exfpestats_enable
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+#ifndef FPESTATS_HPP_
+#define FPESTATS_HPP_
+
+#include <atomic>
+#include "blas1.hpp"
+
+extern std::atomic<bool> exfpestats_enabled;
+
+/**
+ * \brief Statistics of the calling thread, or 0 if they are disabled. The
+ *  expansions keep the pointer, so that their loops test it only
+ */
+__fpe_stats * FPEStatsOwn();
+
+/**
+ * \brief Starts the statistics of a call: sets those of all threads to zero
+ */
+void FPEStatsBegin();
+
+/**
+ * \brief Ends the statistics of a call: sums those of all threads into the
+ *  statistics returned by exfpestats_last
+ */
+void FPEStatsEnd();
+
+/**
+ * \brief Counts one step of carry propagation in a superaccumulator. Only
+ *  called when a word overflows, and empty without EXBLAS_FPE_COUNTERS
+ */
+inline void FPEStatsCarry() {
+#ifdef EXBLAS_FPE_COUNTERS
+    if (exfpestats_enabled.load(std::memory_order_relaxed))
+        ++FPEStatsOwn()->carries;
+#endif
+}
+
+#endif // FPESTATS_HPP_
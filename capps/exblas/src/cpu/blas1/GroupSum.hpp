@@ -0,0 +1,382 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas1/GroupSum.hpp
+ *  \brief Provides a hash aggregation of values by key, with one exact sum
+ *         per key
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+
+#ifndef GROUPSUM_HPP_
+#define GROUPSUM_HPP_
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <vector>
+#include <omp.h>
+
+#include "superaccumulator.hpp"
+#include "ExSUM_FPE.hpp"
+#include "cachealigned.hpp"
+
+namespace exblas {
+
+/**
+ * \class GroupSum
+ * \ingroup ExSUM
+ * \brief Sums values by key with our multi-level reproducible and accurate
+ *  algorithm: each key has a scalar floating-point expansion of size N, which
+ *  overflows into a superaccumulator allocated on its first flush.
+ *
+ *  The table uses open addressing with linear probing. A slot holds the key,
+ *  the expansion and the pointer to the superaccumulator, and fills a cache line
+ *  for N <= 4 and keys of up to 16 bytes, such as integers or pairs of them;
+ *  larger keys, such as std::string, take two lines or more. A moved-from table
+ *  is empty and usable. Tables are merged exactly, so that the
+ *  sum of each key does not depend on how the input was split among threads.
+ *  The order in which ForEach visits the keys is unspecified.
+ */
+template<typename Key, int N = 4, typename Hash = std::hash<Key> >
+class GroupSum
+{
+public:
+    /**
+     * Constructor
+     * \param capacity number of keys the table holds before it first grows
+     */
+    explicit GroupSum(size_t capacity = 1024);
+    ~GroupSum();
+
+    GroupSum(GroupSum && other);
+    GroupSum & operator=(GroupSum && other);
+
+    /**
+     * Accumulates value x to the sum of key k
+     */
+    void Add(Key const & k, double x);
+
+    /**
+     * Accumulates the values of the n pairs (keys[i], values[i]), with a table
+     * per thread that are merged exactly at the end
+     */
+    void Aggregate(int64_t n, Key const * keys, double const * values);
+
+    /**
+     * Accumulates the sums of other, which is left in an unspecified state
+     */
+    void Merge(GroupSum & other);
+
+    /**
+     * Returns the number of keys
+     */
+    size_t Size() const { return count; }
+
+    /**
+     * Returns the correctly rounded sum of key k, 0 if k has no value
+     */
+    double Sum(Key const & k) const;
+
+    /**
+     * Calls f(key, sum) for each key, with the correctly rounded sum
+     */
+    template<typename F> void ForEach(F f) const;
+
+private:
+    struct alignas(64) Slot
+    {
+        double fpe[N];          // most significant digits first
+        Superaccumulator * superacc;  // 0 before the first flush, Unused() if no key
+        double special;         // sum of the values that are not finite
+        Key key;
+
+        bool Used() const { return superacc != Unused(); }
+    };
+
+    // Marks the slots without a key, instead of a flag that would not fit
+    // in the cache line
+    static Superaccumulator * Unused() {
+        static char tag;
+        return reinterpret_cast<Superaccumulator *>(&tag);
+    }
+
+    GroupSum(GroupSum const &) = delete;
+    GroupSum & operator=(GroupSum const &) = delete;
+
+    void Init(size_t capacity);
+    size_t Bucket(Key const & k) const;
+    Slot & FindOrInsert(Key const & k);
+    Slot const * Find(Key const & k) const;
+    void Grow();
+    static void Accumulate(Slot & s, double x);
+    static double Round(Slot const & s);
+    void Clear();
+
+    std::vector<Slot, CacheAlignedAllocator<Slot> > slots;
+    size_t mask;
+    int shift;
+    size_t count;
+};
+
+template<typename Key, int N, typename Hash>
+GroupSum<Key,N,Hash>::GroupSum(size_t capacity)
+{
+    static_assert(N > 4 || sizeof(Key) > 16 || sizeof(Slot) == 64,
+        "a slot should fill one cache line for N <= 4 and keys of up to 16 bytes");
+    Init(capacity);
+}
+
+template<typename Key, int N, typename Hash>
+void GroupSum<Key,N,Hash>::Init(size_t capacity)
+{
+    // At most half full
+    size_t size = 16;
+    shift = 60;
+    while(size < 2 * capacity) {
+        size *= 2;
+        --shift;
+    }
+    Slot empty = Slot();
+    empty.superacc = Unused();
+    slots.assign(size, empty);
+    mask = size - 1;
+    count = 0;
+}
+
+template<typename Key, int N, typename Hash>
+GroupSum<Key,N,Hash>::~GroupSum()
+{
+    Clear();
+}
+
+template<typename Key, int N, typename Hash>
+GroupSum<Key,N,Hash>::GroupSum(GroupSum && other) :
+    slots(std::move(other.slots)), mask(other.mask), shift(other.shift), count(other.count)
+{
+    other.Init(0);
+}
+
+template<typename Key, int N, typename Hash>
+GroupSum<Key,N,Hash> & GroupSum<Key,N,Hash>::operator=(GroupSum && other)
+{
+    if(this != &other) {
+        Clear();
+        slots = std::move(other.slots);
+        mask = other.mask;
+        shift = other.shift;
+        count = other.count;
+        other.Init(0);
+    }
+    return *this;
+}
+
+template<typename Key, int N, typename Hash>
+void GroupSum<Key,N,Hash>::Clear()
+{
+    for(size_t i = 0; i != slots.size(); ++i) {
+        if(slots[i].Used()) {
+            delete slots[i].superacc;
+            slots[i].superacc = Unused();
+        }
+    }
+}
+
+template<typename Key, int N, typename Hash> inline
+size_t GroupSum<Key,N,Hash>::Bucket(Key const & k) const
+{
+    // Fibonacci hashing: keys that are consecutive integers, which std::hash
+    // leaves as they are, spread over the table
+    return size_t((uint64_t(Hash()(k)) * 0x9E3779B97F4A7C15ull) >> shift) & mask;
+}
+
+template<typename Key, int N, typename Hash> inline
+typename GroupSum<Key,N,Hash>::Slot & GroupSum<Key,N,Hash>::FindOrInsert(Key const & k)
+{
+    size_t i = Bucket(k);
+    while(slots[i].Used()) {
+        if(slots[i].key == k) {
+            return slots[i];
+        }
+        i = (i + 1) & mask;
+    }
+    if(2 * (count + 1) > slots.size()) {
+        Grow();
+        return FindOrInsert(k);
+    }
+    slots[i].superacc = 0;
+    slots[i].key = k;
+    ++count;
+    return slots[i];
+}
+
+template<typename Key, int N, typename Hash>
+typename GroupSum<Key,N,Hash>::Slot const * GroupSum<Key,N,Hash>::Find(Key const & k) const
+{
+    if(slots.empty()) {
+        return 0;
+    }
+    size_t i = Bucket(k);
+    while(slots[i].Used()) {
+        if(slots[i].key == k) {
+            return &slots[i];
+        }
+        i = (i + 1) & mask;
+    }
+    return 0;
+}
+
+template<typename Key, int N, typename Hash>
+void GroupSum<Key,N,Hash>::Grow()
+{
+    std::vector<Slot, CacheAlignedAllocator<Slot> > old;
+    old.swap(slots);
+    Slot empty = Slot();
+    empty.superacc = Unused();
+    slots.assign(2 * old.size(), empty);
+    mask = slots.size() - 1;
+    --shift;
+    // Moves the state, including the ownership of the superaccumulators
+    for(size_t j = 0; j != old.size(); ++j) {
+        if(old[j].Used()) {
+            size_t i = Bucket(old[j].key);
+            while(slots[i].Used()) {
+                i = (i + 1) & mask;
+            }
+            slots[i] = old[j];
+        }
+    }
+}
+
+template<typename Key, int N, typename Hash> inline
+void GroupSum<Key,N,Hash>::Accumulate(Slot & s, double x)
+{
+    if(!std::isfinite(x)) {
+        s.special += x;
+        return;
+    }
+    for(int i = 0; i != N; ++i) {
+        s.fpe[i] = Knuth2Sum(s.fpe[i], x, x);
+        if(x == 0) {
+            return;
+        }
+    }
+    if(!s.superacc) {
+        s.superacc = new Superaccumulator();
+    }
+    s.superacc->Accumulate(x);
+}
+
+template<typename Key, int N, typename Hash> inline
+void GroupSum<Key,N,Hash>::Add(Key const & k, double x)
+{
+    Accumulate(FindOrInsert(k), x);
+}
+
+template<typename Key, int N, typename Hash>
+void GroupSum<Key,N,Hash>::Merge(GroupSum & other)
+{
+    for(size_t j = 0; j != other.slots.size(); ++j) {
+        Slot & o = other.slots[j];
+        if(!o.Used()) {
+            continue;
+        }
+        Slot & s = FindOrInsert(o.key);
+        for(int i = 0; i != N; ++i) {
+            if(o.fpe[i] != 0) {
+                Accumulate(s, o.fpe[i]);
+            }
+        }
+        if(o.superacc) {
+            if(!s.superacc) {
+                // Take it over
+                s.superacc = o.superacc;
+                o.superacc = 0;
+            } else {
+                s.superacc->Accumulate(*o.superacc);
+            }
+        }
+        s.special += o.special;
+    }
+}
+
+template<typename Key, int N, typename Hash>
+void GroupSum<Key,N,Hash>::Aggregate(int64_t n, Key const * keys, double const * values)
+{
+    int maxthreads = omp_get_max_threads();
+    std::vector<GroupSum *> tables(maxthreads, 0);
+    size_t capacity = slots.size() / 2;
+
+    #pragma omp parallel
+    {
+        unsigned int tid = omp_get_thread_num();
+        unsigned int tnum = omp_get_num_threads();
+        GroupSum * local = (tid == 0) ? this : new GroupSum(capacity);
+        tables[tid] = local;
+
+        #pragma omp for schedule(static)
+        for(int64_t i = 0; i < n; ++i) {
+            local->Add(keys[i], values[i]);
+        }
+
+        // Merge tree, as the reduction of exsum. The implicit barrier of the
+        // loop above ensures that all tables are filled
+        for(unsigned int s = 1; (1u << (s-1)) < tnum; ++s) {
+            if(tid % (1u << s) == 0) {
+                unsigned int tid2 = tid | (1u << (s-1));
+                if(tid2 < tnum) {
+                    local->Merge(*tables[tid2]);
+                    delete tables[tid2];
+                }
+            }
+            #pragma omp barrier
+        }
+    }
+}
+
+template<typename Key, int N, typename Hash>
+double GroupSum<Key,N,Hash>::Round(Slot const & s)
+{
+    if(s.special != 0) {
+        return s.special;
+    }
+    Superaccumulator acc;
+    for(int i = 0; i != N; ++i) {
+        if(s.fpe[i] != 0) {
+            acc.Accumulate(s.fpe[i]);
+        }
+    }
+    if(s.superacc) {
+        acc.Accumulate(*s.superacc);
+    }
+    return acc.Round();
+}
+
+template<typename Key, int N, typename Hash>
+double GroupSum<Key,N,Hash>::Sum(Key const & k) const
+{
+    Slot const * s = Find(k);
+    return s ? Round(*s) : 0.0;
+}
+
+template<typename Key, int N, typename Hash>
+template<typename F>
+void GroupSum<Key,N,Hash>::ForEach(F f) const
+{
+    for(size_t j = 0; j != slots.size(); ++j) {
+        if(slots[j].Used()) {
+            f(slots[j].key, Round(slots[j]));
+        }
+    }
+}
+
+} // namespace exblas
+
+#endif // GROUPSUM_HPP_
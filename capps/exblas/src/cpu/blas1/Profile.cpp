@@ -0,0 +1,227 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <mutex>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "Profile.hpp"
+#include "mylibm.hpp"
+
+
+std::atomic<bool> exprofile_enabled(false);
+
+static const int ncounters = 6;
+
+// Hardware events, in the order of __profile_counters
+static const struct { uint32_t type; uint64_t config; } events[ncounters] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16)},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}
+};
+
+static uint64_t & Counter(__profile_counters & c, int i) {
+    uint64_t * counters[ncounters] = {&c.cycles, &c.instructions, &c.l1d_misses,
+        &c.l2_misses, &c.llc_misses, &c.branch_misses};
+    return *counters[i];
+}
+
+static uint64_t Counter(__profile_counters const & c, int i) {
+    return Counter(const_cast<__profile_counters &>(c), i);
+}
+
+// Counter of the perf_event mapped at pc, read in user space with rdpmc. False
+// when the kernel does not allow it, or the counter is not on the processor
+static bool ReadMapped(perf_event_mmap_page const * pc, uint64_t & count) {
+    uint32_t seq;
+    do {
+        seq = pc->lock;
+        asm volatile ("" ::: "memory");
+        uint32_t index = pc->index;
+        if (!pc->cap_user_rdpmc || index == 0 || pc->pmc_width == 0)
+            return false;
+        uint32_t lo, hi;
+        asm volatile ("rdpmc" : "=a"(lo), "=d"(hi) : "c"(index - 1));
+        int shift = 64 - pc->pmc_width;
+        int64_t pmc = int64_t(((uint64_t) hi << 32 | lo) << shift) >> shift;
+        count = pc->offset + pmc;
+        asm volatile ("" ::: "memory");
+    } while (pc->lock != seq);
+    return true;
+}
+
+/*
+ * Counters of one thread, opened as one perf_event group so that a single
+ * read returns all of them. Each counter is also mapped, so that Read takes
+ * them with rdpmc rather than with a system call when the kernel allows it
+ */
+struct ThreadProfile
+{
+    int leader;
+    int slot[ncounters];     // position of each counter in a group read, or -1
+    perf_event_mmap_page * page[ncounters];  // mapping of each counter, or 0
+    unsigned int available;
+    __profile_counters phase[exprofile_phases];
+
+    // Counts at the last change of phase: ticks, then the counters
+    uint64_t last[ncounters + 1];
+    // Phases nest at most twice; deeper ones count towards the 16th
+    int stack[16];
+    int depth;
+
+    ThreadProfile() : leader(-1), available(0), depth(0) {
+        int n = 0;
+        for (int i = 0; i != ncounters; ++i) {
+            struct perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = events[i].type;
+            attr.config = events[i].config;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.disabled = (leader == -1);
+            int fd = syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0);
+            slot[i] = -1;
+            page[i] = 0;
+            if (fd == -1)
+                continue;
+            void * p = mmap(0, sysconf(_SC_PAGESIZE), PROT_READ, MAP_SHARED, fd, 0);
+            if (p != MAP_FAILED)
+                page[i] = (perf_event_mmap_page *) p;
+            if (leader == -1)
+                leader = fd;
+            slot[i] = n++;
+            available |= 1u << i;
+        }
+        if (leader != -1)
+            ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        Reset();
+    }
+
+    void Reset() {
+        memset(phase, 0, sizeof(phase));
+    }
+
+    // With rdpmc when every counter allows it
+    bool ReadUser(uint64_t * now) {
+        for (int i = 0; i != ncounters; ++i) {
+            now[i + 1] = 0;
+            if (slot[i] >= 0 && (!page[i] || !ReadMapped(page[i], now[i + 1])))
+                return false;
+        }
+        return true;
+    }
+
+    // A group larger than the counters of the processor is never scheduled,
+    // and reads zero: its counters are not available
+    void Read(uint64_t * now) {
+        now[0] = rdtsc();
+        if (ReadUser(now))
+            return;
+        // Number of counters, time running, then the counters
+        uint64_t values[ncounters + 2] = {0};
+        if (leader != -1 && read(leader, values, sizeof(values)) <= 0)
+            values[0] = 0;
+        if (leader != -1 && values[0] != 0 && values[1] == 0)
+            available = 0;
+        for (int i = 0; i != ncounters; ++i)
+            now[i + 1] = (slot[i] >= 0 && slot[i] < int(values[0])) ? values[slot[i] + 2] : 0;
+    }
+
+    // Counts since the last change go to the current phase
+    void Charge(uint64_t const * now) {
+        if (depth > 0) {
+            __profile_counters & c = phase[stack[std::min(depth, 16) - 1]];
+            c.ticks += now[0] - last[0];
+            for (int i = 0; i != ncounters; ++i)
+                Counter(c, i) += now[i + 1] - last[i + 1];
+        }
+        memcpy(last, now, sizeof(last));
+    }
+};
+
+static std::mutex registry_mutex;
+static std::vector<ThreadProfile *> registry;
+static thread_local ThreadProfile * own = 0;
+
+static ThreadProfile & Own() {
+    if (!own) {
+        own = new ThreadProfile();
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        registry.push_back(own);
+    }
+    return *own;
+}
+
+void ProfileEnter(int phase) {
+    ThreadProfile & tp = Own();
+    uint64_t now[ncounters + 1];
+    tp.Read(now);
+    tp.Charge(now);
+    if (tp.depth < 16)
+        tp.stack[tp.depth] = phase;
+    ++tp.depth;
+    ++tp.phase[phase].calls;
+}
+
+void ProfileLeave() {
+    ThreadProfile & tp = Own();
+    uint64_t now[ncounters + 1];
+    tp.Read(now);
+    tp.Charge(now);
+    --tp.depth;
+}
+
+void exprofile_enable(const bool on) {
+    exprofile_enabled.store(on);
+}
+
+void exprofile_reset() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (size_t t = 0; t != registry.size(); ++t)
+        registry[t]->Reset();
+}
+
+__profile exprofile_get() {
+    __profile p;
+    memset(&p, 0, sizeof(p));
+    p.available = (1u << ncounters) - 1;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (size_t t = 0; t != registry.size(); ++t) {
+        ThreadProfile const & tp = *registry[t];
+        p.available &= tp.available;
+        for (int k = 0; k != exprofile_phases; ++k) {
+            __profile_counters & c = p.phase[k];
+            __profile_counters const & d = tp.phase[k];
+            c.calls += d.calls;
+            c.ticks += d.ticks;
+            for (int i = 0; i != ncounters; ++i)
+                Counter(c, i) += Counter(d, i);
+        }
+    }
+    if (registry.empty())
+        p.available = 0;
+    return p;
+}
+
+const char * exprofile_phase_name(const int phase) {
+    static const char * names[exprofile_phases] = {"accumulate", "flush", "normalize", "reduction", "round"};
+    if (phase < 0 || phase >= exprofile_phases)
+        return "unknown";
+    return names[phase];
+}
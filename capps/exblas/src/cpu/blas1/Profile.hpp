@@ -0,0 +1,65 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas1/Profile.hpp
+ *  \brief Attributes hardware counters to the phases of our kernels, when
+ *         profiling is enabled with exprofile_enable
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+#ifndef PROFILE_HPP_
+#define PROFILE_HPP_
+
+#include <atomic>
+#include "blas1.hpp"
+
+extern std::atomic<bool> exprofile_enabled;
+
+/**
+ * \brief Makes phase the current phase of the calling thread. The counts
+ *  since the previous change go to the phase that was current
+ */
+void ProfileEnter(int phase);
+
+/**
+ * \brief Returns to the phase that was current before the last ProfileEnter
+ */
+void ProfileLeave();
+
+/**
+ * \brief Counts its lifetime towards a phase, excluding the nested phases.
+ *  Costs one test of a flag when profiling is disabled. When enabled, entering
+ *  and leaving each read the counters: with rdpmc, some tens of cycles, when
+ *  the kernel allows reads from user space, and otherwise with one read()
+ *  system call each, which is much longer than a flush of FPExpansionVect.
+ *  The counts of the phase include this overhead
+ */
+class ProfileScope
+{
+public:
+    explicit ProfileScope(int phase) :
+        on(exprofile_enabled.load(std::memory_order_relaxed))
+    {
+        if (on)
+            ProfileEnter(phase);
+    }
+
+    ~ProfileScope() {
+        if (on)
+            ProfileLeave();
+    }
+
+private:
+    ProfileScope(ProfileScope const &);
+    ProfileScope & operator=(ProfileScope const &);
+
+    bool on;
+};
+
+#endif // PROFILE_HPP_
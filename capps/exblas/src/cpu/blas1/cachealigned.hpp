@@ -0,0 +1,65 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas1/cachealigned.hpp
+ *  \brief Provides an allocator of whole cache lines. For internal use
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+
+#ifndef CACHEALIGNED_HPP_INCLUDED
+#define CACHEALIGNED_HPP_INCLUDED
+
+#include <cstddef>
+#include <new>
+#include <mm_malloc.h>
+
+/**
+ * \ingroup ExSUM
+ * \brief Size of a cache line in bytes
+ */
+const size_t cache_line_size = 64;
+
+/**
+ * \class CacheAlignedAllocator
+ * \ingroup ExSUM
+ * \brief Allocates storage that starts on a cache line and spans whole lines,
+ *  so that data written by different threads never share a line
+ */
+template<typename T>
+struct CacheAlignedAllocator
+{
+    typedef T value_type;
+
+    CacheAlignedAllocator() {}
+    template<typename U> CacheAlignedAllocator(CacheAlignedAllocator<U> const &) {}
+
+    T * allocate(size_t n) {
+        size_t bytes = (n * sizeof(T) + cache_line_size - 1) & ~(cache_line_size - 1);
+        void * p = _mm_malloc(bytes, cache_line_size);
+        if(!p) {
+            throw std::bad_alloc();
+        }
+        return static_cast<T *>(p);
+    }
+
+    void deallocate(T * p, size_t) {
+        _mm_free(p);
+    }
+
+    template<typename U> struct rebind { typedef CacheAlignedAllocator<U> other; };
+};
+
+template<typename T, typename U>
+inline bool operator==(CacheAlignedAllocator<T> const &, CacheAlignedAllocator<U> const &) { return true; }
+
+template<typename T, typename U>
+inline bool operator!=(CacheAlignedAllocator<T> const &, CacheAlignedAllocator<U> const &) { return false; }
+
+#endif
@@ -0,0 +1,199 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas1/chunkscheduler.hpp
+ *  \brief Provides a work-stealing schedule of the input vector among threads
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+
+#ifndef CHUNKSCHEDULER_HPP_INCLUDED
+#define CHUNKSCHEDULER_HPP_INCLUDED
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+#include "cachealigned.hpp"
+
+/**
+ * \class ChunkScheduler
+ * \ingroup ExSUM
+ * \brief Splits [0, N) into chunks and hands them out to threads.
+ *
+ *  Each thread owns an equal contiguous slice of chunks, which it consumes
+ *  front to back. A thread that runs out of work steals chunks from the back
+ *  of the other slices, so that the whole reduction does not wait for the
+ *  slowest core. Owner and thieves only meet on the last chunk of a slice.
+ */
+class ChunkScheduler
+{
+public:
+    /**
+     * Constructor
+     * \param maxthreads maximum number of threads that will use the schedule
+     */
+    ChunkScheduler(unsigned int maxthreads) : slices(maxthreads) {}
+
+    /**
+     * Distributes the chunks among tnum threads. Must be called by a single
+     * thread before any call to NextOwn or Steal
+     * \param N vector size
+     * \param tnum number of threads
+     * \param chunksize number of elements per chunk, a multiple of 8
+     */
+    void Reset(int64_t N, unsigned int tnum, int64_t chunksize);
+
+    /**
+     * Takes the next chunk of the slice of thread tid
+     * \param tid thread ID
+     * \param chunk index of the chunk taken
+     * \return false if the slice is exhausted
+     */
+    bool NextOwn(unsigned int tid, int64_t & chunk);
+
+    /**
+     * Takes the last chunk of the slice of another thread
+     * \param tid thread ID of the thief
+     * \param victim thread ID of the owner of the chunk taken
+     * \param chunk index of the chunk taken
+     * \return false if there is no chunk left at all
+     */
+    bool Steal(unsigned int tid, unsigned int & victim, int64_t & chunk);
+
+    /**
+     * Takes a chunk of the thread's own slice, or steals one
+     * \param tid thread ID
+     * \param chunk index of the chunk taken
+     * \return false if there is no chunk left at all
+     */
+    bool Next(unsigned int tid, int64_t & chunk);
+
+    /**
+     * Index of the first chunk of the slice of thread tid
+     */
+    int64_t SliceBegin(unsigned int tid) const { return slices[tid].begin; }
+
+    /**
+     * Index past the last chunk of the slice of thread tid
+     */
+    int64_t SliceEnd(unsigned int tid) const { return slices[tid].end; }
+
+    /**
+     * Index past the last chunk processed by the owner of slice tid. Only
+     * meaningful once NextOwn(tid) returned false
+     */
+    int64_t OwnEnd(unsigned int tid) const;
+
+    /**
+     * Position in the vector of the first element of a chunk
+     */
+    int64_t ChunkBegin(int64_t chunk) const { return chunk * chunksize; }
+
+    /**
+     * Position in the vector past the last element of a chunk
+     */
+    int64_t ChunkEnd(int64_t chunk) const { return std::min(N, (chunk + 1) * chunksize); }
+
+    /**
+     * Returns a chunk size that gives each of tnum threads several chunks,
+     * while keeping chunks large enough to amortize the scheduling
+     * \param N vector size
+     * \param tnum number of threads
+     */
+    static int64_t DefaultChunkSize(int64_t N, unsigned int tnum);
+
+private:
+    // Remaining chunks of a slice, packed as (front << 32) | back
+    static uint64_t Pack(int64_t front, int64_t back) { return (uint64_t(front) << 32) | uint64_t(back); }
+    static int64_t Front(uint64_t r) { return int64_t(r >> 32); }
+    static int64_t Back(uint64_t r) { return int64_t(r & 0xffffffffull); }
+
+    // One cache line per slice, so that owners and thieves of different
+    // slices do not share lines
+    struct alignas(64) Slice
+    {
+        Slice() : remaining(0), begin(0), end(0) {}
+
+        std::atomic<uint64_t> remaining;
+        int64_t begin, end;
+    };
+    static_assert(sizeof(Slice) == 64, "Slice must fill one cache line");
+
+    std::vector<Slice, CacheAlignedAllocator<Slice> > slices;
+    unsigned int tnum;
+    int64_t N;
+    int64_t chunksize;
+};
+
+inline void ChunkScheduler::Reset(int64_t N, unsigned int tnum, int64_t chunksize)
+{
+    this->N = N;
+    this->tnum = tnum;
+    this->chunksize = chunksize;
+    int64_t nchunks = (N + chunksize - 1) / chunksize;
+    for(unsigned int t = 0; t != tnum; ++t) {
+        slices[t].begin = (t * nchunks) / tnum;
+        slices[t].end = ((t + 1) * nchunks) / tnum;
+        slices[t].remaining.store(Pack(slices[t].begin, slices[t].end), std::memory_order_relaxed);
+    }
+}
+
+inline bool ChunkScheduler::NextOwn(unsigned int tid, int64_t & chunk)
+{
+    std::atomic<uint64_t> & remaining = slices[tid].remaining;
+    uint64_t r = remaining.load(std::memory_order_relaxed);
+    while(Front(r) < Back(r)) {
+        if(remaining.compare_exchange_weak(r, Pack(Front(r) + 1, Back(r)), std::memory_order_relaxed)) {
+            chunk = Front(r);
+            return true;
+        }
+    }
+    return false;
+}
+
+inline bool ChunkScheduler::Steal(unsigned int tid, unsigned int & victim, int64_t & chunk)
+{
+    for(unsigned int k = 1; k != tnum; ++k) {
+        unsigned int v = (tid + k) % tnum;
+        std::atomic<uint64_t> & remaining = slices[v].remaining;
+        uint64_t r = remaining.load(std::memory_order_relaxed);
+        while(Front(r) < Back(r)) {
+            if(remaining.compare_exchange_weak(r, Pack(Front(r), Back(r) - 1), std::memory_order_relaxed)) {
+                victim = v;
+                chunk = Back(r) - 1;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+inline bool ChunkScheduler::Next(unsigned int tid, int64_t & chunk)
+{
+    unsigned int victim;
+    return NextOwn(tid, chunk) || Steal(tid, victim, chunk);
+}
+
+inline int64_t ChunkScheduler::OwnEnd(unsigned int tid) const
+{
+    return Front(slices[tid].remaining.load(std::memory_order_relaxed));
+}
+
+inline int64_t ChunkScheduler::DefaultChunkSize(int64_t N, unsigned int tnum)
+{
+    int64_t const minchunk = 1 << 12;
+    int64_t const chunks_per_thread = 8;
+    int64_t c = (N + tnum * chunks_per_thread - 1) / (tnum * chunks_per_thread);
+    c = (c + 7) & ~int64_t(7);
+    return std::max(c, minchunk);
+}
+
+#endif
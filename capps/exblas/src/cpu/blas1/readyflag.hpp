@@ -0,0 +1,152 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas1/readyflag.hpp
+ *  \brief Provides the flags used by threads to signal each other during
+ *         the final parallel reduction of superaccumulators
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+
+#ifndef READYFLAG_HPP_INCLUDED
+#define READYFLAG_HPP_INCLUDED
+
+#include <atomic>
+#include <climits>
+#include <stdint.h>
+#include <immintrin.h>
+#include <sched.h>
+#include "mylibm.hpp"
+#ifdef __linux__
+    #include <unistd.h>
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+#endif
+
+/**
+ * \struct ReadyFlag
+ * \ingroup ExSUM
+ * \brief Per-thread counter of completed reduction steps.
+ *
+ *  Waiting is adaptive: the waiter first spins with _mm_pause, then yields its
+ *  time slice, and finally sleeps on a futex. Spinning alone is the fastest
+ *  when every thread owns a core, but burns whole time slices when threads are
+ *  oversubscribed or preempted, as the thread we wait for may not be running.
+ *  One flag starts and fills a cache line, so that flags of neighbouring
+ *  threads never share one. Arrays of flags, or of structures holding them,
+ *  must come from a cache-aligned allocation such as _mm_malloc.
+ */
+struct alignas(64) ReadyFlag
+{
+    ReadyFlag() : step(0), sleepers(0) {}
+
+    /**
+     * Resets the counter. Must not race with Signal or Wait on the same flag
+     */
+    void Reset();
+
+    /**
+     * Publishes that the owner thread has reached reduction step s.
+     * All the memory writes of the owner done before are visible to the
+     * threads returning from Wait(s)
+     * \param s step
+     */
+    void Signal(int32_t s);
+
+    /**
+     * Adds one to the counter, with the same guarantees as Signal.
+     * Unlike Signal, it can be called by several threads on the same flag
+     */
+    void Increment();
+
+    /**
+     * Blocks until the owner thread has reached reduction step s
+     * \param s step
+     */
+    void Wait(int32_t s);
+
+private:
+    static constexpr int spin_iterations = 1 << 10;
+    static constexpr int yield_iterations = 16;
+
+    void Sleep(int32_t seen);
+    void Wake();
+
+    std::atomic<int32_t> step;
+    std::atomic<int32_t> sleepers;
+    char padding[64 - 2 * sizeof(std::atomic<int32_t>)];
+};
+
+static_assert(sizeof(ReadyFlag) == 64, "ReadyFlag must fill one cache line");
+
+inline void ReadyFlag::Reset()
+{
+    step.store(0, std::memory_order_relaxed);
+    sleepers.store(0, std::memory_order_relaxed);
+}
+
+inline void ReadyFlag::Signal(int32_t s)
+{
+    // seq_cst store and load pair with the ones in Wait:
+    // either the waiter sees the new step, or we see the waiter
+    step.store(s, std::memory_order_seq_cst);
+    if(unlikely(sleepers.load(std::memory_order_seq_cst) != 0)) {
+        Wake();
+    }
+}
+
+inline void ReadyFlag::Increment()
+{
+    step.fetch_add(1, std::memory_order_seq_cst);
+    if(unlikely(sleepers.load(std::memory_order_seq_cst) != 0)) {
+        Wake();
+    }
+}
+
+inline void ReadyFlag::Wait(int32_t s)
+{
+    _mm_prefetch((char const*)&step, _MM_HINT_T0);
+    for(int iter = 0; ; ++iter) {
+        int32_t seen = step.load(std::memory_order_acquire);
+        if(seen >= s) {
+            return;
+        }
+        if(iter < spin_iterations) {
+            _mm_pause();
+        } else if(iter < spin_iterations + yield_iterations) {
+            sched_yield();
+        } else {
+            sleepers.fetch_add(1, std::memory_order_seq_cst);
+            seen = step.load(std::memory_order_seq_cst);
+            if(seen < s) {
+                Sleep(seen);
+            }
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+inline void ReadyFlag::Sleep(int32_t seen)
+{
+#ifdef __linux__
+    // Returns immediately if step != seen, so no wake-up can be lost
+    syscall(SYS_futex, reinterpret_cast<int32_t*>(&step), FUTEX_WAIT_PRIVATE, seen, NULL, NULL, 0);
+#else
+    sched_yield();
+#endif
+}
+
+inline void ReadyFlag::Wake()
+{
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<int32_t*>(&step), FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#endif
+}
+
+#endif
@@ -8,6 +8,7 @@
 #include <ostream>
 #include <cassert>
 #include <cmath>
+#include <algorithm>
 
 #include <iostream>
 
@@ -24,7 +25,7 @@ Superaccumulator::Superaccumulator(int e_bits, int f_bits) :
 Superaccumulator::Superaccumulator(std::vector<int64_t> acc, int e_bits, int f_bits) :
     f_words((f_bits + digits - 1) / digits),   // Round up
     e_words((e_bits + digits - 1) / digits),
-    accumulator(acc),
+    accumulator(acc.begin(), acc.end()),
     imax(f_words + e_words - 1), imin(0),
     status(Exact),
     overflow_counter((1ll<<K)-1)
@@ -65,6 +66,15 @@ void Superaccumulator::Accumulate(int64_t x, int exp)
 }
 
 
+void Superaccumulator::Reset()
+{
+    std::fill(accumulator.begin(), accumulator.end(), 0);
+    imin = 0;
+    imax = f_words + e_words - 1;
+    status = Exact;
+    overflow_counter = (1ll<<K)-1;
+}
+
 void Superaccumulator::Accumulate(Superaccumulator & other)
 {
     // Naive impl
@@ -89,13 +99,13 @@ double Superaccumulator::Round()
     int i;
     // Skip zeroes
     for(i = imax;
-        accumulator[i] == 0 && i >= imin;
+        i >= imin && accumulator[i] == 0;
         --i) {
     }
     if(negative) {
         // Skip ones
         for(;
-            (accumulator[i] & ((1ll << digits) - 1)) == ((1ll << digits) - 1) && i >= imin;
+            i >= imin && (accumulator[i] & ((1ll << digits) - 1)) == ((1ll << digits) - 1);
             --i) {
         }
     }
@@ -104,32 +114,35 @@ double Superaccumulator::Round()
     }
     
     int64_t hiword = negative ? ((1ll << digits) - 1) - accumulator[i] : accumulator[i];
-    double rounded = double(hiword);
-    double hi = ldexp(rounded, (i - f_words) * digits);
     if(i == 0) {
+        double hi = ldexp(double(hiword), (i - f_words) * digits);
         return negative ? -hi : hi;  // Correct rounding achieved
     }
-    hiword -= llrint(rounded);
-    double mid = ldexp(double(hiword), (i - f_words) * digits);
     
     // Compute sticky
     int64_t sticky = 0;
-    for(int j = imin; j != i - 1; ++j) {
-        sticky |= negative ? (1ll << digits) - accumulator[j] : accumulator[j];
+    for(int j = imin; j < i - 1; ++j) {
+        sticky |= accumulator[j];
     }
     
-    int64_t loword = negative ? (1ll << digits) - accumulator[i-1] : accumulator[i-1];
-    loword |=!! sticky;
-    double lo = ldexp(double(loword), (i - 1 - f_words) * digits);
+    // The magnitude of a negative value is the complement of its words, plus
+    // one that only carries into the second word when the words below are zero
+    int64_t loword = negative ? ((1ll << digits) - 1) - accumulator[i-1] + (sticky == 0) : accumulator[i-1];
     
- 
-    // Now add3(hi, mid, lo)
-    // No overlap, we have already normalized
-    if(mid != 0) {
-        lo = OddRoundSumNonnegative(mid, lo);
+    // Round the two leading words at once: converting them separately
+    // rounds twice whenever the result straddles the word boundary
+    unsigned __int128 v = ((unsigned __int128)hiword << digits) + (uint64_t)loword;
+    int nbits = 128 - (uint64_t(v >> 64) != 0 ? __builtin_clzll(uint64_t(v >> 64)) : 64 + __builtin_clzll(uint64_t(v)));
+    int shift = std::max(nbits - 53, 0);
+    uint64_t mant = uint64_t(v >> shift);
+    if(shift > 0) {
+        unsigned __int128 rem = v & (((unsigned __int128)1 << shift) - 1);
+        unsigned __int128 half = (unsigned __int128)1 << (shift - 1);
+        if(rem > half || (rem == half && (sticky != 0 || (mant & 1)))) {
+            ++mant;
+        }
     }
-    // Final rounding
-    hi = hi + lo;
+    double hi = ldexp(double(mant), (i - 1 - f_words) * digits + shift);
     return negative ? -hi : hi;
 }
 
@@ -20,6 +20,8 @@
 #include <stdint.h>
 #include <iosfwd>
 #include "mylibm.hpp"
+#include "cachealigned.hpp"
+#include "FPEStats.hpp"
 #include <cassert>
 #include <cmath>
 #include <cstdio>
@@ -65,6 +67,11 @@ struct Superaccumulator
      */ 
     void Accumulate(Superaccumulator & other);   // May modify (normalize) other member
 
+    /**
+     * Function to set the superaccumulator back to zero, keeping its storage
+     */
+    void Reset();
+
     /**
      * Function to perform correct rounding
      */
@@ -121,7 +128,7 @@ private:
 
 
     int f_words, e_words;
-    std::vector<int64_t> accumulator;
+    std::vector<int64_t, CacheAlignedAllocator<int64_t> > accumulator;
     int imin, imax;
     Status status;
     
@@ -142,6 +149,7 @@ inline void Superaccumulator::AccumulateWord(int64_t x, int i)
     int64_t oldword = xadd(accumulator[i], x, overflow);
     while(unlikely(overflow))
     {
+        FPEStatsCarry();
         // Carry or borrow
         // oldword has sign S
         // x has sign S
@@ -179,7 +187,9 @@ inline void Superaccumulator::Accumulate(double x)
     int exp_word = e / digits;  // Word containing MSbit (upper bound)
     int iup = exp_word + f_words;
     
-    double xscaled = myldexp(x, -digits * exp_word);
+    // myldexp adds to the exponent field, which subnormals do not use
+    double xscaled = unlikely(biased_exponent(x) == 0) ?
+        x * myldexp(1.0, -digits * exp_word) : myldexp(x, -digits * exp_word);
 
     int i;
     for(i = iup; xscaled != 0; --i) {
@@ -202,11 +212,11 @@ inline int Superaccumulator::get_e_words() {
 }
 
 inline std::vector<int64_t> Superaccumulator::get_accumulator(){
-    return accumulator;
+    return std::vector<int64_t>(accumulator.begin(), accumulator.end());
 }
 
 inline void Superaccumulator::set_accumulator(std::vector<int64_t> other){
-    accumulator = other;
+    accumulator.assign(other.begin(), other.end());
 }
 
 #endif
@@ -0,0 +1,164 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas1/workspace.hpp
+ *  \brief Provides the per-thread state of the reduction drivers, allocated
+ *         once and reused across calls. For internal use
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+
+#ifndef WORKSPACE_HPP_INCLUDED
+#define WORKSPACE_HPP_INCLUDED
+
+#include <vector>
+#include <new>
+#include <mm_malloc.h>
+#include "superaccumulator.hpp"
+#include "readyflag.hpp"
+#include "chunkscheduler.hpp"
+#include "cachealigned.hpp"
+
+/**
+ * \struct ThreadWorkspace
+ * \ingroup ExSUM
+ * \brief State of one thread during a reduction. Each instance starts on its
+ *  own cache line, so that neighbouring threads do not share lines
+ */
+struct alignas(64) ThreadWorkspace
+{
+    Superaccumulator acc;       /**< sum of the elements */
+    Superaccumulator mtsacc;    /**< maximum tail sum, for exmts */
+    ReadyFlag ready;            /**< progress in the reduction tree */
+    ReadyFlag stolen;           /**< chunks of our slice completed by other threads */
+
+    /**
+     * Sets the state back to the one of a new thread. Does not allocate
+     */
+    void Reset() {
+        acc.Reset();
+        mtsacc.Reset();
+        ready.Reset();
+        stolen.Reset();
+    }
+};
+
+/**
+ * \struct ChunkAccumulators
+ * \ingroup ExSUM
+ * \brief Superaccumulators of a chunk processed apart from the rest of a slice
+ */
+struct ChunkAccumulators
+{
+    Superaccumulator acc;       /**< sum of the elements */
+    Superaccumulator mtsacc;    /**< maximum tail sum */
+};
+
+/**
+ * \class Workspace
+ * \ingroup ExSUM
+ * \brief Arena of per-thread states used by ExSUMFPE and ExMTSFPE.
+ *
+ *  Each thread calling a reduction owns one arena. It only grows, so that
+ *  repeated calls do not allocate: a call only resets the states it uses.
+ */
+class Workspace
+{
+public:
+    /**
+     * Returns the arena of the calling thread
+     * \param nthreads number of threads the arena must hold
+     */
+    static Workspace & Get(unsigned int nthreads);
+
+    /**
+     * State of thread tid
+     */
+    ThreadWorkspace & operator[](unsigned int tid) { return slots[tid]; }
+
+    /**
+     * Schedule of chunks among threads
+     */
+    ChunkScheduler & Scheduler() { return *scheduler; }
+
+    /**
+     * Superaccumulators of stolen chunks, indexed by chunk. Entries are
+     * allocated on first use and kept for the next calls
+     * \param nchunks number of chunks
+     */
+    std::vector<ChunkAccumulators*> & Chunks(size_t nchunks);
+
+    ~Workspace();
+
+private:
+    Workspace() : slots(0), capacity(0), scheduler(0) {}
+    Workspace(Workspace const &);
+    Workspace & operator=(Workspace const &);
+
+    void Reserve(unsigned int nthreads);
+    void ReleaseSlots();
+
+    ThreadWorkspace * slots;
+    unsigned int capacity;
+    ChunkScheduler * scheduler;
+    std::vector<ChunkAccumulators*> chunks;
+};
+
+inline Workspace & Workspace::Get(unsigned int nthreads)
+{
+    static thread_local Workspace ws;
+    if(unlikely(nthreads > ws.capacity)) {
+        ws.Reserve(nthreads);
+    }
+    return ws;
+}
+
+inline std::vector<ChunkAccumulators*> & Workspace::Chunks(size_t nchunks)
+{
+    if(nchunks > chunks.size()) {
+        chunks.resize(nchunks, 0);
+    }
+    return chunks;
+}
+
+inline void Workspace::Reserve(unsigned int nthreads)
+{
+    ReleaseSlots();
+    slots = static_cast<ThreadWorkspace *>(_mm_malloc(nthreads * sizeof(ThreadWorkspace), cache_line_size));
+    if(!slots) {
+        throw std::bad_alloc();
+    }
+    for(unsigned int t = 0; t != nthreads; ++t) {
+        new (&slots[t]) ThreadWorkspace();
+    }
+    capacity = nthreads;
+    scheduler = new ChunkScheduler(nthreads);
+}
+
+inline void Workspace::ReleaseSlots()
+{
+    for(unsigned int t = 0; t != capacity; ++t) {
+        slots[t].~ThreadWorkspace();
+    }
+    _mm_free(slots);
+    delete scheduler;
+    slots = 0;
+    capacity = 0;
+    scheduler = 0;
+}
+
+inline Workspace::~Workspace()
+{
+    ReleaseSlots();
+    for(size_t c = 0; c != chunks.size(); ++c) {
+        delete chunks[c];
+    }
+}
+
+#endif
@@ -0,0 +1,225 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cassert>
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <mm_malloc.h>
+
+#include "ExGEMV.hpp"
+#include "blas2.hpp"
+
+// Rows of y per block of ExGEMVNoTrans: their expansions stay in L1 while a
+// column of the block is read
+#define GEMV_ROW_BLOCK 64
+// Columns per block of ExGEMVTrans and rows per panel of A: a panel of xs
+// stays in L2 while the columns of the block are read
+#define GEMVT_COL_BLOCK 32
+#define GEMVT_ROW_PANEL 4096
+
+
+static void DGEMV(const char transa, const int m, const int n, const double *a, const int lda, const double *xs, const double beta, double *y, const int incy);
+template<int N, typename TRAITS> static void ExGEMVFPE(const char transa, const int m, const int n, const double *a, const int lda, const double *xs, const double beta, double *y, const int incy);
+
+/*
+ * Parallel gemv based on our algorithm
+ * If fpe == 0, use superaccumulators only,
+ * If fpe == 1, use the plain, non-reproducible, algorithm,
+ * Otherwise, use floating-point expansions of size FPE with superaccumulators when needed
+ * early_exit corresponds to the early-exit technique
+ * As in the GPU version, alpha is applied to x before the exact accumulation
+ */
+int exgemv(const char transa, const int m, const int n, const double alpha, double *a, const int lda, const int offseta, double *x, const int incx, const int offsetx, const double beta, double *y, const int incy, const int offsety, const int fpe, const bool early_exit) {
+    if (fpe < 0 || fpe > 8) {
+        fprintf(stderr, "Size of floating-point expansion should be in the interval [0, 8]\n");
+        exit(1);
+    }
+    bool trans = (transa == 'T' || transa == 't');
+    if (!trans && transa != 'N' && transa != 'n') {
+        fprintf(stderr, "exgemv: transa should be 'T' or 'N', got '%c'\n", transa);
+        exit(1);
+    }
+    if (m <= 0 || n <= 0)
+        return 0;
+
+    // alpha*x, contiguous and padded to full vectors
+    int nx = trans ? m : n;
+    int nxpad = (nx + 3) & ~3;
+    double *xs = (double *) _mm_malloc(nxpad * sizeof(double), 32);
+    if (!xs) {
+        fprintf(stderr, "Cannot allocate memory for the scaled vector x\n");
+        exit(1);
+    }
+    for (int i = 0; i < nx; i++)
+        xs[i] = alpha * x[offsetx + i * incx];
+    std::fill(xs + nx, xs + nxpad, 0.);
+
+    a = a + offseta;
+    y = y + offsety;
+    if (fpe == 0) {
+        ExGEMVFPE<0, FPExpansionTraits<false> >(transa, m, n, a, lda, xs, beta, y, incy);
+    } else if (fpe == 1) {
+        DGEMV(transa, m, n, a, lda, xs, beta, y, incy);
+    } else if (early_exit) {
+        if (fpe <= 4)
+            ExGEMVFPE<4, FPExpansionTraits<true> >(transa, m, n, a, lda, xs, beta, y, incy);
+        else if (fpe <= 6)
+            ExGEMVFPE<6, FPExpansionTraits<true> >(transa, m, n, a, lda, xs, beta, y, incy);
+        else
+            ExGEMVFPE<8, FPExpansionTraits<true> >(transa, m, n, a, lda, xs, beta, y, incy);
+    } else { // ! early_exit
+        switch (fpe) {
+        case 2:
+            ExGEMVFPE<2, FPExpansionTraits<false> >(transa, m, n, a, lda, xs, beta, y, incy);
+            break;
+        case 3:
+            ExGEMVFPE<3, FPExpansionTraits<false> >(transa, m, n, a, lda, xs, beta, y, incy);
+            break;
+        case 4:
+            ExGEMVFPE<4, FPExpansionTraits<false> >(transa, m, n, a, lda, xs, beta, y, incy);
+            break;
+        case 5:
+            ExGEMVFPE<5, FPExpansionTraits<false> >(transa, m, n, a, lda, xs, beta, y, incy);
+            break;
+        case 6:
+            ExGEMVFPE<6, FPExpansionTraits<false> >(transa, m, n, a, lda, xs, beta, y, incy);
+            break;
+        case 7:
+            ExGEMVFPE<7, FPExpansionTraits<false> >(transa, m, n, a, lda, xs, beta, y, incy);
+            break;
+        default:
+            ExGEMVFPE<8, FPExpansionTraits<false> >(transa, m, n, a, lda, xs, beta, y, incy);
+        }
+    }
+
+    _mm_free(xs);
+    return 0;
+}
+
+template<int N, typename TRAITS> static void ExGEMVFPE(const char transa, const int m, const int n, const double *a, const int lda, const double *xs, const double beta, double *y, const int incy) {
+    if (transa == 'T' || transa == 't')
+        ExGEMVTrans<N, TRAITS>(m, n, a, lda, xs, beta, y, incy);
+    else
+        ExGEMVNoTrans<N, TRAITS>(m, n, a, lda, xs, beta, y, incy);
+}
+
+/*
+ * Plain gemv, for comparison
+ */
+static void DGEMV(const char transa, const int m, const int n, const double *a, const int lda, const double *xs, const double beta, double *y, const int incy) {
+    if (transa == 'T' || transa == 't') {
+        #pragma omp parallel for schedule(static)
+        for (int j = 0; j < n; j++) {
+            double sum = 0.0;
+            for (int i = 0; i < m; i++)
+                sum += a[(size_t) j * lda + i] * xs[i];
+            y[j * incy] = (beta == 0.0) ? sum : sum + beta * y[j * incy];
+        }
+    } else {
+        #pragma omp parallel for schedule(static)
+        for (int i = 0; i < m; i++) {
+            double sum = 0.0;
+            for (int j = 0; j < n; j++)
+                sum += a[(size_t) j * lda + i] * xs[j];
+            y[i * incy] = (beta == 0.0) ? sum : sum + beta * y[i * incy];
+        }
+    }
+}
+
+template<int N, typename TRAITS> void ExGEMVNoTrans(int m, int n, double const *a, int lda, double const *xs, double beta, double *y, int incy) {
+    typedef FPExpansionLanes<N, TRAITS> FPE;
+    int const mb = GEMV_ROW_BLOCK;
+    int nblocks = (m + mb - 1) / mb;
+
+    #pragma omp parallel
+    {
+        std::vector<Superaccumulator> accs(mb);
+        std::vector<FPE, CacheAlignedAllocator<FPE> > fpes;
+        fpes.reserve(mb / 4);
+        for (int g = 0; g != mb / 4; ++g)
+            fpes.emplace_back(&accs[4 * g]);
+
+        // Each row is computed by a single thread: no reduction needed
+        #pragma omp for schedule(static)
+        for (int ib = 0; ib < nblocks; ++ib) {
+            int i0 = ib * mb;
+            int rows = std::min(mb, m - i0);
+            int groups = (rows + 3) / 4;
+            for (int r = 0; r != mb; ++r)
+                accs[r].Reset();
+
+            for (int j = 0; j != n; ++j) {
+                if (xs[j] == 0.0)
+                    continue;
+                Vec4d xj(xs[j]);
+                double const *col = a + (size_t) j * lda + i0;
+                int g = 0;
+                for (; 4 * g + 4 <= rows; ++g)
+                    fpes[g].AccumulateProduct(Vec4d().load(col + 4 * g), xj);
+                if (g < groups)
+                    fpes[g].AccumulateProduct(Vec4d().load_partial(rows - 4 * g, col + 4 * g), xj);
+            }
+
+            if (beta != 0.0) {
+                for (int g = 0; g != groups; ++g) {
+                    double yg[4] = {0.0, 0.0, 0.0, 0.0};
+                    for (int l = 0; l != 4 && 4 * g + l < rows; ++l)
+                        yg[l] = y[(i0 + 4 * g + l) * incy];
+                    fpes[g].AccumulateProduct(Vec4d().load(yg), Vec4d(beta));
+                }
+            }
+            for (int g = 0; g != groups; ++g)
+                fpes[g].Flush();
+            for (int r = 0; r != rows; ++r)
+                y[(i0 + r) * incy] = accs[r].Round();
+        }
+    }
+}
+
+template<int N, typename TRAITS> void ExGEMVTrans(int m, int n, double const *a, int lda, double const *xs, double beta, double *y, int incy) {
+    typedef FPExpansionLanes<N, TRAITS, true> FPE;
+    int const nb = GEMVT_COL_BLOCK;
+    int const mb = GEMVT_ROW_PANEL;
+    int nblocks = (n + nb - 1) / nb;
+
+    #pragma omp parallel
+    {
+        std::vector<Superaccumulator> accs(nb);
+        std::vector<FPE, CacheAlignedAllocator<FPE> > fpes;
+        fpes.reserve(nb);
+        for (int c = 0; c != nb; ++c)
+            fpes.emplace_back(&accs[c]);
+
+        #pragma omp for schedule(static)
+        for (int jb = 0; jb < nblocks; ++jb) {
+            int j0 = jb * nb;
+            int cols = std::min(nb, n - j0);
+            for (int c = 0; c != nb; ++c)
+                accs[c].Reset();
+
+            for (int i0 = 0; i0 < m; i0 += mb) {
+                int rows = std::min(mb, m - i0);
+                for (int c = 0; c != cols; ++c) {
+                    double const *col = a + (size_t) (j0 + c) * lda + i0;
+                    int i = 0;
+                    for (; i + 4 <= rows; i += 4)
+                        fpes[c].AccumulateProduct(Vec4d().load(col + i), Vec4d().load_a(xs + i0 + i));
+                    if (i < rows)
+                        fpes[c].AccumulateProduct(Vec4d().load_partial(rows - i, col + i), Vec4d().load_a(xs + i0 + i));
+                }
+            }
+
+            for (int c = 0; c != cols; ++c) {
+                if (beta != 0.0)
+                    fpes[c].AccumulateProduct(Vec4d(y[(j0 + c) * incy], 0., 0., 0.), Vec4d(beta));
+                fpes[c].Flush();
+                y[(j0 + c) * incy] = accs[c].Round();
+            }
+        }
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas2/ExGEMV.hpp
+ *  \brief Provides a set of matrix-vector routines
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+
+#ifndef EXGEMV_HPP_
+#define EXGEMV_HPP_
+
+#include "superaccumulator.hpp"
+#include "ExGEMV_FPE.hpp"
+
+#include <omp.h>
+
+#include "common.hpp"
+
+
+/**
+ * \ingroup ExGEMV
+ * \brief Computes y := A*xs + beta*y with our multi-level reproducible and accurate
+ *     algorithm, relying upon floating-point expansions of size N (superaccumulators
+ *     only if N = 0). Each lane of the expansions holds a different row of y.
+ *     For internal use
+ *
+ * \param m the number of rows of matrix A
+ * \param n the number of columns of matrix A
+ * \param a matrix A, column-major
+ * \param lda leading dimension of A
+ * \param xs contiguous vector, already scaled by alpha
+ * \param beta scalar
+ * \param y vector
+ * \param incy the increment for the elements of y
+ */
+template<int N, typename TRAITS> void ExGEMVNoTrans(int m, int n, double const *a, int lda, double const *xs, double beta, double *y, int incy);
+
+/**
+ * \ingroup ExGEMV
+ * \brief Computes y := A**T*xs + beta*y with our multi-level reproducible and accurate
+ *     algorithm, relying upon floating-point expansions of size N (superaccumulators
+ *     only if N = 0). All lanes of an expansion hold the same element of y.
+ *     For internal use
+ *
+ * \param m the number of rows of matrix A
+ * \param n the number of columns of matrix A
+ * \param a matrix A, column-major
+ * \param lda leading dimension of A
+ * \param xs contiguous vector, already scaled by alpha and padded with zeros to a multiple of 4
+ * \param beta scalar
+ * \param y vector
+ * \param incy the increment for the elements of y
+ */
+template<int N, typename TRAITS> void ExGEMVTrans(int m, int n, double const *a, int lda, double const *xs, double beta, double *y, int incy);
+
+#endif // EXGEMV_HPP_
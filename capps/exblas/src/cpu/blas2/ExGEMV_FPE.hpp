@@ -0,0 +1,131 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas2/ExGEMV_FPE.hpp
+ *  \brief Provides floating-point expansions whose vector lanes belong to
+ *         different results, as needed by matrix-vector kernels
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+#ifndef EXGEMV_FPE_HPP_
+#define EXGEMV_FPE_HPP_
+
+#include "superaccumulator.hpp"
+#include "ExSUM_FPE.hpp"
+
+/**
+ * \struct FPExpansionLanes
+ * \ingroup ExGEMV
+ * \brief Floating-point expansion of size N on Vec4d, in conjunction with
+ *  superaccumulators. Unlike FPExpansionVect, each lane accumulates its own
+ *  result and overflows into its own superaccumulator, unless SHARED is set.
+ *  N = 0 accumulates into the superaccumulators directly
+ */
+template<int N, typename TRAITS=FPExpansionTraits<false>, bool SHARED=false>
+struct FPExpansionLanes
+{
+    /**
+     * Constructor
+     * \param sa superaccumulators of lanes 0 to 3, or the only one if SHARED
+     */
+    FPExpansionLanes(Superaccumulator * sa);
+
+    /**
+     * This function accumulates value x to the floating-point expansion
+     * \param x input value
+     */
+    void Accumulate(Vec4d x);
+
+    /**
+     * This function accumulates the exact product a*b
+     */
+    void AccumulateProduct(Vec4d a, Vec4d b);
+
+    /**
+     * This function is used to flush the floating-point expansion to the superaccumulators
+     */
+    void Flush();
+
+private:
+    // Static, so that the expansion can stay in registers around the calls
+    static void FlushVector(Superaccumulator * sa, Vec4d x);
+    static Vec4d twosum(Vec4d a, Vec4d b, Vec4d & s);
+
+    Superaccumulator * superacc;
+
+    // Most significant digits first!
+    Vec4d a[N > 0 ? N : 1] __attribute__((aligned(32)));
+};
+
+template<int N, typename TRAITS, bool SHARED>
+FPExpansionLanes<N,TRAITS,SHARED>::FPExpansionLanes(Superaccumulator * sa) :
+    superacc(sa)
+{
+    std::fill(a, a + (N > 0 ? N : 1), 0);
+}
+
+template<int N, typename TRAITS, bool SHARED> inline
+Vec4d FPExpansionLanes<N,TRAITS,SHARED>::twosum(Vec4d a, Vec4d b, Vec4d & s)
+{
+#if INSTRSET > 7                       // AVX2 and later
+    return FMA2Sum(a, b, s);
+#else
+    return Knuth2Sum(a, b, s);
+#endif
+}
+
+template<int N, typename TRAITS, bool SHARED> UNROLL_ATTRIBUTE INLINE_ATTRIBUTE inline
+void FPExpansionLanes<N,TRAITS,SHARED>::Accumulate(Vec4d x)
+{
+    Vec4d s;
+    for(int i = 0; i != N; ++i) {
+        a[i] = twosum(a[i], x, s);
+        x = s;
+        if(TRAITS::EarlyExit && i != 0 && !horizontal_or(x)) return;
+    }
+    if(horizontal_or(x)) {
+        FlushVector(superacc, x);
+    }
+}
+
+template<int N, typename TRAITS, bool SHARED> INLINE_ATTRIBUTE inline
+void FPExpansionLanes<N,TRAITS,SHARED>::AccumulateProduct(Vec4d x, Vec4d y)
+{
+    Vec4d r;
+    Vec4d p = TwoProductFMA(x, y, r);
+    Accumulate(p);
+    if(horizontal_or(r)) {
+        Accumulate(r);
+    }
+}
+
+template<int N, typename TRAITS, bool SHARED>
+void FPExpansionLanes<N,TRAITS,SHARED>::FlushVector(Superaccumulator * sa, Vec4d x)
+{
+    double v[4];
+    x.store(v);
+
+    _mm256_zeroupper();
+    for(unsigned int j = 0; j != 4; ++j) {
+        if(v[j] != 0) {
+            sa[SHARED ? 0 : j].Accumulate(v[j]);
+        }
+    }
+}
+
+template<int N, typename TRAITS, bool SHARED>
+void FPExpansionLanes<N,TRAITS,SHARED>::Flush()
+{
+    for(int i = 0; i != N; ++i) {
+        FlushVector(superacc, a[i]);
+        a[i] = 0;
+    }
+}
+
+#endif // EXGEMV_FPE_HPP_
@@ -0,0 +1,225 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cassert>
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+#include "ExSPMV.hpp"
+#include "blas2.hpp"
+
+// Rows with at most this many nonzeros are summed without the superaccumulator
+#define SPMV_SHORT_ROW 4
+
+
+static void DSPMV(const int nrows, const int *rowptr, const int *colidx, const double *vals, const double *x, double *y);
+
+/*
+ * Parallel sparse matrix-vector product based on our algorithm
+ * If fpe == 0, use superaccumulators only,
+ * If fpe == 1, use the plain, non-reproducible, algorithm,
+ * Otherwise, use floating-point expansions of size FPE with superaccumulators when needed
+ * early_exit corresponds to the early-exit technique
+ */
+int exspmv_csr(const int nrows, int *rowptr, int *colidx, double *vals, double *x, double *y, const int fpe, const bool early_exit) {
+    if (fpe < 0 || fpe > 8) {
+        fprintf(stderr, "Size of floating-point expansion should be in the interval [0, 8]\n");
+        exit(1);
+    }
+    if (nrows <= 0)
+        return 0;
+
+    if (fpe == 0) {
+        ExSPMVCSR<0, FPExpansionTraits<false> >(nrows, rowptr, colidx, vals, x, y);
+    } else if (fpe == 1) {
+        DSPMV(nrows, rowptr, colidx, vals, x, y);
+    } else if (early_exit) {
+        if (fpe <= 4)
+            ExSPMVCSR<4, FPExpansionTraits<true> >(nrows, rowptr, colidx, vals, x, y);
+        else if (fpe <= 6)
+            ExSPMVCSR<6, FPExpansionTraits<true> >(nrows, rowptr, colidx, vals, x, y);
+        else
+            ExSPMVCSR<8, FPExpansionTraits<true> >(nrows, rowptr, colidx, vals, x, y);
+    } else { // ! early_exit
+        switch (fpe) {
+        case 2:
+            ExSPMVCSR<2, FPExpansionTraits<false> >(nrows, rowptr, colidx, vals, x, y);
+            break;
+        case 3:
+            ExSPMVCSR<3, FPExpansionTraits<false> >(nrows, rowptr, colidx, vals, x, y);
+            break;
+        case 4:
+            ExSPMVCSR<4, FPExpansionTraits<false> >(nrows, rowptr, colidx, vals, x, y);
+            break;
+        case 5:
+            ExSPMVCSR<5, FPExpansionTraits<false> >(nrows, rowptr, colidx, vals, x, y);
+            break;
+        case 6:
+            ExSPMVCSR<6, FPExpansionTraits<false> >(nrows, rowptr, colidx, vals, x, y);
+            break;
+        case 7:
+            ExSPMVCSR<7, FPExpansionTraits<false> >(nrows, rowptr, colidx, vals, x, y);
+            break;
+        default:
+            ExSPMVCSR<8, FPExpansionTraits<false> >(nrows, rowptr, colidx, vals, x, y);
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Plain sparse matrix-vector product, for comparison
+ */
+static void DSPMV(const int nrows, const int *rowptr, const int *colidx, const double *vals, const double *x, double *y) {
+    #pragma omp parallel for schedule(static)
+    for (int i = 0; i < nrows; i++) {
+        double sum = 0.0;
+        for (int k = rowptr[i]; k < rowptr[i + 1]; k++)
+            sum += vals[k] * x[colidx[k]];
+        y[i] = sum;
+    }
+}
+
+/*
+ * Accumulates the exact products of the nonzeros [l, r) of a row with the
+ * matching elements of x
+ */
+template<typename FPE> static inline void AccumulateSegment(FPE & fpe, int const *colidx, double const *vals, double const *x, int64_t l, int64_t r) {
+    int64_t k = l;
+    for (; k + 4 <= r; k += 4)
+        fpe.AccumulateProduct(Vec4d().load(vals + k), Vec4d(x[colidx[k]], x[colidx[k + 1]], x[colidx[k + 2]], x[colidx[k + 3]]));
+    if (k < r) {
+        double xk[4] = {0.0, 0.0, 0.0, 0.0};
+        for (int j = 0; k + j < r; ++j)
+            xk[j] = x[colidx[k + j]];
+        fpe.AccumulateProduct(Vec4d().load_partial(int(r - k), vals + k), Vec4d().load(xk));
+    }
+}
+
+/*
+ * Correctly rounded dot product of a row with at most SPMV_SHORT_ROW nonzeros,
+ * from the exact expansion of its products. The two leading components of the
+ * expansion are added, and their sum is the result when the remaining terms
+ * cannot move it past a midpoint. Returns false otherwise, or when a value is
+ * not finite, and the row then goes through the superaccumulator
+ */
+static inline bool ShortRowDot(int const *colidx, double const *vals, double const *x, int64_t l, int64_t r, double & y) {
+    // Nonoverlapping components, by increasing magnitude
+    double h[2 * SPMV_SHORT_ROW + 1];
+    int m = 0;
+    for (int64_t k = l; k < r; ++k) {
+        double a = vals[k], b = x[colidx[k]];
+        double p = a * b;
+        double terms[2] = {p, std::fma(a, b, -p)};
+        for (int t = 0; t != 2; ++t) {
+            // Grow the expansion by one term, dropping zero components
+            double q = terms[t];
+            int n = 0;
+            for (int i = 0; i != m; ++i) {
+                double sum = q + h[i];
+                double bv = sum - q;
+                double err = (q - (sum - bv)) + (h[i] - bv);
+                if (err != 0.0)
+                    h[n++] = err;
+                q = sum;
+            }
+            h[n++] = q;
+            m = n;
+        }
+    }
+    if (m == 0) {
+        y = 0.0;
+        return true;
+    }
+
+    double s = h[m - 1], e = 0.0;
+    if (m > 1) {
+        s = h[m - 1] + h[m - 2];
+        double bv = s - h[m - 1];
+        e = (h[m - 1] - (s - bv)) + (h[m - 2] - bv);
+    }
+    // The smaller components sum to less than twice the largest of them
+    double tail = 0.0;
+    for (int i = 0; i < m - 2; ++i)
+        tail += std::fabs(h[i]);
+    tail *= 1.0 + std::ldexp(1.0, -50);
+    if (s == 0.0) {
+        y = 0.0;
+        return e == 0.0 && tail == 0.0;
+    }
+    // Half the gap to the neighbour towards zero, the smaller one
+    double half = 0.5 * std::fabs(s - std::nextafter(s, 0.0));
+    y = s;
+    return std::fabs(e) + tail < half;
+}
+
+template<int N, typename TRAITS> void ExSPMVCSR(int nrows, int const *rowptr, int const *colidx, double const *vals, double const *x, double *y) {
+    typedef FPExpansionLanes<N, TRAITS, true> FPE;
+    int64_t base = rowptr[0];
+    int64_t nnz = rowptr[nrows] - base;
+    int maxthreads = omp_get_max_threads();
+    // Part of a row accumulated by a thread other than the one it starts in
+    std::vector<Superaccumulator> heads(maxthreads);
+    std::vector<int> headrow(maxthreads);
+
+    #pragma omp parallel
+    {
+        int tid = omp_get_thread_num();
+        int tnum = omp_get_num_threads();
+        // Nonzeros [b, e) of the thread
+        int64_t b = base + nnz * tid / tnum;
+        int64_t e = base + nnz * (tid + 1) / tnum;
+
+        // Head: end of the row that crosses b
+        headrow[tid] = -1;
+        if (b < e) {
+            int i = int(std::upper_bound(rowptr, rowptr + nrows + 1, b) - rowptr) - 1;
+            if (rowptr[i] < b) {
+                heads[tid].Reset();
+                FPE h(&heads[tid]);
+                AccumulateSegment(h, colidx, vals, x, b, std::min<int64_t>(rowptr[i + 1], e));
+                h.Flush();
+                heads[tid].Normalize();
+                headrow[tid] = i;
+            }
+        }
+
+        // Rows that start in [b, e), complete except for the last one
+        Superaccumulator acc;
+        FPE fpe(&acc);
+        int first = int(std::lower_bound(rowptr, rowptr + nrows, b) - rowptr);
+        int last = (tid == tnum - 1) ? nrows : int(std::lower_bound(rowptr, rowptr + nrows, e) - rowptr);
+        int split = -1;
+        for (int i = first; i < last; ++i) {
+            if (rowptr[i + 1] <= e && rowptr[i + 1] - rowptr[i] <= SPMV_SHORT_ROW
+                && ShortRowDot(colidx, vals, x, rowptr[i], rowptr[i + 1], y[i]))
+                continue;
+            AccumulateSegment(fpe, colidx, vals, x, rowptr[i], std::min<int64_t>(rowptr[i + 1], e));
+            fpe.Flush();
+            if (rowptr[i + 1] > e) {
+                split = i;
+                break;
+            }
+            y[i] = acc.Round();
+            acc.Reset();
+        }
+
+        // The heads of the following threads complete the split row. Threads
+        // without nonzeros may sit among them when nnz < tnum
+        #pragma omp barrier
+        if (split >= 0) {
+            for (int t = tid + 1; t < tnum; ++t) {
+                if (headrow[t] == split)
+                    acc.Accumulate(heads[t]);
+            }
+            y[split] = acc.Round();
+        }
+    }
+}
@@ -0,0 +1,45 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas2/ExSPMV.hpp
+ *  \brief Provides a set of sparse matrix-vector routines
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+
+#ifndef EXSPMV_HPP_
+#define EXSPMV_HPP_
+
+#include "superaccumulator.hpp"
+#include "ExGEMV_FPE.hpp"
+
+#include <omp.h>
+
+#include "common.hpp"
+
+
+/**
+ * \ingroup ExSPMV
+ * \brief Computes y := A*x, for A in CSR format, with our multi-level reproducible
+ *     and accurate algorithm, relying upon floating-point expansions of size N
+ *     (superaccumulators only if N = 0). All lanes of an expansion hold the same
+ *     row. The nonzeros are split evenly among threads; a row that crosses a
+ *     split is accumulated by several threads and merged exactly.
+ *     For internal use
+ *
+ * \param nrows the number of rows of matrix A
+ * \param rowptr positions of the first nonzero of each row in colidx and vals, nrows + 1 entries
+ * \param colidx column of each nonzero
+ * \param vals value of each nonzero
+ * \param x vector
+ * \param y vector
+ */
+template<int N, typename TRAITS> void ExSPMVCSR(int nrows, int const *rowptr, int const *colidx, double const *vals, double const *x, double *y);
+
+#endif // EXSPMV_HPP_
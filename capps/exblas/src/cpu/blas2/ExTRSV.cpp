@@ -0,0 +1,340 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cassert>
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <mm_malloc.h>
+
+#include "ExTRSV.hpp"
+#include "blas2.hpp"
+
+// Size of the diagonal blocks: solved by a single thread, before the rows
+// below them are updated in parallel
+#define TRSV_BLOCK 64
+// Rows per task of the update of ExTRSVNoTrans: their expansions stay in L1
+// while a column of the diagonal block is read
+#define TRSV_ROW_BLOCK 64
+
+
+static void DTRSV(const bool trans, const bool forward, const bool unit, const int n, const double *a, const int lda, const double *b, double *x);
+static void ExTRSVFPE(const int fpe, const bool early_exit, const bool trans, const bool forward, const bool unit, const int n, const double *a, const int lda, const double *b, double *x, double *r);
+
+/*
+ * Parallel trsv based on our algorithm
+ * If fpe == 0, use superaccumulators only,
+ * If fpe == 1, use the plain, non-reproducible, algorithm,
+ * If 2 <= fpe <= 8, use floating-point expansions of size FPE with superaccumulators when needed,
+ * If 10 <= fpe <= 18, solve as with fpe - 10 (superaccumulators only for 10 and 11),
+ *     then refine once: r = b - A*x, A*d = r, x = x + d, with r computed exactly,
+ * If fpe == 20, use the plain algorithm, and if 21 <= fpe <= 28 refine its result
+ *     as above, as DTRSVExIR does on GPUs
+ * early_exit corresponds to the early-exit technique
+ */
+int extrsv(const char uplo, const char transa, const char diag, const int n, double *a, const int lda, const int offseta, double *x, const int incx, const int offsetx, const int fpe, const bool early_exit) {
+    if (fpe < 0 || fpe > 28 || fpe % 10 == 9) {
+        fprintf(stderr, "Size of floating-point expansion should be in the interval [0, 8], or in [10, 18] and [20, 28] with iterative refinement\n");
+        exit(1);
+    }
+    bool lower = (uplo == 'L' || uplo == 'l');
+    if (!lower && uplo != 'U' && uplo != 'u') {
+        fprintf(stderr, "extrsv: uplo should be 'U' or 'L', got '%c'\n", uplo);
+        exit(1);
+    }
+    bool trans = (transa == 'T' || transa == 't');
+    if (!trans && transa != 'N' && transa != 'n') {
+        fprintf(stderr, "extrsv: transa should be 'T' or 'N', got '%c'\n", transa);
+        exit(1);
+    }
+    bool unit = (diag == 'U' || diag == 'u');
+    if (!unit && diag != 'N' && diag != 'n') {
+        fprintf(stderr, "extrsv: diag should be 'U' or 'N', got '%c'\n", diag);
+        exit(1);
+    }
+    if (n <= 0)
+        return 0;
+
+    // b and x, contiguous and padded to full vectors
+    int npad = (n + 3) & ~3;
+    double *b = (double *) _mm_malloc(npad * sizeof(double), 32);
+    double *xs = (double *) _mm_malloc(npad * sizeof(double), 32);
+    if (!b || !xs) {
+        fprintf(stderr, "Cannot allocate memory for the vector x\n");
+        exit(1);
+    }
+    for (int i = 0; i < n; i++)
+        b[i] = x[offsetx + i * incx];
+    std::fill(b + n, b + npad, 0.);
+    std::fill(xs, xs + npad, 0.);
+
+    a = a + offseta;
+    // Rows of op(A) are solved from the first one for lower A and upper A**T
+    bool forward = (lower != trans);
+    if (fpe == 1 || fpe >= 20)
+        DTRSV(trans, forward, unit, n, a, lda, b, xs);
+    else
+        ExTRSVFPE(fpe % 10, early_exit, trans, forward, unit, n, a, lda, b, xs, NULL);
+
+    if (fpe >= 10 && fpe != 20) {
+        double *r = (double *) _mm_malloc(npad * sizeof(double), 32);
+        double *d = (double *) _mm_malloc(npad * sizeof(double), 32);
+        if (!r || !d) {
+            fprintf(stderr, "Cannot allocate memory for the iterative refinement\n");
+            exit(1);
+        }
+        std::fill(r, r + npad, 0.);
+        std::fill(d, d + npad, 0.);
+        ExTRSVFPE(fpe % 10, early_exit, trans, forward, unit, n, a, lda, b, xs, r);
+        ExTRSVFPE(fpe % 10, early_exit, trans, forward, unit, n, a, lda, r, d, NULL);
+        for (int i = 0; i < n; i++)
+            xs[i] = xs[i] + d[i];
+        _mm_free(r);
+        _mm_free(d);
+    }
+
+    for (int i = 0; i < n; i++)
+        x[offsetx + i * incx] = xs[i];
+    _mm_free(b);
+    _mm_free(xs);
+    return 0;
+}
+
+template<int N, typename TRAITS> static void ExTRSVLayout(const bool trans, const bool forward, const bool unit, const int n, const double *a, const int lda, const double *b, double *x, double *r) {
+    if (trans)
+        ExTRSVTrans<N, TRAITS>(forward, unit, n, a, lda, b, x, r);
+    else
+        ExTRSVNoTrans<N, TRAITS>(forward, unit, n, a, lda, b, x, r);
+}
+
+static void ExTRSVFPE(const int fpe, const bool early_exit, const bool trans, const bool forward, const bool unit, const int n, const double *a, const int lda, const double *b, double *x, double *r) {
+    if (fpe <= 1) {
+        ExTRSVLayout<0, FPExpansionTraits<false> >(trans, forward, unit, n, a, lda, b, x, r);
+    } else if (early_exit) {
+        if (fpe <= 4)
+            ExTRSVLayout<4, FPExpansionTraits<true> >(trans, forward, unit, n, a, lda, b, x, r);
+        else if (fpe <= 6)
+            ExTRSVLayout<6, FPExpansionTraits<true> >(trans, forward, unit, n, a, lda, b, x, r);
+        else
+            ExTRSVLayout<8, FPExpansionTraits<true> >(trans, forward, unit, n, a, lda, b, x, r);
+    } else { // ! early_exit
+        switch (fpe) {
+        case 2:
+            ExTRSVLayout<2, FPExpansionTraits<false> >(trans, forward, unit, n, a, lda, b, x, r);
+            break;
+        case 3:
+            ExTRSVLayout<3, FPExpansionTraits<false> >(trans, forward, unit, n, a, lda, b, x, r);
+            break;
+        case 4:
+            ExTRSVLayout<4, FPExpansionTraits<false> >(trans, forward, unit, n, a, lda, b, x, r);
+            break;
+        case 5:
+            ExTRSVLayout<5, FPExpansionTraits<false> >(trans, forward, unit, n, a, lda, b, x, r);
+            break;
+        case 6:
+            ExTRSVLayout<6, FPExpansionTraits<false> >(trans, forward, unit, n, a, lda, b, x, r);
+            break;
+        case 7:
+            ExTRSVLayout<7, FPExpansionTraits<false> >(trans, forward, unit, n, a, lda, b, x, r);
+            break;
+        default:
+            ExTRSVLayout<8, FPExpansionTraits<false> >(trans, forward, unit, n, a, lda, b, x, r);
+        }
+    }
+}
+
+/*
+ * Plain trsv, for comparison
+ */
+static void DTRSV(const bool trans, const bool forward, const bool unit, const int n, const double *a, const int lda, const double *b, double *x) {
+    if (trans) {
+        for (int t = 0; t < n; t++) {
+            int i = forward ? t : n - 1 - t;
+            int lo = forward ? 0 : i + 1;
+            int hi = forward ? i : n;
+            double sum = b[i];
+            for (int j = lo; j < hi; j++)
+                sum -= a[(size_t) i * lda + j] * x[j];
+            x[i] = unit ? sum : sum / a[(size_t) i * lda + i];
+        }
+    } else {
+        std::copy(b, b + n, x);
+        for (int t = 0; t < n; t++) {
+            int j = forward ? t : n - 1 - t;
+            int lo = forward ? j + 1 : 0;
+            int hi = forward ? n : j;
+            if (!unit)
+                x[j] = x[j] / a[(size_t) j * lda + j];
+            for (int i = lo; i < hi; i++)
+                x[i] -= a[(size_t) j * lda + i] * x[j];
+        }
+    }
+}
+
+/*
+ * Ends row i, whose accumulator holds b_i - sum_{j != i} a_ij*x_j exactly:
+ * either computes x_i, or the residual r_i of the given x_i
+ */
+static inline void TRSVEndRow(Superaccumulator & acc, double aii, bool unit, double & xi, double *ri) {
+    if (ri) {
+        double d = unit ? 1.0 : aii;
+        double p = -d * xi;
+        double e = std::fma(-d, xi, -p);
+        acc.Accumulate(p);
+        if (e != 0.0)
+            acc.Accumulate(e);
+        *ri = acc.Round();
+    } else {
+        xi = acc.Round();
+        if (!unit)
+            xi = xi / aii;
+    }
+}
+
+/*
+ * Accumulates the exact dot product of u and v over [lo, hi)
+ */
+template<typename FPE> static inline void TRSVAccumulateDot(FPE & fpe, double const *u, double const *v, int lo, int hi) {
+    int j = lo;
+    for (; j + 4 <= hi; j += 4)
+        fpe.AccumulateProduct(Vec4d().load(u + j), Vec4d().load(v + j));
+    if (j < hi)
+        fpe.AccumulateProduct(Vec4d().load_partial(hi - j, u + j), Vec4d().load_partial(hi - j, v + j));
+}
+
+template<int N, typename TRAITS> void ExTRSVNoTrans(bool forward, bool unit, int n, double const *a, int lda, double const *b, double *x, double *r) {
+    typedef FPExpansionLanes<N, TRAITS> FPE;
+    int const nb = TRSV_BLOCK;
+    int const mb = TRSV_ROW_BLOCK;
+    int nblocks = (n + nb - 1) / nb;
+    int ngroups = (n + 3) / 4;
+
+    // Row i accumulates in lane i % 4 of fpes[i / 4] and in accs[i]
+    std::vector<Superaccumulator> accs(4 * ngroups);
+    std::vector<FPE, CacheAlignedAllocator<FPE> > fpes;
+    fpes.reserve(ngroups);
+    for (int g = 0; g != ngroups; ++g)
+        fpes.emplace_back(&accs[4 * g]);
+    double *xneg = (double *) _mm_malloc(4 * ngroups * sizeof(double), 32);
+    if (!xneg) {
+        fprintf(stderr, "Cannot allocate memory for the vector x\n");
+        exit(1);
+    }
+    std::fill(xneg, xneg + 4 * ngroups, 0.);
+
+    #pragma omp parallel
+    {
+        #pragma omp for schedule(static)
+        for (int g = 0; g < ngroups; ++g)
+            fpes[g].Accumulate(Vec4d().load(b + 4 * g));
+
+        for (int s = 0; s < nblocks; ++s) {
+            int kb = forward ? s : nblocks - 1 - s;
+            int j0 = kb * nb;
+            int j1 = std::min(n, j0 + nb);
+
+            // Substitution within the diagonal block, one column at a time
+            #pragma omp single
+            for (int t = 0; t < j1 - j0; ++t) {
+                int i = forward ? j0 + t : j1 - 1 - t;
+                fpes[i / 4].Flush();
+                TRSVEndRow(accs[i], a[(size_t) i * lda + i], unit, x[i], r ? r + i : NULL);
+                xneg[i] = -x[i];
+
+                int lo = forward ? i + 1 : j0;
+                int hi = forward ? j1 : i;
+                if (lo >= hi || xneg[i] == 0.0)
+                    continue;
+                double const *col = a + (size_t) i * lda;
+                for (int g = lo / 4; g <= (hi - 1) / 4; ++g) {
+                    double v[4];
+                    for (int l = 0; l != 4; ++l)
+                        v[l] = (4 * g + l >= lo && 4 * g + l < hi) ? col[4 * g + l] : 0.0;
+                    fpes[g].AccumulateProduct(Vec4d().load(v), Vec4d(xneg[i]));
+                }
+            }
+
+            // Update of the rows of the following blocks, each by a single thread
+            int i0 = forward ? j1 : 0;
+            int i1 = forward ? n : j0;
+            int ntasks = (i1 - i0 + mb - 1) / mb;
+            #pragma omp for schedule(static)
+            for (int ib = 0; ib < ntasks; ++ib) {
+                int g0 = (i0 + ib * mb) / 4;
+                int g1 = (std::min(i1, i0 + (ib + 1) * mb) + 3) / 4;
+                for (int j = j0; j != j1; ++j) {
+                    if (xneg[j] == 0.0)
+                        continue;
+                    Vec4d xj(xneg[j]);
+                    double const *col = a + (size_t) j * lda;
+                    int g = g0;
+                    for (; g != g1 && 4 * g + 4 <= n; ++g)
+                        fpes[g].AccumulateProduct(Vec4d().load(col + 4 * g), xj);
+                    if (g != g1)
+                        fpes[g].AccumulateProduct(Vec4d().load_partial(n - 4 * g, col + 4 * g), xj);
+                }
+            }
+        }
+    }
+
+    _mm_free(xneg);
+}
+
+template<int N, typename TRAITS> void ExTRSVTrans(bool forward, bool unit, int n, double const *a, int lda, double const *b, double *x, double *r) {
+    typedef FPExpansionLanes<N, TRAITS, true> FPE;
+    int const nb = TRSV_BLOCK;
+    int nblocks = (n + nb - 1) / nb;
+
+    // Row i accumulates in all lanes of fpes[i] and in accs[i]
+    std::vector<Superaccumulator> accs(n);
+    std::vector<FPE, CacheAlignedAllocator<FPE> > fpes;
+    fpes.reserve(n);
+    for (int i = 0; i != n; ++i)
+        fpes.emplace_back(&accs[i]);
+    double *xneg = (double *) _mm_malloc(n * sizeof(double), 32);
+    if (!xneg) {
+        fprintf(stderr, "Cannot allocate memory for the vector x\n");
+        exit(1);
+    }
+    std::fill(xneg, xneg + n, 0.);
+
+    #pragma omp parallel
+    {
+        #pragma omp for schedule(static)
+        for (int i = 0; i < n; ++i)
+            accs[i].Accumulate(b[i]);
+
+        for (int s = 0; s < nblocks; ++s) {
+            int kb = forward ? s : nblocks - 1 - s;
+            int j0 = kb * nb;
+            int j1 = std::min(n, j0 + nb);
+
+            // Substitution within the diagonal block, one row at a time
+            #pragma omp single
+            for (int t = 0; t < j1 - j0; ++t) {
+                int i = forward ? j0 + t : j1 - 1 - t;
+                if (forward)
+                    TRSVAccumulateDot(fpes[i], a + (size_t) i * lda, xneg, j0, i);
+                else
+                    TRSVAccumulateDot(fpes[i], a + (size_t) i * lda, xneg, i + 1, j1);
+                fpes[i].Flush();
+                TRSVEndRow(accs[i], a[(size_t) i * lda + i], unit, x[i], r ? r + i : NULL);
+                xneg[i] = -x[i];
+            }
+
+            // Update of the rows of the following blocks, each by a single thread
+            int i0 = forward ? j1 : 0;
+            int i1 = forward ? n : j0;
+            #pragma omp for schedule(static)
+            for (int i = i0; i < i1; ++i)
+                TRSVAccumulateDot(fpes[i], a + (size_t) i * lda, xneg, j0, j1);
+        }
+    }
+
+    _mm_free(xneg);
+}
@@ -0,0 +1,67 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas2/ExTRSV.hpp
+ *  \brief Provides a set of triangular solvers
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+
+#ifndef EXTRSV_HPP_
+#define EXTRSV_HPP_
+
+#include "superaccumulator.hpp"
+#include "ExGEMV_FPE.hpp"
+
+#include <omp.h>
+
+#include "common.hpp"
+
+
+/**
+ * \ingroup ExTRSV
+ * \brief Solves A*x = b with our multi-level reproducible and accurate algorithm,
+ *     relying upon floating-point expansions of size N (superaccumulators only
+ *     if N = 0). Each row accumulates b_i - sum_j a_ij*x_j exactly, in a lane of
+ *     the expansions and in its own superaccumulator, and x_i is this sum rounded
+ *     then divided by a_ii. The matrix is processed by diagonal blocks: the block
+ *     is solved by substitution, then the rows of the following blocks receive
+ *     its contribution in parallel.
+ *     If r is not null, x is given instead and r receives b - A*x rounded once.
+ *     For internal use
+ *
+ * \param forward whether rows are solved from the first one (lower A) or from the last one (upper A)
+ * \param unit whether A has a unit diagonal
+ * \param n size of matrix A
+ * \param a matrix A, column-major
+ * \param lda leading dimension of A
+ * \param b contiguous right-hand side
+ * \param x contiguous solution
+ * \param r contiguous residual, or null
+ */
+template<int N, typename TRAITS> void ExTRSVNoTrans(bool forward, bool unit, int n, double const *a, int lda, double const *b, double *x, double *r);
+
+/**
+ * \ingroup ExTRSV
+ * \brief Solves A**T*x = b as ExTRSVNoTrans, except that rows of A**T are
+ *     contiguous: all lanes of an expansion hold the same row.
+ *     For internal use
+ *
+ * \param forward whether rows are solved from the first one (upper A) or from the last one (lower A)
+ * \param unit whether A has a unit diagonal
+ * \param n size of matrix A
+ * \param a matrix A, column-major
+ * \param lda leading dimension of A
+ * \param b contiguous right-hand side
+ * \param x contiguous solution
+ * \param r contiguous residual, or null
+ */
+template<int N, typename TRAITS> void ExTRSVTrans(bool forward, bool unit, int n, double const *a, int lda, double const *b, double *x, double *r);
+
+#endif // EXTRSV_HPP_
@@ -0,0 +1,252 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cassert>
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <mm_malloc.h>
+
+#include "ExGEMM.hpp"
+#include "blas3.hpp"
+
+// Macro-tile of C computed by a thread, with one superaccumulator per element
+#define GEMM_MC 64
+#define GEMM_NC 64
+// Depth of the packed panels: a 4 x KC micro-panel of A and a KC x 4 one of B
+// stay in L1, the MC x KC panel of A in L2
+#define GEMM_KC 256
+
+
+static void DGEMM(const bool transa, const bool transb, const int m, const int n, const int k, const double alpha, const double *a, const int lda, const double *b, const int ldb, const double beta, double *c, const int ldc);
+
+/*
+ * Parallel gemm based on our algorithm
+ * If fpe == 0, use superaccumulators only,
+ * If fpe == 1, use the plain, non-reproducible, algorithm,
+ * Otherwise, use floating-point expansions of size FPE with superaccumulators when needed
+ * early_exit corresponds to the early-exit technique
+ * As in exgemv, alpha is applied to A before the exact accumulation, and beta*C
+ * is accumulated exactly with op(A)*op(B)
+ */
+int exgemm(char transa, char transb, int m, int n, int k, double alpha, double *a, int lda, double *b, int ldb, double beta, double *c, int ldc, int fpe, bool early_exit) {
+    if (fpe < 0 || fpe > 8) {
+        fprintf(stderr, "Size of floating-point expansion should be in the interval [0, 8]\n");
+        exit(1);
+    }
+    bool ta = (transa == 'T' || transa == 't');
+    if (!ta && transa != 'N' && transa != 'n') {
+        fprintf(stderr, "exgemm: transa should be 'T' or 'N', got '%c'\n", transa);
+        exit(1);
+    }
+    bool tb = (transb == 'T' || transb == 't');
+    if (!tb && transb != 'N' && transb != 'n') {
+        fprintf(stderr, "exgemm: transb should be 'T' or 'N', got '%c'\n", transb);
+        exit(1);
+    }
+    if (m <= 0 || n <= 0)
+        return 0;
+    k = std::max(k, 0);
+
+    if (fpe == 0) {
+        ExGEMMPacked<0, FPExpansionTraits<false> >(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    } else if (fpe == 1) {
+        DGEMM(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    } else if (early_exit) {
+        if (fpe <= 4)
+            ExGEMMPacked<4, FPExpansionTraits<true> >(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        else if (fpe <= 6)
+            ExGEMMPacked<6, FPExpansionTraits<true> >(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        else
+            ExGEMMPacked<8, FPExpansionTraits<true> >(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+    } else { // ! early_exit
+        switch (fpe) {
+        case 2:
+            ExGEMMPacked<2, FPExpansionTraits<false> >(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+            break;
+        case 3:
+            ExGEMMPacked<3, FPExpansionTraits<false> >(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+            break;
+        case 4:
+            ExGEMMPacked<4, FPExpansionTraits<false> >(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+            break;
+        case 5:
+            ExGEMMPacked<5, FPExpansionTraits<false> >(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+            break;
+        case 6:
+            ExGEMMPacked<6, FPExpansionTraits<false> >(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+            break;
+        case 7:
+            ExGEMMPacked<7, FPExpansionTraits<false> >(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+            break;
+        default:
+            ExGEMMPacked<8, FPExpansionTraits<false> >(ta, tb, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Plain gemm, for comparison
+ */
+static void DGEMM(const bool transa, const bool transb, const int m, const int n, const int k, const double alpha, const double *a, const int lda, const double *b, const int ldb, const double beta, double *c, const int ldc) {
+    #pragma omp parallel for schedule(static)
+    for (int j = 0; j < n; j++) {
+        for (int i = 0; i < m; i++) {
+            double sum = 0.0;
+            for (int p = 0; p < k; p++) {
+                double aip = transa ? a[(size_t) i * lda + p] : a[(size_t) p * lda + i];
+                double bpj = transb ? b[(size_t) p * ldb + j] : b[(size_t) j * ldb + p];
+                sum += aip * bpj;
+            }
+            double *cij = c + (size_t) j * ldc + i;
+            *cij = (beta == 0.0) ? alpha * sum : alpha * sum + beta * *cij;
+        }
+    }
+}
+
+/*
+ * Packs rows [i0, i0 + mc) and columns [p0, p0 + kc) of alpha*op(A) into
+ * 4 x kc micro-panels, stored column after column, padded with zero rows
+ */
+static void PackA(bool transa, int mc, int kc, double alpha, double const *a, int lda, int i0, int p0, double *ap) {
+    for (int ir = 0; ir < mc; ir += 4) {
+        for (int p = 0; p < kc; ++p) {
+            for (int l = 0; l != 4; ++l) {
+                int i = i0 + ir + l;
+                double v = 0.0;
+                if (ir + l < mc)
+                    v = alpha * (transa ? a[(size_t) i * lda + p0 + p] : a[(size_t) (p0 + p) * lda + i]);
+                *ap++ = v;
+            }
+        }
+    }
+}
+
+/*
+ * Packs rows [p0, p0 + kc) and columns [j0, j0 + nc) of op(B) into
+ * kc x 4 micro-panels, stored row after row, padded with zero columns
+ */
+static void PackB(bool transb, int kc, int nc, double const *b, int ldb, int p0, int j0, double *bp) {
+    for (int jr = 0; jr < nc; jr += 4) {
+        for (int p = 0; p < kc; ++p) {
+            for (int l = 0; l != 4; ++l) {
+                int j = j0 + jr + l;
+                double v = 0.0;
+                if (jr + l < nc)
+                    v = transb ? b[(size_t) (p0 + p) * ldb + j] : b[(size_t) j * ldb + p0 + p];
+                *bp++ = v;
+            }
+        }
+    }
+}
+
+/*
+ * Accumulates the exact products of a 4 x kc micro-panel of A and a kc x 4 one
+ * of B into the expansions of a 4x4 tile of C, one per column, kept in
+ * registers over the whole panel
+ */
+template<typename FPE> static inline void ExGEMMMicroKernel(int kc, double const *ap, double const *bp, FPE *fpes, int stride) {
+    FPE c0 = fpes[0];
+    FPE c1 = fpes[stride];
+    FPE c2 = fpes[2 * stride];
+    FPE c3 = fpes[3 * stride];
+    for (int p = 0; p != kc; ++p) {
+        Vec4d av = Vec4d().load_a(ap + 4 * p);
+        c0.AccumulateProduct(av, Vec4d(bp[4 * p + 0]));
+        c1.AccumulateProduct(av, Vec4d(bp[4 * p + 1]));
+        c2.AccumulateProduct(av, Vec4d(bp[4 * p + 2]));
+        c3.AccumulateProduct(av, Vec4d(bp[4 * p + 3]));
+    }
+    fpes[0] = c0;
+    fpes[stride] = c1;
+    fpes[2 * stride] = c2;
+    fpes[3 * stride] = c3;
+}
+
+/*
+ * Superaccumulators of the macro-tile of the calling thread. They take about
+ * 1.3 MB for 64 x 64 elements, and are kept for the next tiles and calls of
+ * the thread, whatever the expansion
+ */
+static std::vector<Superaccumulator> & TileAccumulators(size_t count) {
+    static thread_local std::vector<Superaccumulator> accs;
+    if (accs.size() < count)
+        accs.resize(count);
+    return accs;
+}
+
+template<int N, typename TRAITS> void ExGEMMPacked(bool transa, bool transb, int m, int n, int k, double alpha, double const *a, int lda, double const *b, int ldb, double beta, double *c, int ldc) {
+    typedef FPExpansionLanes<N, TRAITS> FPE;
+    int const mc = GEMM_MC;
+    int const nc = GEMM_NC;
+    int const kc = GEMM_KC;
+    int const groups = mc / 4;
+    int mtiles = (m + mc - 1) / mc;
+    int ntiles = (n + nc - 1) / nc;
+
+    #pragma omp parallel
+    {
+        // Element (i, j) of the macro-tile accumulates in lane i % 4 of
+        // fpes[j * groups + i / 4] and in accs[j * mc + i]
+        std::vector<Superaccumulator> & accs = TileAccumulators(mc * nc);
+        std::vector<FPE, CacheAlignedAllocator<FPE> > fpes;
+        fpes.reserve(groups * nc);
+        for (int j = 0; j != nc; ++j)
+            for (int g = 0; g != groups; ++g)
+                fpes.emplace_back(&accs[j * mc + 4 * g]);
+        double *ap = (double *) _mm_malloc(mc * kc * sizeof(double), 64);
+        double *bp = (double *) _mm_malloc(kc * nc * sizeof(double), 64);
+        if (!ap || !bp) {
+            fprintf(stderr, "Cannot allocate memory for the packed panels\n");
+            exit(1);
+        }
+
+        // Each element of C is computed by a single thread: no reduction needed
+        #pragma omp for collapse(2) schedule(dynamic)
+        for (int jt = 0; jt < ntiles; ++jt) {
+            for (int it = 0; it < mtiles; ++it) {
+                int i0 = it * mc;
+                int j0 = jt * nc;
+                int rows = std::min(mc, m - i0);
+                int cols = std::min(nc, n - j0);
+                for (int e = 0; e != mc * nc; ++e)
+                    accs[e].Reset();
+
+                for (int p0 = 0; p0 < k; p0 += kc) {
+                    int depth = std::min(kc, k - p0);
+                    PackA(transa, rows, depth, alpha, a, lda, i0, p0, ap);
+                    PackB(transb, depth, cols, b, ldb, p0, j0, bp);
+                    for (int jr = 0; jr < cols; jr += 4)
+                        for (int ir = 0; ir < rows; ir += 4)
+                            ExGEMMMicroKernel(depth, ap + ir * depth, bp + jr * depth, &fpes[jr * groups + ir / 4], groups);
+                }
+
+                for (int j = 0; j != cols; ++j) {
+                    double *cj = c + (size_t) (j0 + j) * ldc + i0;
+                    for (int g = 0; 4 * g < rows; ++g) {
+                        int l = std::min(4, rows - 4 * g);
+                        FPE & f = fpes[j * groups + g];
+                        if (beta != 0.0)
+                            f.AccumulateProduct(l == 4 ? Vec4d().load(cj + 4 * g) : Vec4d().load_partial(l, cj + 4 * g), Vec4d(beta));
+                        f.Flush();
+                        for (int r = 0; r != l; ++r)
+                            cj[4 * g + r] = accs[j * mc + 4 * g + r].Round();
+                    }
+                }
+                // Padding columns of the last micro-panel are never flushed
+                for (int j = cols; j < std::min(nc, (cols + 3) & ~3); ++j)
+                    for (int g = 0; g != groups; ++g)
+                        fpes[j * groups + g] = FPE(&accs[j * mc + 4 * g]);
+            }
+        }
+
+        _mm_free(ap);
+        _mm_free(bp);
+    }
+}
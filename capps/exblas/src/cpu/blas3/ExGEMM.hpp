@@ -0,0 +1,54 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/**
+ *  \file cpu/blas3/ExGEMM.hpp
+ *  \brief Provides a set of matrix-matrix routines
+ *
+ *  \authors
+ *    Developers : \n
+ *        Roman Iakymchuk  -- roman.iakymchuk@lip6.fr \n
+ *        Sylvain Collange -- sylvain.collange@inria.fr \n
+ */
+
+#ifndef EXGEMM_HPP_
+#define EXGEMM_HPP_
+
+#include "superaccumulator.hpp"
+#include "ExGEMV_FPE.hpp"
+
+#include <omp.h>
+
+#include "common.hpp"
+
+
+/**
+ * \ingroup ExGEMM
+ * \brief Computes C := alpha*op(A)*op(B) + beta*C with our multi-level reproducible
+ *     and accurate algorithm, relying upon floating-point expansions of size N
+ *     (superaccumulators only if N = 0).
+ *     Panels of op(A) and op(B) are packed as in GotoBLAS; the micro-kernel keeps
+ *     the expansions of a 4x4 tile of C in registers, one lane per row, and
+ *     flushes them to the superaccumulators of the tile when needed. Each
+ *     element of C is rounded once, by the thread that owns its macro-tile.
+ *     For internal use
+ *
+ * \param transa whether op(A) = A**T
+ * \param transb whether op(B) = B**T
+ * \param m nb of rows of matrix C
+ * \param n nb of columns of matrix C
+ * \param k nb of columns of op(A)
+ * \param alpha scalar, applied to A before the exact accumulation
+ * \param a matrix A, column-major
+ * \param lda leading dimension of A
+ * \param b matrix B, column-major
+ * \param ldb leading dimension of B
+ * \param beta scalar
+ * \param c matrix C, column-major
+ * \param ldc leading dimension of C
+ */
+template<int N, typename TRAITS> void ExGEMMPacked(bool transa, bool transb, int m, int n, int k, double alpha, double const *a, int lda, double const *b, int ldb, double beta, double *c, int ldc);
+
+#endif // EXGEMM_HPP_
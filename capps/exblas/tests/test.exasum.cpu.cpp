@@ -0,0 +1,143 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <iostream>
+#include <mm_malloc.h>
+#include <omp.h>
+
+// exblas
+#include "blas1.hpp"
+#include "common.hpp"
+
+
+
+int main(int argc, char * argv[]) {
+    int N = 1 << 20;
+    bool lognormal = false;
+    if(argc > 1) {
+        N = 1 << atoi(argv[1]);
+    }
+    if(argc > 4) {
+        if(argv[4][0] == 'n') {
+            lognormal = true;
+        }
+    }
+
+    int range = 1;
+    int emax = 0;
+    double mean = 1., stddev = 1.;
+    if(lognormal) {
+        stddev = strtod(argv[2], 0);
+        mean = strtod(argv[3], 0);
+    }
+    else {
+        if(argc > 2) {
+            range = atoi(argv[2]);
+        }
+        if(argc > 3) {
+            emax = atoi(argv[3]);
+        }
+    }
+
+    double *a = (double*)_mm_malloc(N*sizeof(double), 32);
+    if (!a)
+        fprintf(stderr, "Cannot allocate memory for the main array\n");
+    if(lognormal) {
+        init_lognormal(N, a, mean, stddev);
+    } else if ((argc > 4) && (argv[4][0] == 'i')) {
+        init_ill_cond(N, a, range);
+    } else {
+        if(range == 1){
+            init_naive(N, a);
+        } else {
+            init_fpuniform(N, a, range, emax);
+        }
+    }
+
+    fprintf(stderr, "%d ", N);
+
+    if(lognormal) {
+        fprintf(stderr, "%f ", stddev);
+    } else {
+        fprintf(stderr, "%d ", range);
+    }
+
+    bool is_pass = true;
+    double exasum_acc, exasum_fpe2, exasum_fpe4, exasum_fpe4ee, exasum_fpe6ee, exasum_fpe8ee;
+    exasum_acc = exasum(N, a, 1, 0);
+    exasum_fpe2 = exasum(N, a, 1, 2);
+    exasum_fpe4 = exasum(N, a, 1, 4);
+    exasum_fpe4ee = exasum(N, a, 1, 4, true);
+    exasum_fpe6ee = exasum(N, a, 1, 6, true);
+    exasum_fpe8ee = exasum(N, a, 1, 8, true);
+
+    printf("  exasum with superacc = %.16g\n", exasum_acc);
+    printf("  exasum with FPE2 and superacc = %.16g\n", exasum_fpe2);
+    printf("  exasum with FPE4 and superacc = %.16g\n", exasum_fpe4);
+    printf("  exasum with FPE4 early-exit and superacc = %.16g\n", exasum_fpe4ee);
+    printf("  exasum with FPE6 early-exit and superacc = %.16g\n", exasum_fpe6ee);
+    printf("  exasum with FPE8 early-exit and superacc = %.16g\n", exasum_fpe8ee);
+
+    if (!same_bits(exasum_acc, exasum_fpe2) || !same_bits(exasum_acc, exasum_fpe4) || !same_bits(exasum_acc, exasum_fpe4ee)
+        || !same_bits(exasum_acc, exasum_fpe6ee) || !same_bits(exasum_acc, exasum_fpe8ee)) {
+        is_pass = false;
+        printf("FAILED: %.16g \t %.16g \t %.16g \t %.16g \t %.16g\n", exasum_fpe2, exasum_fpe4, exasum_fpe4ee, exasum_fpe6ee, exasum_fpe8ee);
+    }
+
+    // Same bits as exsum on a copy of the absolute values
+    double *b = (double*)_mm_malloc(N*sizeof(double), 32);
+    for (int i = 0; i != N; ++i)
+        b[i] = fabs(a[i]);
+    double exsum_abs = exsum(N, b, 1, 0, 4);
+    if (!same_bits(exasum_acc, exsum_abs)) {
+        is_pass = false;
+        printf("FAILED: exsum of absolute values = %.16g\n", exsum_abs);
+    }
+    double exasum_inc2 = exasum(N / 2, a, 2, 4);
+    for (int i = 0; i != N / 2; ++i)
+        b[i] = fabs(a[2 * i]);
+    if (!same_bits(exasum_inc2, exsum(N / 2, b, 1, 0, 4))) {
+        is_pass = false;
+        printf("FAILED: exasum with inc = 2 = %.16g\n", exasum_inc2);
+    }
+    _mm_free(b);
+
+    // Same bits with a single thread
+    double exasum_seq = with_threads(1, [&] { return exasum(N, a, 1, 4); });
+    if (!same_bits(exasum_acc, exasum_seq)) {
+        is_pass = false;
+        printf("FAILED: exasum is not reproducible with one thread: %.16g\n", exasum_seq);
+    }
+
+    // Special values
+    double c[5] = {3.0, -4.0, 0.0, -0.5, 0.0};
+    if (exasum(5, c, 1, 4) != 7.5 || exasum(3, c, 2, 0) != 3.0 || exasum(0, c, 1, 4) != 0.0) {
+        is_pass = false;
+        printf("FAILED: exasum of small vectors\n");
+    }
+    c[1] = -std::numeric_limits<double>::infinity();
+    if (exasum(5, c, 1, 4) != std::numeric_limits<double>::infinity()) {
+        is_pass = false;
+        printf("FAILED: exasum with an infinity\n");
+    }
+    c[3] = std::numeric_limits<double>::quiet_NaN();
+    if (!std::isnan(exasum(5, c, 1, 4))) {
+        is_pass = false;
+        printf("FAILED: exasum with a NaN\n");
+    }
+    fprintf(stderr, "\n");
+
+    if (is_pass)
+        printf("TestPassed; ALL OK!\n");
+    else
+        printf("TestFailed!\n");
+
+    return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <mm_malloc.h>
+
+// exblas
+#include "blas1.hpp"
+#include "common.hpp"
+
+
+static void PrintStats(const char * name, __fpe_stats const & s) {
+    printf("  %-6s inputs %10llu flushes %10llu (%.4f) carries %10llu depth", name,
+        (unsigned long long) s.inputs, (unsigned long long) s.flushes,
+        s.inputs ? double(s.flushes) / s.inputs : 0., (unsigned long long) s.carries);
+    for (int d = 0; d != exfpestats_depths; ++d)
+        printf(" %llu", (unsigned long long) s.depth[d]);
+    printf("\n");
+}
+
+// The histogram covers every input, once
+static bool Consistent(__fpe_stats const & s) {
+    uint64_t total = 0;
+    for (int d = 0; d != exfpestats_depths; ++d)
+        total += s.depth[d];
+    return total == s.inputs;
+}
+
+
+int main(int argc, char * argv[]) {
+    int N = 1 << 20;
+    if(argc > 1) {
+        N = 1 << atoi(argv[1]);
+    }
+    double c = 1e+50;
+    if(argc > 2) {
+        c = strtod(argv[2], 0);
+    }
+
+    double *a = (double *) _mm_malloc(N * sizeof(double), 32);
+    if (!a)
+        fprintf(stderr, "Cannot allocate memory for the main array\n");
+    init_ill_cond(N, a, c);
+
+    fprintf(stderr, "%d ", N);
+
+    bool is_pass = true;
+    double ref = exsum(N, a, 1, 0, 2);
+    __mts mref = exmts(N, a, 2);
+
+    // Enabled: same results, and each call has its own counts
+    exfpestats_enable(true);
+    if (!same_bits(exsum(N, a, 1, 0, 2), ref)) {
+        is_pass = false;
+        printf("FAILED: statistics change the sum\n");
+    }
+    __fpe_stats fpe2 = exfpestats_last();
+    PrintStats("fpe2", fpe2);
+#ifdef EXBLAS_FPE_COUNTERS
+    // Inputs go by vectors of 4, and ill-conditioned data overflows an expansion of size 2
+    if (fpe2.inputs != uint64_t(N / 4) || fpe2.flushes == 0 || !Consistent(fpe2)) {
+        is_pass = false;
+        printf("FAILED: exsum with fpe 2 should count N / 4 inputs and some flushes\n");
+    }
+
+    exsum(N, a, 1, 0, 8, true);
+    __fpe_stats fpe8 = exfpestats_last();
+    PrintStats("fpe8ee", fpe8);
+    if (fpe8.inputs != uint64_t(N / 4) || fpe8.flushes > fpe2.flushes || !Consistent(fpe8)) {
+        is_pass = false;
+        printf("FAILED: exsum with fpe 8 should count N / 4 inputs and fewer flushes\n");
+    }
+
+    __mts m = exmts(N, a, 2);
+    __fpe_stats mts = exfpestats_last();
+    PrintStats("mts2", mts);
+    if (!same_bits(m.sum, mref.sum) || !same_bits(m.mts, mref.mts)) {
+        is_pass = false;
+        printf("FAILED: statistics change the mts\n");
+    }
+    if (mts.inputs != uint64_t(N) || mts.flushes == 0 || !Consistent(mts)) {
+        is_pass = false;
+        printf("FAILED: exmts with fpe 2 should count N inputs and some flushes\n");
+    }
+#else
+    // Built without the counters: they stay zero, even when enabled
+    if (fpe2.inputs != 0 || fpe2.flushes != 0 || fpe2.carries != 0) {
+        is_pass = false;
+        printf("FAILED: counted without EXBLAS_FPE_COUNTERS\n");
+    }
+    __mts m = exmts(N, a, 2);
+    __fpe_stats mts = exfpestats_last();
+    if (!same_bits(m.sum, mref.sum) || !same_bits(m.mts, mref.mts)) {
+        is_pass = false;
+        printf("FAILED: statistics change the mts\n");
+    }
+#endif
+
+    // Disabled: the last counts stay
+    exfpestats_enable(false);
+    exsum(N, a, 1, 0, 8, true);
+    __fpe_stats off = exfpestats_last();
+    if (off.inputs != mts.inputs || off.flushes != mts.flushes) {
+        is_pass = false;
+        printf("FAILED: counted while the statistics are disabled\n");
+    }
+
+    fprintf(stderr, "\n");
+
+    if (is_pass)
+        printf("TestPassed; ALL OK!\n");
+    else
+        printf("TestFailed!\n");
+
+    _mm_free(a);
+    return 0;
+}
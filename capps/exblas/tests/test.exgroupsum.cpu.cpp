@@ -0,0 +1,172 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <stdint.h>
+#include <omp.h>
+
+// exblas
+#include "blas1.hpp"
+#include "common.hpp"
+#include "GroupSum.hpp"
+
+
+typedef exblas::GroupSum<uint64_t> Table;
+
+/*
+ * Reference: the values of each key gathered and summed with superaccumulators,
+ * which is exact and correctly rounded
+ */
+static std::vector<double> groupsumVsExsum(int n, int nkeys, const uint64_t *keys, const double *values) {
+    std::vector<std::vector<double> > groups(nkeys);
+    for (int i = 0; i < n; i++)
+        groups[keys[i]].push_back(values[i]);
+    std::vector<double> ref(nkeys, 0.0);
+    for (int k = 0; k < nkeys; k++) {
+        if (!groups[k].empty())
+            ref[k] = exsum(int(groups[k].size()), groups[k].data(), 1, 0, 0);
+    }
+    return ref;
+}
+
+static bool compareSums(const Table &t, int nkeys, const std::vector<double> &ref) {
+    bool ok = true;
+    for (int k = 0; k < nkeys; k++) {
+        double s = t.Sum(k);
+        if (memcmp(&s, &ref[k], sizeof(double)) != 0)
+            ok = false;
+    }
+    return ok;
+}
+
+
+int main(int argc, char * argv[]) {
+    int N = 1 << 20;
+    int nkeys = 1000;
+    bool lognormal = false;
+    if(argc > 1) {
+        N = 1 << atoi(argv[1]);
+    }
+    if(argc > 4) {
+        if(argv[4][0] == 'n') {
+            lognormal = true;
+        }
+    }
+
+    int range = 1;
+    int emax = 0;
+    double mean = 1., stddev = 1.;
+    if(lognormal) {
+        stddev = strtod(argv[2], 0);
+        mean = strtod(argv[3], 0);
+    }
+    else {
+        if(argc > 2) {
+            range = atoi(argv[2]);
+        }
+        if(argc > 3) {
+            emax = atoi(argv[3]);
+        }
+    }
+
+    std::vector<double> values(N);
+    if(lognormal) {
+        init_lognormal(N, values.data(), mean, stddev);
+    } else if ((argc > 4) && (argv[4][0] == 'i')) {
+        init_ill_cond(N, values.data(), range);
+    } else {
+        if(range == 1){
+            init_naive(N, values.data());
+        } else {
+            init_fpuniform(N, values.data(), range, emax);
+        }
+    }
+    // Skewed keys: a few keys get most of the values
+    srand(7);
+    std::vector<uint64_t> keys(N);
+    for (int i = 0; i < N; i++) {
+        int r = rand() % nkeys;
+        keys[i] = (rand() % 2) ? r % 8 : r;
+    }
+
+    fprintf(stderr, "%d %d ", N, nkeys);
+
+    bool is_pass = true;
+    std::vector<double> ref = groupsumVsExsum(N, nkeys, keys.data(), values.data());
+
+    // Same bits whatever the number of threads
+    int nthreads = omp_get_max_threads();
+    int counts[] = {1, 3, 7};
+    for (int c = 0; c != 3; ++c) {
+        omp_set_num_threads(counts[c]);
+        Table t(16);
+        t.Aggregate(N, keys.data(), values.data());
+        if (t.Size() != size_t(nkeys) || !compareSums(t, nkeys, ref)) {
+            is_pass = false;
+            printf("FAILED: GroupSum with %d threads differs from the reference\n", counts[c]);
+        }
+    }
+    omp_set_num_threads(nthreads);
+
+    // Same bits whatever the order of the values, and when halves are merged
+    {
+        std::vector<int> perm(N);
+        for (int i = 0; i < N; i++)
+            perm[i] = i;
+        std::mt19937 gen(7);
+        std::shuffle(perm.begin(), perm.end(), gen);
+        Table t1, t2;
+        for (int i = 0; i < N / 2; i++)
+            t1.Add(keys[perm[i]], values[perm[i]]);
+        for (int i = N / 2; i < N; i++)
+            t2.Add(keys[perm[i]], values[perm[i]]);
+        t2.Merge(t1);
+        if (!compareSums(t2, nkeys, ref)) {
+            is_pass = false;
+            printf("FAILED: GroupSum of shuffled and merged halves differs from the reference\n");
+        }
+
+        // Moved-from tables are empty and usable
+        Table t3(std::move(t2));
+        t2.Add(keys[0], 1.0);
+        t1 = std::move(t3);
+        t3.Add(keys[0], 1.0);
+        if (!compareSums(t1, nkeys, ref) || t2.Size() != 1 || t3.Size() != 1 || t2.Sum(keys[0]) != 1.0) {
+            is_pass = false;
+            printf("FAILED: GroupSum moves\n");
+        }
+    }
+
+    // Cancellation, and values that are not finite
+    {
+        double inf = std::numeric_limits<double>::infinity();
+        Table t;
+        t.Add(0, 1e300); t.Add(0, 1.0); t.Add(0, -1e300);
+        t.Add(1, 1.0); t.Add(1, inf);
+        t.Add(2, inf); t.Add(2, -inf);
+        t.Add(3, 0.0);
+        double s2 = t.Sum(2);
+        if (t.Sum(0) != 1.0 || t.Sum(1) != inf || s2 == s2 || t.Sum(3) != 0.0 || t.Sum(4) != 0.0 || t.Size() != 4) {
+            is_pass = false;
+            printf("FAILED: GroupSum of special values\n");
+        }
+    }
+    fprintf(stderr, "\n");
+
+    if (is_pass)
+        printf("TestPassed; ALL OK!\n");
+    else
+        printf("TestFailed!\n");
+
+    return 0;
+}
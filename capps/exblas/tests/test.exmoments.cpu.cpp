@@ -0,0 +1,274 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <stdint.h>
+#include <omp.h>
+
+// exblas
+#include "blas1.hpp"
+#include "common.hpp"
+
+
+static bool SameMoments(const __moments &a, const __moments &b) {
+    return a.count == b.count && same_bits(a.sum, b.sum) && same_bits(a.sumsq, b.sumsq)
+        && same_bits(a.mean, b.mean) && same_bits(a.variance, b.variance);
+}
+
+static bool SameCovariance(const __covariance &a, const __covariance &b) {
+    return a.count == b.count && same_bits(a.sumx, b.sumx) && same_bits(a.sumy, b.sumy)
+        && same_bits(a.sumxy, b.sumxy) && same_bits(a.meanx, b.meanx) && same_bits(a.meany, b.meany)
+        && same_bits(a.varx, b.varx) && same_bits(a.vary, b.vary) && same_bits(a.covariance, b.covariance);
+}
+
+/*
+ * Offset integers: the centered sums are exact integers below 2^53, so that a
+ * single division gives the correctly rounded variance and covariance, while
+ * the offset makes the textbook formula cancel
+ */
+static bool testIntegers(int ddof) {
+    const int n = 1000;
+    const double offset = std::ldexp(1.0, 30);
+    std::vector<double> x(n), y(n);
+    int64_t sk = 0, sj = 0, skk = 0, sjj = 0, skj = 0;
+    for (int i = 0; i < n; i++) {
+        int64_t k = rand() % 100, j = rand() % 100 - 50;
+        sk += k; sj += j; skk += k * k; sjj += j * j; skj += k * j;
+        x[i] = offset + k;
+        y[i] = -offset + j;
+    }
+    double nm = double(n) * (n - ddof);
+    double varx = double(n * skk - sk * sk) / nm;
+    double vary = double(n * sjj - sj * sj) / nm;
+    double cov = double(n * skj - sk * sj) / nm;
+
+    bool ok = true;
+    // Scales that make the squares overflow or lose bits to subnormals
+    int scales[] = {0, 500, -500};
+    for (int s = 0; s != 3; ++s) {
+        std::vector<double> xs(n), ys(n);
+        for (int i = 0; i < n; i++) {
+            xs[i] = std::ldexp(x[i], scales[s]);
+            ys[i] = std::ldexp(y[i], -scales[s]);
+        }
+        __moments m = exmoments(n, xs.data(), 1, ddof, 4);
+        if (!same_bits(m.variance, std::ldexp(varx, 2 * scales[s]))) {
+            ok = false;
+            printf("FAILED: variance of offset integers scaled by 2^%d: %.17g\n", scales[s], m.variance);
+        }
+        __covariance c = excovariance(n, xs.data(), 1, ys.data(), 1, ddof, 4);
+        if (!same_bits(c.varx, std::ldexp(varx, 2 * scales[s])) || !same_bits(c.vary, std::ldexp(vary, -2 * scales[s]))
+            || !same_bits(c.covariance, cov)) {
+            ok = false;
+            printf("FAILED: covariance of offset integers scaled by 2^%d: %.17g\n", scales[s], c.covariance);
+        }
+    }
+    return ok;
+}
+
+
+// Rounds p / q to the nearest integer, ties to even
+static int64_t RoundDivide(int64_t p, int64_t q) {
+    int64_t r = p / q, rem = p % q;
+    if (2 * rem > q || (2 * rem == q && (r & 1)))
+        r++;
+    return r;
+}
+
+/*
+ * Data near 1e300 and 1e-300, down to the smallest normal: the sums do not fit
+ * in a double, so that the mean and variance need the exact sums to be
+ * correctly rounded, and the variance of the smaller ones is subnormal
+ */
+static bool testExtremes() {
+    const int n = 1000;
+    bool ok = true;
+    std::vector<double> x(n), y(n);
+
+    // Elements (2^lead + k) * 2^scale, whose mean is the one of the k rounded
+    // to the ulp of 2^lead
+    int leads[] = {52, 52, 51}, scales[] = {944, -1049, -1073};
+    for (int s = 0; s != 3; ++s) {
+        int64_t sk = 0;
+        for (int i = 0; i < n; i++) {
+            int64_t k = rand() % 100;
+            sk += k;
+            x[i] = std::ldexp(std::ldexp(1.0, leads[s]) + k, scales[s]);
+        }
+        int64_t r = RoundDivide(sk << (52 - leads[s]), n);
+        double mean = std::ldexp(std::ldexp(1.0, 52) + r, scales[s] + leads[s] - 52);
+        // Below DBL_MAX and above 2^-1075 times their square
+        double variance = (scales[s] > 0) ? std::numeric_limits<double>::infinity() : 0.0;
+        __moments m = exmoments(n, x.data(), 1, 0, 4);
+        if (!same_bits(m.mean, mean) || !same_bits(m.variance, variance)) {
+            ok = false;
+            printf("FAILED: moments near 2^%d: %.17g %.17g instead of %.17g %.17g\n",
+                scales[s] + 52, m.mean, m.variance, mean, variance);
+        }
+    }
+
+    // Covariance of elements near 1e300 with elements near 1e-300, and a
+    // subnormal variance
+    int64_t sk = 0, sj = 0, skk = 0, skj = 0;
+    for (int i = 0; i < n; i++) {
+        int64_t k = rand() % 100, j = rand() % 100 - 50;
+        sk += k; sj += j; skk += k * k; skj += k * j;
+        x[i] = std::ldexp(std::ldexp(1.0, 30) + k, 966);
+        y[i] = std::ldexp(-std::ldexp(1.0, 30) + j, -1027);
+    }
+    double nm = double(n) * n;
+    double cov = std::ldexp(double(n * skj - sk * sj) / nm, -61);
+    __covariance c = excovariance(n, x.data(), 1, y.data(), 1, 0, 4);
+    if (!same_bits(c.covariance, cov)) {
+        ok = false;
+        printf("FAILED: covariance near 1e300 and 1e-300: %.17g instead of %.17g\n", c.covariance, cov);
+    }
+    for (int i = 0; i < n; i++)
+        x[i] = std::ldexp(std::ldexp(x[i], -966), -520);
+    double variance = std::ldexp(double(n * skk - sk * sk), -1040) / nm;
+    __moments m = exmoments(n, x.data(), 1, 0, 4);
+    if (!same_bits(m.variance, variance) || !(variance < std::numeric_limits<double>::min())) {
+        ok = false;
+        printf("FAILED: subnormal variance: %.17g instead of %.17g\n", m.variance, variance);
+    }
+    return ok;
+}
+
+
+int main(int argc, char * argv[]) {
+    int N = 1 << 20;
+    int logN = 20;
+    bool lognormal = false;
+    if(argc > 1) {
+        logN = atoi(argv[1]);
+        N = 1 << logN;
+    }
+    if(argc > 4) {
+        if(argv[4][0] == 'n') {
+            lognormal = true;
+        }
+    }
+
+    int range = 1;
+    int emax = 0;
+    double mean = 1., stddev = 1.;
+    if(lognormal) {
+        stddev = strtod(argv[2], 0);
+        mean = strtod(argv[3], 0);
+    }
+    else {
+        if(argc > 2) {
+            range = atoi(argv[2]);
+        }
+        if(argc > 3) {
+            emax = atoi(argv[3]);
+        }
+    }
+
+    std::vector<double> x(N), y(N);
+    if(lognormal) {
+        init_lognormal(N, x.data(), mean, stddev);
+        init_lognormal(N, y.data(), mean, stddev);
+    } else if ((argc > 4) && (argv[4][0] == 'i')) {
+        init_ill_cond(N, x.data(), range);
+        init_ill_cond(N, y.data(), range);
+    } else {
+        if(range == 1){
+            init_naive(N, x.data());
+            init_naive(N, y.data());
+        } else {
+            init_fpuniform(N, x.data(), range, emax);
+            init_fpuniform(N, y.data(), range, emax);
+        }
+    }
+
+    fprintf(stderr, "%d ", N);
+
+    bool is_pass = true;
+
+    // Sums against exsum and exwsum, and the mean of a power-of-two count
+    __moments ref = exmoments(N, x.data(), 1, 1, 0);
+    if (ref.count != N || !same_bits(ref.sum, exsum(N, x.data(), 1, 0, 0)) || !same_bits(ref.sumsq, exwsum(N, x.data(), 1, x.data(), 1, 0))
+        || !same_bits(ref.mean, std::ldexp(ref.sum, -logN))) {
+        is_pass = false;
+        printf("FAILED: sums or mean differ from exsum\n");
+    }
+
+    int fpes[] = {2, 3, 4, 6, 8};
+    for (int f = 0; f != 5; ++f) {
+        if (!SameMoments(exmoments(N, x.data(), 1, 1, fpes[f]), ref)) {
+            is_pass = false;
+            printf("FAILED: moments with FPE%d differ from superaccumulators\n", fpes[f]);
+        }
+    }
+    if (!SameMoments(exmoments(N, x.data(), 1, 1, 6, true), ref)) {
+        is_pass = false;
+        printf("FAILED: moments with FPE6 early-exit differ from superaccumulators\n");
+    }
+
+    // Same bits whatever the number of threads
+    __covariance cref = excovariance(N, x.data(), 1, y.data(), 1, 1, 4);
+    int counts[] = {1, 3, 7};
+    for (int c = 0; c != 3; ++c) {
+        bool same = with_threads(counts[c], [&] {
+            return SameMoments(exmoments(N, x.data(), 1, 1, 8, true), ref)
+                && SameCovariance(excovariance(N, x.data(), 1, y.data(), 1, 1, 4), cref);
+        });
+        if (!same) {
+            is_pass = false;
+            printf("FAILED: statistics with %d threads differ\n", counts[c]);
+        }
+    }
+
+    // Covariance against the moments of each vector
+    __moments my = exmoments(N, y.data(), 1, 1, 4);
+    __covariance cxx = excovariance(N, x.data(), 1, x.data(), 1, 1, 0);
+    if (!same_bits(cref.sumx, ref.sum) || !same_bits(cref.meanx, ref.mean) || !same_bits(cref.varx, ref.variance)
+        || !same_bits(cref.sumy, my.sum) || !same_bits(cref.vary, my.variance)
+        || !same_bits(cref.sumxy, exwsum(N, x.data(), 1, y.data(), 1, 0)) || !same_bits(cxx.covariance, ref.variance)) {
+        is_pass = false;
+        printf("FAILED: covariance differs from the moments\n");
+    }
+
+    // Correctly rounded variance and covariance, including the rescaled passes
+    srand(42);
+    if (!testIntegers(0) || !testIntegers(1) || !testExtremes())
+        is_pass = false;
+
+    // Special values
+    {
+        double inf = std::numeric_limits<double>::infinity();
+        double v[5] = {1.0, 2.0, inf, 4.0, 1e200};
+        __moments m = exmoments(5, v, 1, 0, 4);
+        __moments one = exmoments(1, v, 1, 1, 4);
+        __moments big = exmoments(2, v + 4, -1, 0, 4);
+        if (m.sum != inf || m.sumsq != inf || m.mean != inf || m.variance == m.variance
+            || one.count != 1 || one.mean != 1.0 || one.variance == one.variance || big.count != 0) {
+            is_pass = false;
+            printf("FAILED: moments of special values\n");
+        }
+        double w[2] = {1e200, 1e200};
+        __moments same = exmoments(2, w, 1, 0, 4);
+        if (same.sumsq != inf || same.mean != 1e200 || same.variance != 0.0) {
+            is_pass = false;
+            printf("FAILED: variance with overflowing squares\n");
+        }
+    }
+
+    printf("variance = %.16g, covariance = %.16g\n", ref.variance, cref.covariance);
+    fprintf(stderr, "\n");
+
+    if (is_pass)
+        printf("TestPassed; ALL OK!\n");
+    else
+        printf("TestFailed!\n");
+
+    return 0;
+}
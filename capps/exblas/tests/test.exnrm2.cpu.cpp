@@ -0,0 +1,184 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <iostream>
+#include <mm_malloc.h>
+#include <omp.h>
+
+// exblas
+#include "blas1.hpp"
+#include "common.hpp"
+
+
+#ifdef EXBLAS_VS_MPFR
+#include <cstddef>
+#include <mpfr.h>
+
+double ExNRM2VsMPFR(int N, double *a) {
+    mpfr_t mpaccum, mpsq;
+    mpfr_init2(mpaccum, 4196);
+    mpfr_init2(mpsq, 4196);
+    mpfr_set_zero(mpaccum, 0);
+
+    for(int i = 0; i != N; ++i) {
+        mpfr_set_d(mpsq, a[i], MPFR_RNDN);
+        mpfr_sqr(mpsq, mpsq, MPFR_RNDN);
+        mpfr_add(mpaccum, mpaccum, mpsq, MPFR_RNDN);
+    }
+    mpfr_sqrt(mpaccum, mpaccum, MPFR_RNDN);
+    double dacc = mpfr_get_d(mpaccum, MPFR_RNDN);
+
+    mpfr_clear(mpsq);
+    mpfr_clear(mpaccum);
+
+    return dacc;
+}
+#endif
+
+
+int main(int argc, char * argv[]) {
+    int N = 1 << 20;
+    bool lognormal = false;
+    if(argc > 1) {
+        N = 1 << atoi(argv[1]);
+    }
+    if(argc > 4) {
+        if(argv[4][0] == 'n') {
+            lognormal = true;
+        }
+    }
+
+    int range = 1;
+    int emax = 0;
+    double mean = 1., stddev = 1.;
+    if(lognormal) {
+        stddev = strtod(argv[2], 0);
+        mean = strtod(argv[3], 0);
+    }
+    else {
+        if(argc > 2) {
+            range = atoi(argv[2]);
+        }
+        if(argc > 3) {
+            emax = atoi(argv[3]);
+        }
+    }
+
+    double *a = (double*)_mm_malloc(N*sizeof(double), 32);
+    if (!a)
+        fprintf(stderr, "Cannot allocate memory for the main array\n");
+    if(lognormal) {
+        init_lognormal(N, a, mean, stddev);
+    } else if ((argc > 4) && (argv[4][0] == 'i')) {
+        init_ill_cond(N, a, range);
+    } else {
+        if(range == 1){
+            init_naive(N, a);
+        } else {
+            init_fpuniform(N, a, range, emax);
+        }
+    }
+
+    fprintf(stderr, "%d ", N);
+
+    if(lognormal) {
+        fprintf(stderr, "%f ", stddev);
+    } else {
+        fprintf(stderr, "%d ", range);
+    }
+
+    bool is_pass = true;
+    double exnrm2_acc, exnrm2_fpe2, exnrm2_fpe4, exnrm2_fpe4ee, exnrm2_fpe6ee, exnrm2_fpe8ee, exnrm2_inc2;
+    exnrm2_acc = exnrm2(N, a, 1, 0);
+    exnrm2_fpe2 = exnrm2(N, a, 1, 2);
+    exnrm2_fpe4 = exnrm2(N, a, 1, 4);
+    exnrm2_fpe4ee = exnrm2(N, a, 1, 4, true);
+    exnrm2_fpe6ee = exnrm2(N, a, 1, 6, true);
+    exnrm2_fpe8ee = exnrm2(N, a, 1, 8, true);
+    exnrm2_inc2 = exnrm2(N / 2, a, 2, 4);
+
+    printf("  exnrm2 with superacc = %.16g\n", exnrm2_acc);
+    printf("  exnrm2 with FPE2 and superacc = %.16g\n", exnrm2_fpe2);
+    printf("  exnrm2 with FPE4 and superacc = %.16g\n", exnrm2_fpe4);
+    printf("  exnrm2 with FPE4 early-exit and superacc = %.16g\n", exnrm2_fpe4ee);
+    printf("  exnrm2 with FPE6 early-exit and superacc = %.16g\n", exnrm2_fpe6ee);
+    printf("  exnrm2 with FPE8 early-exit and superacc = %.16g\n", exnrm2_fpe8ee);
+
+    // The squares are accumulated exactly: every variant rounds the same sum
+    if (!same_bits(exnrm2_acc, exnrm2_fpe2) || !same_bits(exnrm2_acc, exnrm2_fpe4) || !same_bits(exnrm2_acc, exnrm2_fpe4ee)
+        || !same_bits(exnrm2_acc, exnrm2_fpe6ee) || !same_bits(exnrm2_acc, exnrm2_fpe8ee)) {
+        is_pass = false;
+        printf("FAILED: %.16g \t %.16g \t %.16g \t %.16g \t %.16g\n", exnrm2_fpe2, exnrm2_fpe4, exnrm2_fpe4ee, exnrm2_fpe6ee, exnrm2_fpe8ee);
+    }
+    if (!same_bits(exnrm2_inc2, exnrm2(N / 2, a, 2, 0))) {
+        is_pass = false;
+        printf("FAILED: exnrm2 with inc = 2 differs among fpe\n");
+    }
+
+#ifdef EXBLAS_VS_MPFR
+    double exnrm2MPFR = ExNRM2VsMPFR(N, a);
+    printf("  exnrm2 with MPFR = %.16g\n", exnrm2MPFR);
+    if (!same_bits(exnrm2_acc, exnrm2MPFR)) {
+        is_pass = false;
+        printf("FAILED: exnrm2 is not correctly rounded\n");
+    }
+#endif
+
+    // Same bits with a single thread
+    double exnrm2_seq = with_threads(1, [&] { return exnrm2(N, a, 1, 4); });
+    if (!same_bits(exnrm2_acc, exnrm2_seq)) {
+        is_pass = false;
+        printf("FAILED: exnrm2 is not reproducible with one thread: %.16g\n", exnrm2_seq);
+    }
+
+    // Scaling by powers of two is exact, through the overflow and underflow
+    // ranges of the squares
+    double scales[] = {std::ldexp(1.0, 600), std::ldexp(1.0, -600), std::ldexp(1.0, -1000)};
+    double *b = (double*)_mm_malloc(N*sizeof(double), 32);
+    for (int s = 0; s != 3; ++s) {
+        for (int i = 0; i != N; ++i)
+            b[i] = a[i] * scales[s];
+        double scaled = exnrm2(N, b, 1, 4);
+        bool exact = true;
+        for (int i = 0; i != N; ++i)
+            exact = exact && (b[i] / scales[s] == a[i]);
+        if (exact && !same_bits(scaled, exnrm2_acc * scales[s])) {
+            is_pass = false;
+            printf("FAILED: exnrm2 scaled by %a = %.16g\n", scales[s], scaled);
+        }
+    }
+    _mm_free(b);
+
+    // Special values
+    double c[5] = {3.0, 4.0, 0.0, 0.0, 0.0};
+    if (exnrm2(2, c, 1, 4) != 5.0 || exnrm2(3, c, 2, 0) != 3.0 || exnrm2(0, c, 1, 4) != 0.0
+        || exnrm2(3, c + 2, 1, 4) != 0.0) {
+        is_pass = false;
+        printf("FAILED: exnrm2 of small vectors\n");
+    }
+    c[1] = -std::numeric_limits<double>::infinity();
+    if (exnrm2(5, c, 1, 4) != std::numeric_limits<double>::infinity()) {
+        is_pass = false;
+        printf("FAILED: exnrm2 with an infinity\n");
+    }
+    c[3] = std::numeric_limits<double>::quiet_NaN();
+    if (!std::isnan(exnrm2(5, c, 1, 4))) {
+        is_pass = false;
+        printf("FAILED: exnrm2 with a NaN\n");
+    }
+    fprintf(stderr, "\n");
+
+    if (is_pass)
+        printf("TestPassed; ALL OK!\n");
+    else
+        printf("TestFailed!\n");
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <omp.h>
+#include <mm_malloc.h>
+
+// exblas
+#include "blas1.hpp"
+#include "common.hpp"
+
+
+static void PrintProfile(__profile const & p) {
+    printf("  %-10s %10s %14s %14s %14s %12s %12s %12s %12s\n", "phase", "calls", "ticks",
+        "cycles", "instructions", "L1D misses", "L2 misses", "LLC misses", "br misses");
+    for (int k = 0; k != exprofile_phases; ++k) {
+        __profile_counters const & c = p.phase[k];
+        printf("  %-10s %10llu %14llu %14llu %14llu %12llu %12llu %12llu %12llu\n", exprofile_phase_name(k),
+            (unsigned long long) c.calls, (unsigned long long) c.ticks, (unsigned long long) c.cycles,
+            (unsigned long long) c.instructions, (unsigned long long) c.l1d_misses, (unsigned long long) c.l2_misses,
+            (unsigned long long) c.llc_misses, (unsigned long long) c.branch_misses);
+    }
+    printf("  hardware counters available: 0x%x\n", p.available);
+}
+
+
+int main(int argc, char * argv[]) {
+    int N = 1 << 20;
+    if(argc > 1) {
+        N = 1 << atoi(argv[1]);
+    }
+    double c = 1e+50;
+    if(argc > 2) {
+        c = strtod(argv[2], 0);
+    }
+
+    double *a = (double *) _mm_malloc(N * sizeof(double), 32);
+    if (!a)
+        fprintf(stderr, "Cannot allocate memory for the main array\n");
+    init_ill_cond(N, a, c);
+
+    fprintf(stderr, "%d ", N);
+
+    bool is_pass = true;
+    double ref = exsum(N, a, 1, 0, 2);
+
+    // Disabled: nothing is counted
+    exprofile_reset();
+    exsum(N, a, 1, 0, 2);
+    __profile p = exprofile_get();
+    for (int k = 0; k != exprofile_phases; ++k) {
+        if (p.phase[k].calls != 0 || p.phase[k].ticks != 0) {
+            is_pass = false;
+            printf("FAILED: phase %s counted while profiling is disabled\n", exprofile_phase_name(k));
+        }
+    }
+
+    // Enabled: same result, and every phase of each call is counted
+    exprofile_enable(true);
+    exprofile_reset();
+    int calls = 3;
+    for (int i = 0; i != calls; ++i) {
+        if (!same_bits(exsum(N, a, 1, 0, 2), ref)) {
+            is_pass = false;
+            printf("FAILED: profiling changes the sum\n");
+        }
+    }
+    p = exprofile_get();
+    exprofile_enable(false);
+    PrintProfile(p);
+
+    uint64_t threads = omp_get_max_threads();
+    if (p.phase[exprofile_accumulate].calls != calls * threads
+        || p.phase[exprofile_normalize].calls != calls * threads
+        || p.phase[exprofile_reduction].calls != calls * threads
+        || p.phase[exprofile_round].calls != uint64_t(calls)) {
+        is_pass = false;
+        printf("FAILED: each phase should be entered once per thread and call, and rounding once per call\n");
+    }
+    // Ill-conditioned data overflows an expansion of size 2, whose flushes
+    // are only profiled with EXBLAS_FPE_COUNTERS
+    if (p.phase[exprofile_accumulate].ticks == 0) {
+        is_pass = false;
+        printf("FAILED: the accumulation is not counted\n");
+    }
+#ifdef EXBLAS_FPE_COUNTERS
+    if (p.phase[exprofile_flush].calls == 0) {
+        is_pass = false;
+        printf("FAILED: the flushes are not counted\n");
+    }
+#else
+    if (p.phase[exprofile_flush].calls != 0) {
+        is_pass = false;
+        printf("FAILED: the flushes are profiled without EXBLAS_FPE_COUNTERS\n");
+    }
+#endif
+    if ((p.available & exprofile_cycles) && p.phase[exprofile_accumulate].cycles == 0) {
+        is_pass = false;
+        printf("FAILED: cycles are available but not counted\n");
+    }
+
+    fprintf(stderr, "\n");
+
+    if (is_pass)
+        printf("TestPassed; ALL OK!\n");
+    else
+        printf("TestFailed!\n");
+
+    _mm_free(a);
+    return 0;
+}
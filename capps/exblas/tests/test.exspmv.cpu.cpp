@@ -0,0 +1,181 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include "blas1.hpp"
+#include "blas2.hpp"
+#include "common.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+#include <string.h>
+#include <omp.h>
+
+
+/*
+ * Reference: each row as a weighted sum of its values and the gathered
+ * elements of x, which is exact and correctly rounded
+ */
+static void exspmvVsExwsum(int nrows, int *rowptr, int *colidx, double *vals, double *x, double *y) {
+    std::vector<double> xs;
+    for (int i = 0; i < nrows; i++) {
+        int len = rowptr[i + 1] - rowptr[i];
+        xs.resize(len);
+        for (int k = 0; k < len; k++)
+            xs[k] = x[colidx[rowptr[i] + k]];
+        y[i] = (len == 0) ? 0.0 : exwsum(len, vals + rowptr[i], 1, xs.data(), 1, 0);
+    }
+}
+
+static bool compareVectors(int n, const double *y, const double *ref) {
+    return memcmp(y, ref, n * sizeof(double)) == 0;
+}
+
+
+int main(int argc, char *argv[]) {
+    int nrows = 4096, ncols = 4096;
+    int avgnnz = 16;
+    bool lognormal = false;
+
+    if(argc > 1)
+        nrows = atoi(argv[1]);
+    if(argc > 2)
+        ncols = atoi(argv[2]);
+    if(argc > 3)
+        avgnnz = atoi(argv[3]);
+    if(argc > 6) {
+        if(argv[6][0] == 'n') {
+            lognormal = true;
+        }
+    }
+
+    int range = 1;
+    int emax = 0;
+    double mean = 1., stddev = 1.;
+    if(lognormal) {
+        stddev = strtod(argv[4], 0);
+        mean = strtod(argv[5], 0);
+    }
+    else {
+        if(argc > 4) {
+            range = atoi(argv[4]);
+        }
+        if(argc > 5) {
+            emax = atoi(argv[5]);
+        }
+    }
+
+    // Row lengths vary from 0 to 2*avgnnz, and one row holds a quarter of the
+    // nonzeros, so that it is split among threads
+    srand(42);
+    std::vector<int> rowptr(nrows + 1, 0);
+    for (int i = 0; i < nrows; i++) {
+        int len = rand() % (2 * avgnnz + 1);
+        if (i == nrows / 3)
+            len = nrows * avgnnz / 4;
+        rowptr[i + 1] = rowptr[i] + len;
+    }
+    int nnz = rowptr[nrows];
+    std::vector<int> colidx(nnz);
+    for (int k = 0; k < nnz; k++)
+        colidx[k] = rand() % ncols;
+
+    std::vector<double> vals(nnz), x(ncols);
+    if(lognormal) {
+        init_lognormal(nnz, vals.data(), mean, stddev);
+        init_lognormal(ncols, x.data(), mean, stddev);
+    } else if ((argc > 6) && (argv[6][0] == 'i')) {
+        init_ill_cond(nnz, vals.data(), range);
+        init_ill_cond(ncols, x.data(), range);
+    } else {
+        init_fpuniform(nnz, vals.data(), range, emax);
+        init_fpuniform(ncols, x.data(), range, emax);
+    }
+
+    fprintf(stderr, "%d %d %d ", nrows, ncols, nnz);
+
+    bool is_pass = true;
+    std::vector<double> ref(nrows), y(nrows);
+    exspmvVsExwsum(nrows, rowptr.data(), colidx.data(), vals.data(), x.data(), ref.data());
+
+    int fpes[] = {0, 2, 3, 4, 8};
+    for (int f = 0; f != 5; ++f) {
+        exspmv_csr(nrows, rowptr.data(), colidx.data(), vals.data(), x.data(), y.data(), fpes[f]);
+        if (!compareVectors(nrows, y.data(), ref.data())) {
+            is_pass = false;
+            printf("FAILED: FPE%d differs from the reference\n", fpes[f]);
+        }
+    }
+    exspmv_csr(nrows, rowptr.data(), colidx.data(), vals.data(), x.data(), y.data(), 6, true);
+    if (!compareVectors(nrows, y.data(), ref.data())) {
+        is_pass = false;
+        printf("FAILED: FPE6 early-exit differs from the reference\n");
+    }
+
+    // Same bits whatever the number of threads, including more threads than
+    // nonzeros in the split row
+    int nthreads = omp_get_max_threads();
+    int counts[] = {1, 3, 7, 64};
+    for (int c = 0; c != 4; ++c) {
+        omp_set_num_threads(counts[c]);
+        exspmv_csr(nrows, rowptr.data(), colidx.data(), vals.data(), x.data(), y.data(), 4);
+        if (!compareVectors(nrows, y.data(), ref.data())) {
+            is_pass = false;
+            printf("FAILED: FPE4 with %d threads differs from the reference\n", counts[c]);
+        }
+    }
+    omp_set_num_threads(nthreads);
+
+    // Fewer nonzeros than threads, with empty rows around them
+    int rp[6] = {0, 0, 3, 3, 4, 4};
+    int ci[4] = {1, 2, 3, 0};
+    double va[4] = {1e100, 1.0, 1.0, -2.0};
+    double xv[4] = {1.0, 1.0, -1e100, 3.0};
+    double ys[5], yr[5] = {0.0, 3.0, 0.0, -2.0, 0.0};
+    omp_set_num_threads(8);
+    exspmv_csr(5, rp, ci, va, xv, ys, 4);
+    omp_set_num_threads(nthreads);
+    if (!compareVectors(5, ys, yr)) {
+        is_pass = false;
+        printf("FAILED: small matrix with empty rows\n");
+    }
+
+    // Short rows whose sum lies near a midpoint, or is a signed zero: the
+    // leading components alone do not decide the rounding
+    {
+        int rp[5] = {0, 3, 6, 8, 9};
+        int ci[9] = {0, 1, 2, 0, 1, 2, 0, 1, 1};
+        double h = std::ldexp(1.0, -53), t = std::ldexp(1.0, -80);
+        double va[9] = {1.0, h, t, 1.0, -0.5 * h, -t, 1.0, h, -0.0};
+        double xv[3] = {1.0, 1.0, 1.0};
+        double ys[4], yr[4] = {1.0 + 2 * h, 1.0 - h, 1.0, 0.0};
+        for (int f = 0; f != 5; ++f) {
+            exspmv_csr(4, rp, ci, va, xv, ys, fpes[f]);
+            if (!compareVectors(4, ys, yr)) {
+                is_pass = false;
+                printf("FAILED: short rows near a midpoint with FPE%d\n", fpes[f]);
+            }
+        }
+    }
+
+    // DSPMV
+    exspmv_csr(nrows, rowptr.data(), colidx.data(), vals.data(), x.data(), y.data(), 1);
+    double nrm = 0.0, val = 0.0;
+    for (int i = 0; i < nrows; i++) {
+        nrm += pow(fabs(y[i] - ref[i]), 2);
+        val += pow(fabs(ref[i]), 2);
+    }
+    printf("DSPMV error = %.16g\n", ::sqrt(nrm) / ::sqrt(val));
+    fprintf(stderr, "\n");
+
+    if (is_pass)
+        printf("TestPassed; ALL OK!\n");
+    else
+        printf("TestFailed!\n");
+
+    return 0;
+}
@@ -103,13 +103,17 @@ int main(int argc, char * argv[]) {
 #endif
 
     bool is_pass = true;
-    double exsum_acc, exsum_fpe2, exsum_fpe4, exsum_fpe4ee, exsum_fpe6ee, exsum_fpe8ee;
-    exsum_acc = exsum(N, a, 1, 0, false);
-    exsum_fpe2 = exsum(N, a, 1, 2, false);
-    exsum_fpe4 = exsum(N, a, 1, 4, false);
-    exsum_fpe4ee = exsum(N, a, 1, 4, true);
-    exsum_fpe6ee = exsum(N, a, 1, 6, true);
-    exsum_fpe8ee = exsum(N, a, 1, 8, true);
+    double exsum_acc, exsum_fpe2, exsum_fpe4, exsum_fpe4ee, exsum_fpe6ee, exsum_fpe8ee, exsum_auto, exsum_xsum, exsum_online, exsum_ifast;
+    exsum_acc = exsum(N, a, 1, 0, 0);
+    exsum_fpe2 = exsum(N, a, 1, 0, 2);
+    exsum_fpe4 = exsum(N, a, 1, 0, 4);
+    exsum_fpe4ee = exsum(N, a, 1, 0, 4, true);
+    exsum_fpe6ee = exsum(N, a, 1, 0, 6, true);
+    exsum_fpe8ee = exsum(N, a, 1, 0, 8, true);
+    exsum_auto = exsum(N, a, 1, 0, fpe_auto);
+    exsum_xsum = exsum(N, a, 1, 0, fpe_xsum_large);
+    exsum_online = exsum(N, a, 1, 0, fpe_online_exact);
+    exsum_ifast = exsum(N, a, 1, 0, fpe_ifastsum);
 
 #ifdef EXBLAS_MPI
     if (p == 0) {
@@ -120,6 +124,10 @@ int main(int argc, char * argv[]) {
     printf("  exmts with FPE4 early-exit and superacc = %.16g\n", exsum_fpe4ee);
     printf("  exmts with FPE6 early-exit and superacc = %.16g\n", exsum_fpe6ee);
     printf("  exmts with FPE8 early-exit and superacc = %.16g\n", exsum_fpe8ee);
+    printf("  exsum with adaptive FPE and superacc = %.16g\n", exsum_auto);
+    printf("  exsum with xsum large accumulators = %.16g\n", exsum_xsum);
+    printf("  exsum with OnlineExactSum = %.16g\n", exsum_online);
+    printf("  exsum with iFastSum = %.16g\n", exsum_ifast);
 
 #ifdef EXBLAS_VS_MPFR
     double exsumMPFR = ExSUMVsMPFR(N, a);
@@ -130,9 +138,13 @@ int main(int argc, char * argv[]) {
     exsum_fpe4ee = fabs(exsumMPFR - exsum_fpe4ee) / fabs(exsumMPFR);
     exsum_fpe6ee = fabs(exsumMPFR - exsum_fpe6ee) / fabs(exsumMPFR);
     exsum_fpe8ee = fabs(exsumMPFR - exsum_fpe8ee) / fabs(exsumMPFR);
-    if ((exsum_fpe2 > eps) || (exsum_fpe4 > eps) || (exsum_fpe4ee > eps) || (exsum_fpe6ee > eps) || (exsum_fpe8ee > eps)) {
+    exsum_auto = fabs(exsumMPFR - exsum_auto) / fabs(exsumMPFR);
+    exsum_xsum = fabs(exsumMPFR - exsum_xsum) / fabs(exsumMPFR);
+    exsum_online = fabs(exsumMPFR - exsum_online) / fabs(exsumMPFR);
+    exsum_ifast = fabs(exsumMPFR - exsum_ifast) / fabs(exsumMPFR);
+    if ((exsum_fpe2 > eps) || (exsum_fpe4 > eps) || (exsum_fpe4ee > eps) || (exsum_fpe6ee > eps) || (exsum_fpe8ee > eps) || (exsum_auto > eps) || (exsum_xsum > eps) || (exsum_online > eps) || (exsum_ifast > eps)) {
         is_pass = false;
-        printf("FAILED: %.16g \t %.16g \t %.16g \t %.16g \t %.16g\n", exsum_fpe2, exsum_fpe4, exsum_fpe4ee, exsum_fpe6ee, exsum_fpe8ee);
+        printf("FAILED: %.16g \t %.16g \t %.16g \t %.16g \t %.16g \t %.16g \t %.16g \t %.16g \t %.16g\n", exsum_fpe2, exsum_fpe4, exsum_fpe4ee, exsum_fpe6ee, exsum_fpe8ee, exsum_auto, exsum_xsum, exsum_online, exsum_ifast);
     }
 #else
     exsum_fpe2 = fabs(exsum_acc - exsum_fpe2) / fabs(exsum_acc);
@@ -140,9 +152,39 @@ int main(int argc, char * argv[]) {
     exsum_fpe4ee = fabs(exsum_acc - exsum_fpe4ee) / fabs(exsum_acc);
     exsum_fpe6ee = fabs(exsum_acc - exsum_fpe6ee) / fabs(exsum_acc);
     exsum_fpe8ee = fabs(exsum_acc - exsum_fpe8ee) / fabs(exsum_acc);
-    if ((exsum_fpe2 > eps) || (exsum_fpe4 > eps) || (exsum_fpe4ee > eps) || (exsum_fpe6ee > eps) || (exsum_fpe8ee > eps)) {
+    exsum_auto = fabs(exsum_acc - exsum_auto) / fabs(exsum_acc);
+    exsum_xsum = fabs(exsum_acc - exsum_xsum) / fabs(exsum_acc);
+    exsum_online = fabs(exsum_acc - exsum_online) / fabs(exsum_acc);
+    exsum_ifast = fabs(exsum_acc - exsum_ifast) / fabs(exsum_acc);
+    if ((exsum_fpe2 > eps) || (exsum_fpe4 > eps) || (exsum_fpe4ee > eps) || (exsum_fpe6ee > eps) || (exsum_fpe8ee > eps) || (exsum_auto > eps) || (exsum_xsum > eps) || (exsum_online > eps) || (exsum_ifast > eps)) {
         is_pass = false;
-        printf("FAILED: %.16g \t %.16g \t %.16g \t %.16g \t %.16g\n", exsum_fpe2, exsum_fpe4, exsum_fpe4ee, exsum_fpe6ee, exsum_fpe8ee);
+        printf("FAILED: %.16g \t %.16g \t %.16g \t %.16g \t %.16g \t %.16g \t %.16g \t %.16g \t %.16g\n", exsum_fpe2, exsum_fpe4, exsum_fpe4ee, exsum_fpe6ee, exsum_fpe8ee, exsum_auto, exsum_xsum, exsum_online, exsum_ifast);
+    }
+#endif
+
+#ifndef EXBLAS_MPI
+    // Strided and shifted: every backend sums a[offset + i * inca], as a contiguous copy
+    {
+        int offset = 3, n = N / 2 - 2;
+        double *b = (double *) _mm_malloc(n * sizeof(double), 32);
+        for(int inca = 1; inca <= 2; ++inca) {
+            for(int i = 0; i != n; ++i)
+                b[i] = a[offset + i * inca];
+            double ref = exsum(n, b, 1, 0, 0);
+            double strided[] = {
+                exsum(n, a, inca, offset, 0), exsum(n, a, inca, offset, 2), exsum(n, a, inca, offset, 4, true),
+                exsum(n, a, inca, offset, fpe_auto), exsum(n, a, inca, offset, fpe_xsum_large),
+                exsum(n, a, inca, offset, fpe_online_exact), exsum(n, a, inca, offset, fpe_ifastsum)
+            };
+            for(int f = 0; f != 7; ++f) {
+                if (strided[f] != ref) {
+                    is_pass = false;
+                    printf("FAILED with inca = %d, offset = %d, backend %d: %.16g instead of %.16g\n",
+                        inca, offset, f, strided[f], ref);
+                }
+            }
+        }
+        _mm_free(b);
     }
 #endif
     fprintf(stderr, "\n");
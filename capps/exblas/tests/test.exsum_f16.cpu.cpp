@@ -0,0 +1,190 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <stdint.h>
+#include <omp.h>
+#include <mm_malloc.h>
+
+// exblas
+#include "blas1.hpp"
+#include "common.hpp"
+
+
+/*
+ * Half-precision number nearest to v towards zero, saturated to the largest one
+ */
+static uint16_t ToHalf(double v) {
+    uint16_t sign = (v < 0) ? 0x8000 : 0;
+    double a = std::fabs(v);
+    if (!(a < 65504.))
+        return sign | 0x7bff;
+    if (a < std::ldexp(1.0, -14))
+        return sign | uint16_t(std::ldexp(a, 24));
+    int e = ilogb(a);
+    return sign | uint16_t(((e + 15) << 10) | (int(std::ldexp(a, 10 - e)) - 1024));
+}
+
+static double FromHalf(uint16_t h) {
+    int e = (h >> 10) & 0x1f, m = h & 0x3ff;
+    double v = (e == 0) ? std::ldexp(double(m), -24) : std::ldexp(double(m | 0x400), e - 25);
+    return (h & 0x8000) ? -v : v;
+}
+
+static uint16_t ToBFloat16(double v) {
+    float f = float(v);
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(float));
+    return uint16_t(bits >> 16);
+}
+
+static double FromBFloat16(uint16_t h) {
+    uint32_t bits = uint32_t(h) << 16;
+    float f;
+    memcpy(&f, &bits, sizeof(float));
+    return f;
+}
+
+/*
+ * Reference: exsum with superaccumulators only over the elements widened to
+ * double, which holds the same exact sum
+ */
+static double exsumVsWidened(int n, const uint16_t *x, int inc, double (*widen)(uint16_t)) {
+    double *w = (double *) _mm_malloc(n * sizeof(double), 32);
+    for (int i = 0; i < n; i++)
+        w[i] = widen(x[i * inc]);
+    double s = exsum(n, w, 1, 0, 0);
+    _mm_free(w);
+    return s;
+}
+
+
+int main(int argc, char * argv[]) {
+    int N = 1 << 20;
+    bool lognormal = false;
+    if(argc > 1) {
+        N = 1 << atoi(argv[1]);
+    }
+    if(argc > 4) {
+        if(argv[4][0] == 'n') {
+            lognormal = true;
+        }
+    }
+
+    int range = 1;
+    int emax = 0;
+    double mean = 1., stddev = 1.;
+    if(lognormal) {
+        stddev = strtod(argv[2], 0);
+        mean = strtod(argv[3], 0);
+    }
+    else {
+        if(argc > 2) {
+            range = atoi(argv[2]);
+        }
+        if(argc > 3) {
+            emax = atoi(argv[3]);
+        }
+    }
+
+    // Generated in double, then truncated to 16 bits
+    std::vector<double> d(N);
+    if(lognormal) {
+        init_lognormal(N, d.data(), mean, stddev);
+    } else if ((argc > 4) && (argv[4][0] == 'i')) {
+        init_ill_cond(N, d.data(), range);
+    } else {
+        if(range == 1){
+            init_naive(N, d.data());
+        } else {
+            init_fpuniform(N, d.data(), range, emax);
+        }
+    }
+    std::vector<uint16_t> h(N), b(N);
+    for (int i = 0; i < N; i++) {
+        h[i] = ToHalf(d[i]);
+        b[i] = ToBFloat16(d[i]);
+    }
+
+    fprintf(stderr, "%d ", N);
+
+    bool is_pass = true;
+    double href = exsumVsWidened(N, h.data(), 1, FromHalf);
+    double bref = exsumVsWidened(N, b.data(), 1, FromBFloat16);
+
+    // The backends selected by fpe < 0 included
+    int fpes[] = {0, 2, 4, 6, 8, fpe_auto, fpe_xsum_large, fpe_online_exact, fpe_ifastsum};
+    for (int f = 0; f != 9; ++f) {
+        if (!same_bits(exsum_f16(N, h.data(), 1, 0, fpes[f]), href)
+            || !same_bits(exsum_bf16(N, b.data(), 1, 0, fpes[f]), bref)) {
+            is_pass = false;
+            printf("FAILED: 16-bit sums with FPE%d differ from the widened sums\n", fpes[f]);
+        }
+    }
+    if (!same_bits(exsum_f16(N, h.data(), 1, 0, 6, true), href)
+        || !same_bits(exsum_bf16(N, b.data(), 1, 0, 8, true), bref)) {
+        is_pass = false;
+        printf("FAILED: 16-bit sums with early-exit differ from the widened sums\n");
+    }
+
+    // Same bits whatever the number of threads
+    int counts[] = {1, 3, 7};
+    for (int c = 0; c != 3; ++c) {
+        bool same = with_threads(counts[c], [&] {
+            return same_bits(exsum_f16(N, h.data(), 1, 0, 0), href)
+                && same_bits(exsum_bf16(N, b.data(), 1, 0, 4), bref);
+        });
+        if (!same) {
+            is_pass = false;
+            printf("FAILED: 16-bit sums with %d threads differ\n", counts[c]);
+        }
+    }
+
+    // Increment and offset: every other element, from the second one
+    if (!same_bits(exsum_f16(N / 2 - 1, h.data(), 2, 1, 0), exsumVsWidened(N / 2 - 1, h.data() + 1, 2, FromHalf))) {
+        is_pass = false;
+        printf("FAILED: half-precision sum with increment and offset\n");
+    }
+
+    // The fixed-point lanes are flushed before they round: the smallest
+    // subnormal, then many largest numbers of both signs
+    {
+        int n = 1 << 20;
+        std::vector<uint16_t> v(2 * n + 1, 0x7bff);
+        v[0] = 0x0001;
+        for (int i = n + 1; i < 2 * n + 1; i++)
+            v[i] = 0xfbff;
+        double s = exsum_f16(2 * n + 1, v.data(), 1, 0, 0);
+        if (!same_bits(s, std::ldexp(1.0, -24))) {
+            is_pass = false;
+            printf("FAILED: fixed-point sum of extreme half-precision numbers: %.17g\n", s);
+        }
+        // 1 + inf, -inf + inf
+        uint16_t w[4] = {0x3c00, 0x7c00, 0xfc00, 0x7c00};
+        uint16_t bf[2] = {0xff80, 0x7f80};
+        double sw = exsum_f16(2, w, 1, 0, 0);
+        double nw = exsum_f16(2, w, 1, 2, 0);
+        double bw = exsum_bf16(2, bf, 1, 0, 4);
+        if (sw != std::numeric_limits<double>::infinity() || nw == nw || bw == bw) {
+            is_pass = false;
+            printf("FAILED: 16-bit sums of special values\n");
+        }
+    }
+
+    printf("sum = %.16g, bf16 sum = %.16g\n", href, bref);
+    fprintf(stderr, "\n");
+
+    if (is_pass)
+        printf("TestPassed; ALL OK!\n");
+    else
+        printf("TestFailed!\n");
+
+    return 0;
+}
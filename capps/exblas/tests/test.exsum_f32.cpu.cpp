@@ -0,0 +1,163 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <stdint.h>
+#include <omp.h>
+#include <mm_malloc.h>
+
+// exblas
+#include "blas1.hpp"
+#include "common.hpp"
+
+
+/*
+ * Reference: exsum with superaccumulators only over the elements widened to
+ * double, which holds the same exact sum
+ */
+static double exsumVsWidened(int n, const float *x, int inc) {
+    double *w = (double *) _mm_malloc(n * sizeof(double), 32);
+    for (int i = 0; i < n; i++)
+        w[i] = x[i * inc];
+    double s = exsum(n, w, 1, 0, 0);
+    _mm_free(w);
+    return s;
+}
+
+static double exwsumVsWidened(int n, const float *a, const float *b) {
+    std::vector<double> u(a, a + n), v(b, b + n);
+    return exwsum(n, u.data(), 1, v.data(), 1, 0);
+}
+
+
+int main(int argc, char * argv[]) {
+    int N = 1 << 20;
+    bool lognormal = false;
+    if(argc > 1) {
+        N = 1 << atoi(argv[1]);
+    }
+    if(argc > 4) {
+        if(argv[4][0] == 'n') {
+            lognormal = true;
+        }
+    }
+
+    int range = 1;
+    int emax = 0;
+    double mean = 1., stddev = 1.;
+    if(lognormal) {
+        stddev = strtod(argv[2], 0);
+        mean = strtod(argv[3], 0);
+    }
+    else {
+        if(argc > 2) {
+            range = atoi(argv[2]);
+        }
+        if(argc > 3) {
+            emax = atoi(argv[3]);
+        }
+    }
+
+    // Generated in double, then rounded to the nearest float
+    std::vector<double> da(N), db(N);
+    if(lognormal) {
+        init_lognormal(N, da.data(), mean, stddev);
+        init_lognormal(N, db.data(), mean, stddev);
+    } else if ((argc > 4) && (argv[4][0] == 'i')) {
+        init_ill_cond(N, da.data(), range);
+        init_ill_cond(N, db.data(), range);
+    } else {
+        if(range == 1){
+            init_naive(N, da.data());
+            init_naive(N, db.data());
+        } else {
+            init_fpuniform(N, da.data(), range, emax);
+            init_fpuniform(N, db.data(), range, emax);
+        }
+    }
+    std::vector<float> a(N), b(N);
+    for (int i = 0; i < N; i++) {
+        a[i] = float(da[i]);
+        b[i] = float(db[i]);
+    }
+
+    fprintf(stderr, "%d ", N);
+
+    bool is_pass = true;
+    double sref = exsumVsWidened(N, a.data(), 1);
+    double dref = exwsumVsWidened(N, a.data(), b.data());
+
+    // The backends selected by fpe < 0 included
+    int fpes[] = {0, 2, 3, 4, 6, 8, fpe_auto, fpe_xsum_large, fpe_online_exact, fpe_ifastsum};
+    for (int f = 0; f != 10; ++f) {
+        if (!same_bits(exsum_f32(N, a.data(), 1, 0, fpes[f]), sref)
+            || !same_bits(exdot_f32(N, a.data(), 1, 0, b.data(), 1, 0, fpes[f]), dref)) {
+            is_pass = false;
+            printf("FAILED: float sums with FPE%d differ from the widened sums\n", fpes[f]);
+        }
+    }
+    if (!same_bits(exsum_f32(N, a.data(), 1, 0, 6, true), sref)
+        || !same_bits(exdot_f32(N, a.data(), 1, 0, b.data(), 1, 0, 8, true), dref)) {
+        is_pass = false;
+        printf("FAILED: float sums with early-exit differ from the widened sums\n");
+    }
+
+    // Same bits whatever the number of threads
+    int counts[] = {1, 3, 7};
+    for (int c = 0; c != 3; ++c) {
+        bool same = with_threads(counts[c], [&] {
+            return same_bits(exsum_f32(N, a.data(), 1, 0, 4), sref)
+                && same_bits(exdot_f32(N, a.data(), 1, 0, b.data(), 1, 0, 4), dref);
+        });
+        if (!same) {
+            is_pass = false;
+            printf("FAILED: float sums with %d threads differ\n", counts[c]);
+        }
+    }
+
+    // Increment and offset: every other element, from the second one
+    if (!same_bits(exsum_f32(N / 2 - 1, a.data(), 2, 1, 4), exsumVsWidened(N / 2 - 1, a.data() + 1, 2))) {
+        is_pass = false;
+        printf("FAILED: float sum with increment and offset\n");
+    }
+
+    // Extremes of the range of floats: the products of subnormals are exact
+    {
+        float tiny = std::numeric_limits<float>::denorm_min();
+        float big = std::numeric_limits<float>::max();
+        float v[11] = {big, tiny, big, 3 * tiny, -big, 1.f, -big, tiny, 0.f, -1.f, 5 * tiny};
+        double s = exsum_f32(11, v, 1, 0, 4);
+        double d = exdot_f32(11, v, 1, 0, v, 1, 0, 4);
+        double expected = 4 * double(big) * big + 2 + 36 * double(tiny) * tiny;
+        if (!same_bits(s, 10 * double(tiny)) || !same_bits(d, expected)) {
+            is_pass = false;
+            printf("FAILED: float sums at the extremes of the range: %.17g %.17g\n", s, d);
+        }
+        float inf = std::numeric_limits<float>::infinity();
+        float w[4] = {1.f, inf, 2.f, 0.f};
+        double sw = exsum_f32(4, w, 1, 0, 4);
+        double dw = exdot_f32(3, w, 1, 0, w + 1, 1, 0, 4);
+        double nw = exdot_f32(1, w, 1, 1, w, 1, 3, 4);
+        if (sw != double(inf) || dw != double(inf) || nw == nw) {
+            is_pass = false;
+            printf("FAILED: float sums of special values\n");
+        }
+    }
+
+    printf("sum = %.16g, dot = %.16g\n", sref, dref);
+    fprintf(stderr, "\n");
+
+    if (is_pass)
+        printf("TestPassed; ALL OK!\n");
+    else
+        printf("TestFailed!\n");
+
+    return 0;
+}
@@ -0,0 +1,399 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include "blas2.hpp"
+#include "common.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <string.h>
+#include <omp.h>
+
+
+static void copyVector(uint n, double *x, const double *y) {
+    for (uint i = 0; i < n; i++)
+        x[i] = y[i];
+}
+
+#ifdef EXBLAS_VS_MPFR
+#include <cstddef>
+#include <mpfr.h>
+
+static double extrsvVsMPFR(char uplo, const double *extrsv, int n, const double *a, uint lda, const double *x, uint incx) {
+    mpfr_t sum, dot;
+
+    double *extrsv_mpfr = (double *) malloc(n * sizeof(double));
+    copyVector(n, extrsv_mpfr, x);
+
+    mpfr_init2(dot, 128);
+    mpfr_init2(sum, 2098);
+
+    //Produce a result matrix of TRSV using MPFR
+    if (uplo == 'L') {
+        for(int i = 0; i < n; i++) {
+            // sum += a[i,j] * x[j], j < i
+            mpfr_set_d(sum, 0.0, MPFR_RNDN);
+            for(int j = 0; j < i; j++) {
+                mpfr_set_d(dot, a[j * n + i], MPFR_RNDN);
+                mpfr_mul_d(dot, dot, -extrsv_mpfr[j], MPFR_RNDN);
+                mpfr_add(sum, sum, dot, MPFR_RNDN);
+            }
+            mpfr_add_d(sum, sum, extrsv_mpfr[i], MPFR_RNDN);
+            mpfr_div_d(sum, sum, a[i * (n + 1)], MPFR_RNDN);
+            extrsv_mpfr[i] = mpfr_get_d(sum, MPFR_RNDN);
+        }
+    } else if (uplo == 'U') {
+        for(int i = n-1; i >= 0; i--) {
+            // sum += a[i,j] * x[j], j < i
+            mpfr_set_d(sum, 0.0, MPFR_RNDN);
+            for(int j = i+1; j < n; j++) {
+                mpfr_set_d(dot, a[j * n + i], MPFR_RNDN);
+                mpfr_mul_d(dot, dot, -extrsv_mpfr[j], MPFR_RNDN);
+                mpfr_add(sum, sum, dot, MPFR_RNDN);
+            }
+            mpfr_add_d(sum, sum, extrsv_mpfr[i], MPFR_RNDN);
+            mpfr_div_d(sum, sum, a[i * (n + 1)], MPFR_RNDN);
+            extrsv_mpfr[i] = mpfr_get_d(sum, MPFR_RNDN);
+        }
+    }
+
+    //compare the CPU and MPFR results
+#if 0
+    //L2 norm
+    double nrm = 0.0, val = 0.0;
+    for(uint i = 0; i < n; i++) {
+        nrm += pow(fabs(extrsv[i] - extrsv_mpfr[i]), 2);
+        val += pow(fabs(extrsv_mpfr[i]), 2);
+    }
+    nrm = ::sqrt(nrm) / ::sqrt(val);
+#else
+    //Inf norm
+    double nrm = 0.0, val = 0.0;
+    for(int i = 0; i < n; i++) {
+        val = std::max(val, fabs(extrsv_mpfr[i]));
+        nrm = std::max(nrm, fabs(extrsv[i] - extrsv_mpfr[i]));
+        //printf("%.16g\t", fabs(extrsv[i] - extrsv_mpfr[i]));
+    }
+    nrm = nrm / val;
+#endif
+
+    free(extrsv_mpfr);
+    mpfr_free_cache();
+
+    return nrm;
+}
+
+#else
+static double extrsvVsSuperacc(uint n, double *extrsv, double *superacc) {
+    double nrm = 0.0, val = 0.0;
+    for (uint i = 0; i < n; i++) {
+        nrm += pow(fabs(extrsv[i] - superacc[i]), 2);
+        val += pow(fabs(superacc[i]), 2);
+    }
+    nrm = ::sqrt(nrm) / ::sqrt(val);
+
+    return nrm;
+}
+#endif
+
+
+/*
+ * Triangular systems with small integer entries, powers of two on the
+ * diagonal and a known solution, for every uplo, transa and diag: b = op(A)*x
+ * is exact, so that every variant must give back x bit for bit. The other
+ * triangle and, for a unit diagonal, the diagonal hold NaNs, which must not
+ * be read
+ */
+static bool testKnownSolution() {
+    const int n = 37;
+    const char uplos[] = {'U', 'L'}, transas[] = {'N', 'T'}, diags[] = {'U', 'N'};
+    const int fpes[] = {0, 1, 3, 4, 8, 14};
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    double *a = 0, *x = 0, *b = 0;
+    int err = posix_memalign((void **) &a, 64, n * n * sizeof(double));
+    err |= posix_memalign((void **) &x, 64, n * sizeof(double));
+    err |= posix_memalign((void **) &b, 64, n * sizeof(double));
+    if ((!a) || (!x) || (!b) || (err != 0))
+        fprintf(stderr, "Cannot allocate memory with posix_memalign\n");
+
+    // Solution mixing magnitudes 1 and 2^40, whose products still sum exactly.
+    // It has no zeros, which could come out with either sign
+    double sol[n];
+    for (int j = 0; j < n; j++)
+        sol[j] = std::ldexp(double((rand() % 2) ? rand() % 8 + 1 : -(rand() % 8 + 1)), (j % 3 == 0) ? 40 : 0);
+
+    bool ok = true;
+    for (int u = 0; u != 2; ++u) for (int t = 0; t != 2; ++t) for (int d = 0; d != 2; ++d) {
+        char uplo = uplos[u], transa = transas[t], diag = diags[d];
+        // a[j * n + i] is A(i, j)
+        for (int j = 0; j < n; j++) {
+            for (int i = 0; i < n; i++) {
+                bool stored = (uplo == 'U') ? i <= j : i >= j;
+                if (!stored || (i == j && diag == 'U'))
+                    a[j * n + i] = nan;
+                else if (i == j)
+                    a[j * n + i] = std::ldexp((rand() % 2) ? 1.0 : -1.0, rand() % 3);
+                else
+                    a[j * n + i] = double(rand() % 9 - 4);
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            b[i] = 0.0;
+            for (int j = 0; j < n; j++) {
+                int r = (transa == 'N') ? i : j, c = (transa == 'N') ? j : i;
+                bool stored = (uplo == 'U') ? r <= c : r >= c;
+                if (r == c)
+                    b[i] += ((diag == 'U') ? 1.0 : a[c * n + r]) * sol[j];
+                else if (stored)
+                    b[i] += a[c * n + r] * sol[j];
+            }
+        }
+        for (int f = 0; f != 6; ++f) {
+            for (int ee = 0; ee != 2; ++ee) {
+                copyVector(n, x, b);
+                extrsv(uplo, transa, diag, n, a, n, 0, x, 1, 0, fpes[f], ee != 0);
+                if (memcmp(x, sol, n * sizeof(double)) != 0) {
+                    ok = false;
+                    printf("FAILED: known solution with uplo = %c, transa = %c, diag = %c, fpe = %d%s\n",
+                        uplo, transa, diag, fpes[f], ee ? " early-exit" : "");
+                }
+            }
+        }
+    }
+
+    free(a);
+    free(x);
+    free(b);
+    return ok;
+}
+
+
+int main(int argc, char *argv[]) {
+    char uplo = 'U';
+    char transa = 'N';
+    char diag = 'U';
+    uint n = 64;
+    bool lognormal = false;
+    if(argc > 1)
+        uplo = argv[1][0];
+    if(argc > 2)
+        transa = argv[2][0];
+    if(argc > 3)
+        diag = argv[3][0];
+    if(argc > 4)
+        n = atoi(argv[4]);
+    if(argc > 7) {
+        if(argv[7][0] == 'n') {
+            lognormal = true;
+        }
+    }
+
+    int range = 1;
+    int emax = 0;
+    double mean = 1., stddev = 1.;
+    if(lognormal) {
+        stddev = strtod(argv[5], 0);
+        mean = strtod(argv[6], 0);
+    }
+    else {
+        if(argc > 5) {
+            range = atoi(argv[5]);
+        }
+        if(argc > 6) {
+            emax = atoi(argv[6]);
+        }
+    }
+
+    double eps = 1e-13;
+    double *a = 0, *x = 0, *xorig = 0;
+    int err = posix_memalign((void **) &a, 64, n * n * sizeof(double));
+    err &= posix_memalign((void **) &x, 64, n * sizeof(double));
+    err &= posix_memalign((void **) &xorig, 64, n * sizeof(double));
+    if ((!a) || (!x) || (!xorig) || (err != 0))
+        fprintf(stderr, "Cannot allocate memory with posix_memalign\n");
+
+    if(lognormal) {
+        printf("init_lognormal_tr_matrix\n");
+        init_lognormal_tr_matrix(uplo, diag, n, a, mean, stddev);
+        init_lognormal(n, xorig, mean, stddev);
+    } else if ((argc > 7) && (argv[7][0] == 'i')) {
+        printf("init_ill_cond\n");
+        init_ill_cond(n * n, a, range);
+        init_ill_cond(n, xorig, range);
+    } else {
+        printf("init_fpuniform_tr_matrix\n");
+        init_fpuniform_tr_matrix(uplo, diag, n, a, range, emax);
+        init_fpuniform(n, xorig, range, emax);
+    }
+    copyVector(n, x, xorig);
+
+    fprintf(stderr, "%d ", n);
+
+    if(lognormal) {
+        fprintf(stderr, "%f ", stddev);
+    } else {
+        fprintf(stderr, "%d ", range);
+    }
+
+    bool is_pass = true;
+    double *superacc = 0;
+    double norm = 0.;
+    err = posix_memalign((void **) &superacc, 64, n * sizeof(double));
+    if ((!superacc) || (err != 0))
+        fprintf(stderr, "Cannot allocate memory with posix_memalign\n");
+
+    // DTRSV
+    copyVector(n, superacc, xorig);
+    extrsv(uplo, transa, diag, n, a, n, 0, superacc, 1, 0, 1);
+#ifdef EXBLAS_VS_MPFR
+    norm = extrsvVsMPFR(uplo, superacc, n, a, n, xorig, 1);
+    printf("DTRSV error = %.16g\n", norm);
+#endif
+
+    copyVector(n, superacc, xorig);
+    extrsv(uplo, transa, diag, n, a, n, 0, superacc, 1, 0, 0);
+#ifdef EXBLAS_VS_MPFR
+    norm = extrsvVsMPFR(uplo, superacc, n, a, n, xorig, 1);
+    printf("Superacc error = %.16g\n", norm);
+    if (norm > eps) {
+        is_pass = false;
+    }
+#endif
+
+    copyVector(n, x, xorig);
+    extrsv(uplo, transa, diag, n, a, n, 0, x, 1, 0, 3);
+#ifdef EXBLAS_VS_MPFR
+    norm = extrsvVsMPFR(uplo, x, n, a, n, xorig, 1);
+#else
+    norm = extrsvVsSuperacc(n, x, superacc);
+#endif
+    printf("FPE3 error = %.16g\n", norm);
+    if (norm > eps) {
+        is_pass = false;
+    }
+
+    copyVector(n, x, xorig);
+    extrsv(uplo, transa, diag, n, a, n, 0, x, 1, 0, 4);
+#ifdef EXBLAS_VS_MPFR
+    norm = extrsvVsMPFR(uplo, x, n, a, n, xorig, 1);
+#else
+    norm = extrsvVsSuperacc(n, x, superacc);
+#endif
+    printf("FPE4 error = %.16g\n", norm);
+    if (norm > eps) {
+        is_pass = false;
+    }
+
+    copyVector(n, x, xorig);
+    extrsv(uplo, transa, diag, n, a, n, 0, x, 1, 0, 8);
+#ifdef EXBLAS_VS_MPFR
+    norm = extrsvVsMPFR(uplo, x, n, a, n, xorig, 1);
+#else
+    norm = extrsvVsSuperacc(n, x, superacc);
+#endif
+    printf("FPE8 error = %.16g\n", norm);
+    if (norm > eps) {
+        is_pass = false;
+    }
+
+    copyVector(n, x, xorig);
+    extrsv(uplo, transa, diag, n, a, n, 0, x, 1, 0, 4, true);
+#ifdef EXBLAS_VS_MPFR
+    norm = extrsvVsMPFR(uplo, x, n, a, n, xorig, 1);
+#else
+    norm = extrsvVsSuperacc(n, x, superacc);
+#endif
+    printf("FPE4EE error = %.16g\n", norm);
+    if (norm > eps) {
+        is_pass = false;
+    }
+
+    copyVector(n, x, xorig);
+    extrsv(uplo, transa, diag, n, a, n, 0, x, 1, 0, 6, true);
+#ifdef EXBLAS_VS_MPFR
+    norm = extrsvVsMPFR(uplo, x, n, a, n, xorig, 1);
+#else
+    norm = extrsvVsSuperacc(n, x, superacc);
+#endif
+    printf("FPE6EE error = %.16g\n", norm);
+    if (norm > eps) {
+        is_pass = false;
+    }
+
+    copyVector(n, x, xorig);
+    extrsv(uplo, transa, diag, n, a, n, 0, x, 1, 0, 8, true);
+#ifdef EXBLAS_VS_MPFR
+    norm = extrsvVsMPFR(uplo, x, n, a, n, xorig, 1);
+#else
+    norm = extrsvVsSuperacc(n, x, superacc);
+#endif
+    printf("FPE8EE error = %.16g\n", norm);
+    if (norm > eps) {
+        is_pass = false;
+    }
+    // Reproducibility: same bits with a single thread
+    double *x1 = 0;
+    err = posix_memalign((void **) &x1, 64, n * sizeof(double));
+    if ((!x1) || (err != 0))
+        fprintf(stderr, "Cannot allocate memory with posix_memalign\n");
+    copyVector(n, x1, xorig);
+    int nthreads = omp_get_max_threads();
+    with_threads(1, [&] { extrsv(uplo, transa, diag, n, a, n, 0, x1, 1, 0, 8, true); });
+    if (memcmp(x, x1, n * sizeof(double)) != 0) {
+        printf("FPE8EE differs between %d threads and 1 thread\n", nthreads);
+        is_pass = false;
+    }
+
+    // ExTRSV with iterative refinement: the residual is exact, hence the
+    // result does not depend on the size of the expansions either
+    copyVector(n, superacc, xorig);
+    extrsv(uplo, transa, diag, n, a, n, 0, superacc, 1, 0, 10);
+#ifdef EXBLAS_VS_MPFR
+    norm = extrsvVsMPFR(uplo, superacc, n, a, n, xorig, 1);
+    printf("Superacc + ExIR error = %.16g\n", norm);
+    if (norm > eps) {
+        is_pass = false;
+    }
+#endif
+
+    copyVector(n, x, xorig);
+    extrsv(uplo, transa, diag, n, a, n, 0, x, 1, 0, 14);
+    if (memcmp(x, superacc, n * sizeof(double)) != 0) {
+        printf("FPE4 + ExIR differs from Superacc + ExIR\n");
+        is_pass = false;
+    }
+
+    copyVector(n, x, xorig);
+    extrsv(uplo, transa, diag, n, a, n, 0, x, 1, 0, 18, true);
+    if (memcmp(x, superacc, n * sizeof(double)) != 0) {
+        printf("FPE8EE + ExIR differs from Superacc + ExIR\n");
+        is_pass = false;
+    }
+
+    copyVector(n, x, xorig);
+    extrsv(uplo, transa, diag, n, a, n, 0, x, 1, 0, 24, true);
+#ifdef EXBLAS_VS_MPFR
+    norm = extrsvVsMPFR(uplo, x, n, a, n, xorig, 1);
+#else
+    norm = extrsvVsSuperacc(n, x, superacc);
+#endif
+    printf("DTRSV + ExIR error = %.16g\n", norm);
+    free(x1);
+
+    if (!testKnownSolution())
+        is_pass = false;
+    fprintf(stderr, "\n");
+
+    if (is_pass)
+        printf("TestPassed; ALL OK!\n");
+    else
+        printf("TestFailed!\n");
+
+    return 0;
+}
+
@@ -0,0 +1,157 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <iostream>
+#include <mm_malloc.h>
+#include <omp.h>
+
+// exblas
+#include "blas1.hpp"
+#include "common.hpp"
+
+
+
+int main(int argc, char * argv[]) {
+    int N = 1 << 20;
+    bool lognormal = false;
+    if(argc > 1) {
+        N = 1 << atoi(argv[1]);
+    }
+    if(argc > 4) {
+        if(argv[4][0] == 'n') {
+            lognormal = true;
+        }
+    }
+
+    int range = 1;
+    int emax = 0;
+    double mean = 1., stddev = 1.;
+    if(lognormal) {
+        stddev = strtod(argv[2], 0);
+        mean = strtod(argv[3], 0);
+    }
+    else {
+        if(argc > 2) {
+            range = atoi(argv[2]);
+        }
+        if(argc > 3) {
+            emax = atoi(argv[3]);
+        }
+    }
+
+    double *w = (double*)_mm_malloc(N*sizeof(double), 32);
+    double *a = (double*)_mm_malloc(N*sizeof(double), 32);
+    if (!a)
+        fprintf(stderr, "Cannot allocate memory for the main array\n");
+    if(lognormal) {
+        init_lognormal(N, w, mean, stddev);
+        init_lognormal(N, a, mean, stddev);
+    } else if ((argc > 4) && (argv[4][0] == 'i')) {
+        init_fpuniform(N, w, 2, 0);
+        init_ill_cond(N, a, range);
+    } else {
+        if(range == 1){
+            init_naive(N, w);
+            init_naive(N, a);
+        } else {
+            init_fpuniform(N, w, range, emax);
+            init_fpuniform(N, a, range, emax);
+        }
+    }
+
+    fprintf(stderr, "%d ", N);
+
+    if(lognormal) {
+        fprintf(stderr, "%f ", stddev);
+    } else {
+        fprintf(stderr, "%d ", range);
+    }
+
+    bool is_pass = true;
+    double exwsum_acc, exwsum_fpe2, exwsum_fpe4, exwsum_fpe4ee, exwsum_fpe6ee, exwsum_fpe8ee;
+    exwsum_acc = exwsum(N, w, 1, a, 1, 0);
+    exwsum_fpe2 = exwsum(N, w, 1, a, 1, 2);
+    exwsum_fpe4 = exwsum(N, w, 1, a, 1, 4);
+    exwsum_fpe4ee = exwsum(N, w, 1, a, 1, 4, true);
+    exwsum_fpe6ee = exwsum(N, w, 1, a, 1, 6, true);
+    exwsum_fpe8ee = exwsum(N, w, 1, a, 1, 8, true);
+
+    printf("  exwsum with superacc = %.16g\n", exwsum_acc);
+    printf("  exwsum with FPE2 and superacc = %.16g\n", exwsum_fpe2);
+    printf("  exwsum with FPE4 and superacc = %.16g\n", exwsum_fpe4);
+    printf("  exwsum with FPE4 early-exit and superacc = %.16g\n", exwsum_fpe4ee);
+    printf("  exwsum with FPE6 early-exit and superacc = %.16g\n", exwsum_fpe6ee);
+    printf("  exwsum with FPE8 early-exit and superacc = %.16g\n", exwsum_fpe8ee);
+
+    // The products are accumulated exactly: every variant rounds the same sum
+    if (!same_bits(exwsum_acc, exwsum_fpe2) || !same_bits(exwsum_acc, exwsum_fpe4) || !same_bits(exwsum_acc, exwsum_fpe4ee)
+        || !same_bits(exwsum_acc, exwsum_fpe6ee) || !same_bits(exwsum_acc, exwsum_fpe8ee)) {
+        is_pass = false;
+        printf("FAILED: %.16g \t %.16g \t %.16g \t %.16g \t %.16g\n", exwsum_fpe2, exwsum_fpe4, exwsum_fpe4ee, exwsum_fpe6ee, exwsum_fpe8ee);
+    }
+    if (!same_bits(exwsum(N, a, 1, w, 1, 4), exwsum_acc)) {
+        is_pass = false;
+        printf("FAILED: exwsum is not symmetric in w and x\n");
+    }
+
+    // With powers of two as weights, the products are doubles: same bits as
+    // exsum on a copy of them
+    double *b = (double*)_mm_malloc(N*sizeof(double), 32);
+    for (int i = 0; i != N; ++i) {
+        w[i] = ldexp(1.0, i % 64 - 32);
+        b[i] = w[i] * a[i];
+    }
+    double exwsum_pow2 = exwsum(N, w, 1, a, 1, 4);
+    if (!same_bits(exwsum_pow2, exsum(N, b, 1, 0, 0))) {
+        is_pass = false;
+        printf("FAILED: exwsum with powers of two = %.16g\n", exwsum_pow2);
+    }
+    double exwsum_inc = exwsum(N / 3, w, 3, a, 2, 4);
+    for (int i = 0; i != N / 3; ++i)
+        b[i] = w[3 * i] * a[2 * i];
+    if (!same_bits(exwsum_inc, exsum(N / 3, b, 1, 0, 0))) {
+        is_pass = false;
+        printf("FAILED: exwsum with increments = %.16g\n", exwsum_inc);
+    }
+    _mm_free(b);
+
+    // Same bits with a single thread
+    exwsum_acc = exwsum(N, w, 1, a, 1, 0);
+    double exwsum_seq = with_threads(1, [&] { return exwsum(N, w, 1, a, 1, 4); });
+    if (!same_bits(exwsum_acc, exwsum_seq)) {
+        is_pass = false;
+        printf("FAILED: exwsum is not reproducible with one thread: %.16g\n", exwsum_seq);
+    }
+
+    // Special values
+    double c[5] = {3.0, -4.0, 0.0, 0.5, 1e300};
+    double d[5] = {2.0, 1.0, 1.0, 4.0, 1e300};
+    if (exwsum(4, c, 1, d, 1, 4) != 4.0 || exwsum(0, c, 1, d, 1, 4) != 0.0) {
+        is_pass = false;
+        printf("FAILED: exwsum of small vectors\n");
+    }
+    if (exwsum(5, c, 1, d, 1, 4) != std::numeric_limits<double>::infinity()) {
+        is_pass = false;
+        printf("FAILED: exwsum with an overflow\n");
+    }
+    d[2] = std::numeric_limits<double>::infinity();
+    if (!std::isnan(exwsum(5, c, 1, d, 1, 4))) {
+        is_pass = false;
+        printf("FAILED: exwsum of 0 * inf\n");
+    }
+    fprintf(stderr, "\n");
+
+    if (is_pass)
+        printf("TestPassed; ALL OK!\n");
+    else
+        printf("TestFailed!\n");
+
+    return 0;
+}
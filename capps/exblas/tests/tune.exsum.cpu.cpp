@@ -0,0 +1,121 @@
+/*
+ *  Copyright (c) 2016 Inria and University Pierre and Marie Curie
+ *  All rights reserved.
+ */
+
+/*
+ * Benchmarks the grid of FPExpansionTraits instantiations of exsum on
+ * representative inputs and writes the tuning profile read by exsum.
+ *
+ * usage: tune.exsum [profile = exsum.profile in the build dir] [log2 N = 22] [reps = 11]
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <mm_malloc.h>
+#include <omp.h>
+
+// exblas
+#include "blas1.hpp"
+#include "common.hpp"
+#include "ExSUM_Tuning.hpp"
+
+
+static double median_time(ExSUMVariant const & v, int N, double *a, int reps) {
+    std::vector<double> t(reps);
+    for (int i = 0; i != reps; ++i) {
+        double start = omp_get_wtime();
+        v.run(N, a, 1, 0);
+        t[i] = omp_get_wtime() - start;
+    }
+    std::sort(t.begin(), t.end());
+    return t[reps / 2];
+}
+
+int main(int argc, char * argv[]) {
+    std::string path = ExSUMProfilePath();
+    int N = 1 << 22;
+    int reps = 11;
+    if (argc > 1)
+        path = argv[1];
+    if (argc > 2)
+        N = 1 << atoi(argv[2]);
+    if (argc > 3)
+        reps = atoi(argv[3]);
+
+    // Representative inputs: close magnitudes, large dynamic range, ill-conditioned
+    int const ninputs = 4;
+    char const * input_names[ninputs] = {"naive", "uniform range 50", "uniform range 200", "ill-cond 1e+50"};
+    std::vector<double *> inputs(ninputs);
+    std::vector<double> reference(ninputs);
+    for (int k = 0; k != ninputs; ++k) {
+        inputs[k] = (double *) _mm_malloc(N * sizeof(double), 32);
+        if (!inputs[k]) {
+            fprintf(stderr, "Cannot allocate memory for the main array\n");
+            exit(1);
+        }
+    }
+    init_naive(N, inputs[0]);
+    init_fpuniform(N, inputs[1], 50, 0);
+    init_fpuniform(N, inputs[2], 200, 0);
+    init_ill_cond(N, inputs[3], 1e+50);
+    for (int k = 0; k != ninputs; ++k)
+        reference[k] = exsum(N, inputs[k], 1, 0, 0);
+
+    // Score of a variant: geometric mean of its times over the inputs
+    std::vector<ExSUMVariant> const & variants = ExSUMVariants();
+    std::map<std::pair<int, bool>, std::pair<double, ExSUMVariant const *> > best;
+    printf("N = %d, threads = %d\n", N, omp_get_max_threads());
+    for (size_t i = 0; i != variants.size(); ++i) {
+        ExSUMVariant const & v = variants[i];
+        double logsum = 0.;
+        bool exact = true;
+        printf("%-28s", v.name.c_str());
+        for (int k = 0; k != ninputs; ++k) {
+            double r = v.run(N, inputs[k], 1, 0);
+            if (memcmp(&r, &reference[k], sizeof(double)) != 0) {
+                exact = false;
+                break;
+            }
+            double t = median_time(v, N, inputs[k], reps);
+            logsum += log(t);
+            printf(" %10.3f", 1e3 * t);
+        }
+        if (!exact) {
+            printf(" wrong result, discarded\n");
+            continue;
+        }
+        double score = exp(logsum / ninputs);
+        printf("  -> %10.3f ms\n", 1e3 * score);
+
+        std::pair<int, bool> key(v.fpe, v.early_exit);
+        if (best.find(key) == best.end() || score < best[key].first)
+            best[key] = std::make_pair(score, &v);
+    }
+
+    FILE * f = fopen(path.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "Cannot write the tuning profile %s\n", path.c_str());
+        exit(1);
+    }
+    fprintf(f, "# exsum tuning profile: fpe early_exit variant\n");
+    fprintf(f, "# N = %d, threads = %d, inputs:", N, omp_get_max_threads());
+    for (int k = 0; k != ninputs; ++k)
+        fprintf(f, " %s%s", input_names[k], k + 1 != ninputs ? "," : "\n");
+    for (std::map<std::pair<int, bool>, std::pair<double, ExSUMVariant const *> >::const_iterator it = best.begin(); it != best.end(); ++it) {
+        fprintf(f, "%d %d %s\n", it->first.first, int(it->first.second), it->second.second->name.c_str());
+    }
+    fclose(f);
+    printf("Tuning profile written to %s\n", path.c_str());
+
+    for (int k = 0; k != ninputs; ++k)
+        _mm_free(inputs[k]);
+
+    return 0;
+}
@@ -1,7 +1,12 @@
 #!/usr/bin/env bash
 
+# The inputs are generated once into $DATASETS, then mapped. Point it to
+# hugetlbfs or a tmpfs with huge=always for huge pages
+DATASETS=${DATASETS:-datasets}
+mkdir -p "$DATASETS"
+
 for i in 20 21 22 23 24 25 26 27 28 29
 do
 echo "Experiment for $i"
-./precise_parallel_fp $i
+./precise_parallel_fp $i "$DATASETS"
 done
\ No newline at end of file
@@ -0,0 +1,5 @@
+#!/usr/bin/env bash
+
+# Thread scaling of the sums and MTS against the STREAM triad roofline,
+# for both placements of the threads
+./bench_scaling > scaling.csv
@@ -1,4 +1,5 @@
 #include "pfpdefs.hpp"
+#include "pfpbench.hpp"
 #include <cstdlib>
 #include <iostream>
 #include <fstream>
@@ -102,12 +103,12 @@ int _exblas_(int argc, char** argv) {
 
     bool is_pass = true;
     double exsum_acc, exsum_fpe2, exsum_fpe4, exsum_fpe4ee, exsum_fpe6ee, exsum_fpe8ee;
-    exsum_acc = exsum(N, a, 1, 0, false);
-    exsum_fpe2 = exsum(N, a, 1, 2, false);
-    exsum_fpe4 = exsum(N, a, 1, 4, false);
-    exsum_fpe4ee = exsum(N, a, 1, 4, true);
-    exsum_fpe6ee = exsum(N, a, 1, 6, true);
-    exsum_fpe8ee = exsum(N, a, 1, 8, true);
+    exsum_acc = exsum(N, a, 1, 0, 0);
+    exsum_fpe2 = exsum(N, a, 1, 0, 2);
+    exsum_fpe4 = exsum(N, a, 1, 0, 4);
+    exsum_fpe4ee = exsum(N, a, 1, 0, 4, true);
+    exsum_fpe6ee = exsum(N, a, 1, 0, 6, true);
+    exsum_fpe8ee = exsum(N, a, 1, 0, 8, true);
 
     printf("  exmts with superacc = %.16g\n", exsum_acc);
     printf("  exmts with FPE2 and superacc = %.16g\n", exsum_fpe2);
@@ -179,7 +180,7 @@ void test_my_implems(int argc, char** argv){
 
     srand((unsigned int)time(NULL));
     double precision = 1e-18;
-    double start;
+    pfp_bench_options bench_opt;
 
     double *a = (double*)malloc(sizeof(a)* n);
     double *p = (double*)calloc(n, sizeof(p));
@@ -191,30 +192,35 @@ void test_my_implems(int argc, char** argv){
 
 // Sequential
     double seq_sum = 0.0;
-    double seqtime = 0.0;
-
-    PFP_TIME(seq_sum = dsum(a, n), start, seqtime)
+    pfp_bench_result seq = pfp_bench("dsum", [&] { seq_sum = dsum(a, n); }, bench_opt);
+    double seqtime = seq.median;
 
 //    Parallel
-    double par_time = 0.0;
     double par_sum;
-    PFP_TIME(par_sum = dsum_par(a, n), start, par_time)
+    pfp_bench_result par = pfp_bench("dsum_par", [&] { par_sum = dsum_par(a, n); }, bench_opt);
+    double par_time = par.median;
     VERBOSE(verbose, printf("Error: %f \n", (seq_sum - par_sum) / seq_sum))
 
 //    Prefix sum + error correction
-    double pfx_par_time = 0.0;
-    double pfx_cor_time = 0.0;
-    double pfx_tot_time = 0.0;
     int reclevel = 0;
-    PFP_TIME(dpxsum_par(a, p, n), start,pfx_par_time)
-    PFP_TIME(dprecise_parallel(a, p, ep, epp, precision, n, &reclevel), start, pfx_cor_time)
-    pfx_tot_time = pfx_par_time + pfx_cor_time;
+    pfp_bench_result pfx_par = pfp_bench("dpxsum_par", [&] { dpxsum_par(a, p, n); }, bench_opt);
+//    The correction starts again from the uncorrected prefix sum each time
+    pfp_bench_result pfx_cor = pfp_bench("dprecise_parallel",
+                                         [&] { dprecise_parallel(a, p, ep, epp, precision, n, &reclevel); }, bench_opt,
+                                         [&] { dpxsum_par(a, p, n); reclevel = 0; });
+    double pfx_par_time = pfx_par.median;
+    double pfx_cor_time = pfx_cor.median;
+    double pfx_tot_time = pfx_par_time + pfx_cor_time;
     double pre_sum = p[n-1];
     double error = (seq_sum - pre_sum)/seq_sum;
 
-    fprintf(fp, "%i,%3.3f,%3.3f,%3.3f,%3.3f,%3.3f\n", n, seqtime, par_time, pfx_tot_time, pfx_cor_time, error);
+    fprintf(fp, "%i,%.9g,%.9g,%.9g,%.9g,%3.3f\n", n, seqtime, par_time, pfx_tot_time, pfx_cor_time, error);
 
     if(verbose) {
+        pfp_bench_json(stdout, seq);
+        pfp_bench_json(stdout, par);
+        pfp_bench_json(stdout, pfx_par);
+        pfp_bench_json(stdout, pfx_cor);
         printf("Error with correction: %f\n", (seq_sum - pre_sum) / seq_sum);
         printf("\nSequential time: %f seconds.\n", seqtime);
         printf("Parallel wtime (no correction): %f\n", par_time);
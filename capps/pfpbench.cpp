@@ -0,0 +1,202 @@
+//
+// Statistical micro-benchmarks, see pfpbench.hpp
+//
+
+#include "pfpbench.hpp"
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+#include <sched.h>
+#include <unistd.h>
+
+using namespace std;
+
+double pfp_tsc_hz() {
+    static double hz = 0.;
+    if (hz == 0.) {
+        // Busy-wait 50 ms on both clocks
+        double wstart = omp_get_wtime();
+        uint64_t start = pfp_rdtsc_begin();
+        double wend;
+        while ((wend = omp_get_wtime()) - wstart < 0.05)
+            ;
+        hz = (double) (pfp_rdtsc_end() - start) / (wend - wstart);
+    }
+    return hz;
+}
+
+// Topology of a CPU as the kernel reports it, or -1 when unknown
+static int cpu_topology(int cpu, const char* what) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, what);
+    FILE* fp = fopen(path, "r");
+    int id = -1;
+    if (fp) {
+        if (fscanf(fp, "%d", &id) != 1)
+            id = -1;
+        fclose(fp);
+    }
+    return id;
+}
+
+struct cpu_place {
+    int cpu, package, core;
+    int smt_rank;   // among the hardware threads of its core
+    int core_rank;  // among the cores of its package
+};
+
+// CPUs allowed to the process before any pinning. pfp_pin_threads narrows the
+// mask of the calling thread, so later calls must not read it again
+static const cpu_set_t* process_cpus() {
+    static cpu_set_t allowed;
+    static bool valid = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+    return valid ? &allowed : 0;
+}
+
+// Taken when the program loads, before main can pin anything
+static const cpu_set_t* const initial_cpus = process_cpus();
+
+vector<int> pfp_cpu_order(pfp_placement placement) {
+    vector<int> cpus;
+    const cpu_set_t* allowed = process_cpus();
+    if (!allowed)
+        return cpus;
+
+    vector<cpu_place> places;
+    for (int c = 0; c < CPU_SETSIZE; c++) {
+        if (!CPU_ISSET(c, allowed))
+            continue;
+        cpu_place p = {c, cpu_topology(c, "physical_package_id"), cpu_topology(c, "core_id"), 0, 0};
+        if (p.core < 0)
+            p.core = c;
+        places.push_back(p);
+    }
+
+    // Compact order: by package, core, then CPU number
+    sort(places.begin(), places.end(), [](const cpu_place& x, const cpu_place& y) {
+        if (x.package != y.package)
+            return x.package < y.package;
+        if (x.core != y.core)
+            return x.core < y.core;
+        return x.cpu < y.cpu;
+    });
+    for (size_t i = 1; i < places.size(); i++) {
+        const cpu_place& prev = places[i - 1];
+        cpu_place& p = places[i];
+        bool same_package = p.package == prev.package;
+        bool same_core = same_package && p.core == prev.core;
+        p.smt_rank = same_core ? prev.smt_rank + 1 : 0;
+        p.core_rank = same_core ? prev.core_rank : (same_package ? prev.core_rank + 1 : 0);
+    }
+
+    if (placement == pfp_scatter)
+        stable_sort(places.begin(), places.end(), [](const cpu_place& x, const cpu_place& y) {
+            if (x.smt_rank != y.smt_rank)
+                return x.smt_rank < y.smt_rank;
+            if (x.core_rank != y.core_rank)
+                return x.core_rank < y.core_rank;
+            return x.package < y.package;
+        });
+
+    for (size_t i = 0; i < places.size(); i++)
+        cpus.push_back(places[i].cpu);
+    return cpus;
+}
+
+bool pfp_pin_threads(pfp_placement placement) {
+    vector<int> cpus = pfp_cpu_order(placement);
+    if (cpus.empty())
+        return false;
+
+    // Each thread reads its mask back, as the kernel may refuse or change it
+    bool pinned = true;
+#pragma omp parallel reduction(&&:pinned)
+    {
+        cpu_set_t own, now;
+        CPU_ZERO(&own);
+        CPU_SET(cpus[omp_get_thread_num() % cpus.size()], &own);
+        pinned = sched_setaffinity(0, sizeof(own), &own) == 0
+            && sched_getaffinity(0, sizeof(now), &now) == 0 && CPU_EQUAL(&own, &now);
+    }
+    return pinned;
+}
+
+void pfp_flush_cache() {
+    // Four times the last-level cache, or 64 MB when it is unknown
+    static vector<char> buffer;
+    if (buffer.empty()) {
+        long llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+        if (llc <= 0)
+            llc = sysconf(_SC_LEVEL2_CACHE_SIZE);
+        buffer.assign(llc > 0 ? 4 * llc : 64 << 20, 1);
+    }
+    volatile char sink = 0;
+    char acc = 0;
+    for (size_t i = 0; i < buffer.size(); i += 64) {
+        buffer[i]++;
+        acc ^= buffer[i];
+    }
+    sink = acc;
+    (void) sink;
+}
+
+static double median_of(vector<double>& v) {
+    size_t n = v.size();
+    nth_element(v.begin(), v.begin() + n / 2, v.end());
+    double m = v[n / 2];
+    if (n % 2 == 0)
+        m = (m + *max_element(v.begin(), v.begin() + n / 2)) / 2;
+    return m;
+}
+
+static double mad_of(const vector<double>& v, double median) {
+    vector<double> dev(v.size());
+    for (size_t i = 0; i < v.size(); i++)
+        dev[i] = fabs(v[i] - median);
+    return median_of(dev);
+}
+
+bool pfp_bench_stable(vector<uint64_t> ticks, double max_rel_mad) {
+    vector<double> t(ticks.begin(), ticks.end());
+    double m = median_of(t);
+    return m > 0. && mad_of(t, m) <= max_rel_mad * m;
+}
+
+void pfp_bench_stats(vector<uint64_t>& ticks, pfp_bench_result& r) {
+    double hz = pfp_tsc_hz();
+    vector<double> t(ticks.size());
+    for (size_t i = 0; i < ticks.size(); i++)
+        t[i] = ticks[i] / hz;
+    sort(t.begin(), t.end());
+    size_t n = t.size();
+
+    vector<double> work(t);
+    r.reps = (int) n;
+    r.threads = omp_get_max_threads();
+    r.median = median_of(work);
+    r.mad = mad_of(t, r.median);
+    r.min = t[0];
+    r.p10 = t[(n * 10) / 100];
+    r.p90 = t[min(n - 1, (n * 90) / 100)];
+    r.p99 = t[min(n - 1, (n * 99) / 100)];
+    r.max = t[n - 1];
+    r.median_cycles = r.median * hz;
+}
+
+void pfp_bench_csv_header(FILE* fp) {
+    fprintf(fp, "name,threads,cold_cache,reps,median_s,mad_s,min_s,p10_s,p90_s,p99_s,max_s,median_cycles\n");
+}
+
+void pfp_bench_csv(FILE* fp, const pfp_bench_result& r) {
+    fprintf(fp, "%s,%d,%d,%d,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.0f\n",
+            r.name, r.threads, r.cold_cache ? 1 : 0, r.reps, r.median, r.mad,
+            r.min, r.p10, r.p90, r.p99, r.max, r.median_cycles);
+}
+
+void pfp_bench_json(FILE* fp, const pfp_bench_result& r) {
+    fprintf(fp, "{\"name\": \"%s\", \"threads\": %d, \"cold_cache\": %s, \"reps\": %d, "
+                "\"median_s\": %.9g, \"mad_s\": %.9g, \"min_s\": %.9g, \"p10_s\": %.9g, "
+                "\"p90_s\": %.9g, \"p99_s\": %.9g, \"max_s\": %.9g, \"median_cycles\": %.0f}\n",
+            r.name, r.threads, r.cold_cache ? "true" : "false", r.reps, r.median, r.mad,
+            r.min, r.p10, r.p90, r.p99, r.max, r.median_cycles);
+}
@@ -0,0 +1,133 @@
+//
+// Statistical micro-benchmarks: warmup, adaptive number of repetitions,
+// hot or cold caches, pinned threads, and robust statistics (median, MAD,
+// percentiles) of serialised TSC measurements converted to seconds.
+//
+
+#ifndef PRECISE_PARALLEL_FP_PFPBENCH_H
+#define PRECISE_PARALLEL_FP_PFPBENCH_H
+
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+
+// Order in which the OpenMP threads take the CPUs: compact fills the
+// hardware threads of a core, then the cores of a socket, before the next;
+// scatter takes one core of each socket in turn, and hyperthreads last
+enum pfp_placement {
+    pfp_compact,
+    pfp_scatter
+};
+
+struct pfp_bench_options {
+    int warmup;          // untimed calls before the first timed one
+    int min_reps;        // timed calls, at least
+    int max_reps;        // and at most
+    double min_time;     // seconds of timed calls before stopping
+    double max_rel_mad;  // stop once MAD / median is below it
+    bool cold_cache;     // evict the caches before each timed call
+    bool pin_threads;    // bind the OpenMP threads to distinct cores
+    pfp_placement placement;  // in that order
+
+    pfp_bench_options() :
+        warmup(3), min_reps(10), max_reps(300), min_time(0.2), max_rel_mad(0.02),
+        cold_cache(false), pin_threads(true), placement(pfp_compact) {}
+};
+
+struct pfp_bench_result {
+    const char* name;
+    int reps;
+    int threads;
+    bool cold_cache;
+    double median;       // seconds
+    double mad;          // median absolute deviation, in seconds
+    double min, p10, p90, p99, max;
+    double median_cycles;  // TSC ticks
+};
+
+// TSC reads ordered with respect to the surrounding instructions
+static inline uint64_t pfp_rdtsc_begin() {
+    uint32_t hi, lo;
+    asm volatile ("lfence\n\trdtsc" : "=a"(lo), "=d"(hi) : : "memory");
+    return lo | ((uint64_t)hi << 32);
+}
+
+static inline uint64_t pfp_rdtsc_end() {
+    uint32_t hi, lo, aux;
+    asm volatile ("rdtscp\n\tlfence" : "=a"(lo), "=d"(hi), "=c"(aux) : : "memory");
+    return lo | ((uint64_t)hi << 32);
+}
+
+// TSC ticks per second, measured once against omp_get_wtime
+double pfp_tsc_hz();
+
+// CPUs allowed to the process when it started, in the order of placement
+std::vector<int> pfp_cpu_order(pfp_placement placement);
+
+// Binds OpenMP thread i to the i-th CPU of pfp_cpu_order(placement), modulo
+// their number. False when a thread does not read back its own CPU as its mask
+bool pfp_pin_threads(pfp_placement placement = pfp_compact);
+
+// Streams through a buffer larger than the last-level cache
+void pfp_flush_cache();
+
+// Fills the statistics of result from the times of the timed calls, in ticks
+void pfp_bench_stats(std::vector<uint64_t>& ticks, pfp_bench_result& result);
+
+// Machine-readable reports, one line per result
+void pfp_bench_csv_header(FILE* fp);
+void pfp_bench_csv(FILE* fp, const pfp_bench_result& r);
+void pfp_bench_json(FILE* fp, const pfp_bench_result& r);
+
+// True when the MAD of the times is at most max_rel_mad times their median
+bool pfp_bench_stable(std::vector<uint64_t> ticks, double max_rel_mad);
+
+struct pfp_no_setup {
+    void operator()() const {}
+};
+
+//
+// Times call() until at least min_reps calls and min_time seconds are done
+// and the times are stable, or max_reps calls are done. setup() runs before
+// each call, untimed, to restore its inputs.
+//
+template <typename CALL, typename SETUP>
+pfp_bench_result pfp_bench(const char* name, CALL call, const pfp_bench_options& opt, SETUP setup) {
+    if (opt.pin_threads && !pfp_pin_threads(opt.placement))
+        fprintf(stderr, "%s: cannot pin the threads\n", name);
+    for (int i = 0; i < opt.warmup; i++) {
+        setup();
+        call();
+    }
+
+    double hz = pfp_tsc_hz();
+    std::vector<uint64_t> ticks;
+    ticks.reserve(opt.min_reps);
+    uint64_t total = 0;
+    while ((int) ticks.size() < opt.max_reps) {
+        setup();
+        if (opt.cold_cache)
+            pfp_flush_cache();
+        uint64_t start = pfp_rdtsc_begin();
+        call();
+        uint64_t t = pfp_rdtsc_end() - start;
+        ticks.push_back(t);
+        total += t;
+        if ((int) ticks.size() >= opt.min_reps && total >= opt.min_time * hz
+            && pfp_bench_stable(ticks, opt.max_rel_mad))
+            break;
+    }
+
+    pfp_bench_result result;
+    result.name = name;
+    result.cold_cache = opt.cold_cache;
+    pfp_bench_stats(ticks, result);
+    return result;
+}
+
+template <typename CALL>
+pfp_bench_result pfp_bench(const char* name, CALL call, const pfp_bench_options& opt = pfp_bench_options()) {
+    return pfp_bench(name, call, opt, pfp_no_setup());
+}
+
+#endif //PRECISE_PARALLEL_FP_PFPBENCH_H
@@ -70,7 +70,7 @@ _mts_ myparallelmts(double* data, int ndata) {
       (mts_reduction:_mts_:omp_out=mtsjoin(omp_out,omp_in)) \
       initializer(omp_priv={0,0})
 
-#pragma omp parallel for reduction(mts_reduction:m) num_threads(4)
+#pragma omp parallel for reduction(mts_reduction:m)
     for (int idata=0; idata<ndata; idata++){
         m.sum += data[idata];
         m.mts = (m.mts + data[idata] > 0) ? m.mts + data[idata] : 0;
@@ -8,33 +8,18 @@
 #ifndef PRECISE_PARALLEL_FP_PFPDEFS_H
 #define PRECISE_PARALLEL_FP_PFPDEFS_H
 
-// Using haswell tsc for timing
-#ifndef PFP_TIME
-#define PFP_TIME(call,start,mem)\
-start = pfp_rdtsc();\
-call;\
-mem = (double) (pfp_rdtsc() - start);
-#endif
-
-#ifndef PPF_WTIME
-#define PFP_WTIME(call,start,mem,start2,mem2)\
-start2 = omp_get_wtime();\
-start = pfp_rdtsc();\
-call;\
-mem = (double) (pfp_rdtsc() - start);\
-mem2 = (double) (omp_get_wtime() - start2);
-#endif
-
-
 #include "omp.h"
 #include <cstdint>
+#include "common.hpp"
 
 typedef long msize_t;
 static double rand_dbl_limit = 10.0;
 
-static inline void frand_init(double* a, msize_t n){
+// Uniform in [0, rand_dbl_limit), the same for a seed whatever the number of threads
+static inline void frand_init(double* a, msize_t n, uint64_t seed = init_default_seed){
+#pragma omp parallel for schedule(static)
     for(msize_t i = 0; i < n; i++){
-        a[i] = (double)rand()/(RAND_MAX/rand_dbl_limit);
+        a[i] = rand_dbl_limit * counter_uniform(seed, i);
     }
 }
 
@@ -50,11 +35,4 @@ double myparallelmax(double* data, int ndata);
 _mts_ myparallelmts(double* data, int ndata);
 _mts_ custom_reduce_mts(double* data, int ndata);
 
-inline uint64_t pfp_rdtsc()
-{
-    uint32_t hi, lo;
-    asm volatile ("rdtsc" : "=a"(lo), "=d"(hi));
-    return lo | ((uint64_t)hi << 32);
-}
-
 #endif //PRECISE_PARALLEL_FP_PFPDEFS_H
@@ -45,7 +45,7 @@ __mts inexact_parallel_mts(int N, double* a){
       (mts_reduction:__mts:omp_out=mtsjoin(omp_out,omp_in)) \
       initializer(omp_priv={0,0})
 
-#pragma omp parallel for reduction(mts_reduction:m) num_threads(4)
+#pragma omp parallel for reduction(mts_reduction:m)
     for (int idata=0; idata<N; idata++){
         m.sum += a[idata];
         m.mts = (m.mts + a[idata] > 0) ? m.mts + a[idata] : 0;
@@ -55,15 +55,24 @@ __mts inexact_parallel_mts(int N, double* a){
 }
 
 void m_test_mts(int argc, char** argv) {
-    string outputcsv, err_outputcsv;
+    string outputcsv, err_outputcsv, bench_outputcsv;
     outputcsv = string(__FUNCTION__).append(".csv");
     err_outputcsv = string(__FUNCTION__).append("_errlog.csv");
-    int NUM_RUNS = 10;
+    bench_outputcsv = string(__FUNCTION__).append("_bench.csv");
+    pfp_bench_options opt;
 
     fstream  fp, fperr;
     fp.open(outputcsv, ios::app);
     fperr.open(err_outputcsv, ios::app);
 
+    // Statistics of every timing, as many lines as variants and modes
+    FILE* fpbench = fopen(bench_outputcsv.c_str(), "a");
+    fseek(fpbench, 0, SEEK_END);
+    if (ftell(fpbench) == 0) {
+        fprintf(fpbench, "n,initmode,");
+        pfp_bench_csv_header(fpbench);
+    }
+
     double eps = 1e-16;
     int N = 1 << 20;
 
@@ -71,119 +80,127 @@ void m_test_mts(int argc, char** argv) {
         N = 1 << atoi(argv[1]);
     }
 
-    double *a;
+    // The datasets are mapped from the directory given as second argument,
+    // where they are written the first time, or else generated
+    const char* datasets = (argc > 2) ? argv[2] : 0;
+    __dataset_header specs[3] = {dataset_spec(dataset_naive, N),
+                                 dataset_spec(dataset_fpuniform, N, 10, -3),
+                                 dataset_spec(dataset_ill_cond, N, 0.1)};
+
+    double *buffer;
 
-    a = (double *) _mm_malloc(N * sizeof(double), 32);
+    buffer = (double *) _mm_malloc(N * sizeof(double), 32);
 
-    if (!a)
+    if (!buffer)
         fprintf(stderr, "Cannot allocate memory for the main array\n");
 
     for (int initmode = 0; initmode < 3; initmode++) {
-        switch (initmode) {
-            case 0:
-                init_naive(N, a);
-                break;
-            case 1:
-                init_fpuniform(N, a, 10, -3);
-                break;
-            case 2:
-                init_ill_cond(N, a, 0.1);
-                break;
-            default:
-                break;
+        double *a = datasets ? dataset_open(datasets, specs[initmode]) : 0;
+        bool mapped = a != 0;
+        if (!mapped) {
+            a = buffer;
+            dataset_generate(specs[initmode], a);
         }
 
         fprintf(stderr, "%d ", N);
 
         bool is_pass = true;
         __mts inex_mts, exmts_acc, exmts_fpe2, exmts_fpe4, exmts_fpe4ee, exmts_fpe6ee, exmts_fpe8ee;
-        double time_exmts[7] = {0.};
-        double wtime_exmts[7] = {0.};
-        double start, wstart;
+        pfp_bench_result bench_exmts[7];
 
 //        Time a sequential implementation for reference
         __mts seq_res;
-        double seqtime, seqwtime;
-        PFP_WTIME(seq_res = sequential_mts(N, a), start, seqtime, wstart, seqwtime)
+        pfp_bench_result seq_bench = pfp_bench("sequential", [&] { seq_res = sequential_mts(N, a); }, opt);
 
 //        ExSUM for reference on SUM
         double exsum_res = 0.;
         exsum_res = exsum(N, a, 0, 0, 4, true);
 
-        for (int run_no = 0; run_no < NUM_RUNS; run_no++) {
-            PFP_WTIME(inex_mts = inexact_parallel_mts(N, a), start, time_exmts[0], wstart, wtime_exmts[0])
-            PFP_WTIME(exmts_acc = exmts(N, a, 0, false), start, time_exmts[1], wstart, wtime_exmts[1])
-            PFP_WTIME(exmts_fpe2 = exmts(N, a, 2, false), start, time_exmts[2], wstart, wtime_exmts[2])
-            PFP_WTIME(exmts_fpe4 = exmts(N, a, 4, false), start, time_exmts[3], wstart, wtime_exmts[3])
-            PFP_WTIME(exmts_fpe4ee = exmts(N, a, 4, true), start, time_exmts[4], wstart, wtime_exmts[4])
-            PFP_WTIME(exmts_fpe6ee = exmts(N, a, 6, true), start, time_exmts[5], wstart, wtime_exmts[5])
-            PFP_WTIME(exmts_fpe8ee = exmts(N, a, 8, true), start, time_exmts[6], wstart, wtime_exmts[6])
-
-            printf("  exsum whit FPE4ee               = %.16g\n", exsum_res);
-            printf("  exmts sequential                = %.16g  mts = %.16g\n", seq_res.sum, seq_res.mts);
-            printf("  exmts naive inexact             = %.16g  mts = %.16g\n", inex_mts.sum, inex_mts.mts);
-            printf("  exmts with superacc             = %.16g  mts = %.16g\n", exmts_acc.sum, exmts_acc.mts);
-            printf("  exmts with FPE2 and superacc    = %.16g  mts = %.16g\n", exmts_fpe2.sum, exmts_fpe2.mts);
-            printf("  exmts with FPE4 and superacc    = %.16g  mts = %.16g\n", exmts_fpe4.sum, exmts_fpe2.mts);
-            printf("  exmts with FPE4ee and superacc  = %.16g  mts = %.16g\n", exmts_fpe4ee.sum,
-                   exmts_fpe4ee.mts);
-            printf("  exmts with FPE6ee and superacc  = %.16g  mts = %.16g\n", exmts_fpe6ee.sum,
-                   exmts_fpe6ee.mts);
-            printf("  exmts with FPE8ee and superacc  = %.16g  mts = %.16g\n", exmts_fpe8ee.sum,
-                   exmts_fpe8ee.mts);
-
-            double exmts_sacc_esum, exmts_fpe2_esum, exmts_fpe4_esum, exmts_fpe4ee_esum, exmts_fpe6ee_esum, exmts_fpe8ee_esum;
-            double inexmts_esum;
-            double exsum_res_esum;
-//            Compare the results to the sequential sum
-
-            exsum_res_esum = fabs(seq_res.sum - exsum_res) / fabs(seq_res.sum);
-            if(exsum_res_esum > eps) {
-                printf("FAILED for EXSUM: error of %.16g\n", exsum_res_esum);
-            }
-
-            inexmts_esum = fabs(seq_res.sum - inex_mts.sum) / fabs(seq_res.sum);
-            exmts_sacc_esum = fabs(seq_res.sum - exmts_acc.sum) / fabs(seq_res.sum);
-            exmts_fpe2_esum = fabs(seq_res.sum - exmts_fpe2.sum) / fabs(seq_res.sum);
-            exmts_fpe4_esum = fabs(seq_res.sum - exmts_fpe4.sum) / fabs(seq_res.sum);
-            exmts_fpe4ee_esum = fabs(seq_res.sum - exmts_fpe4ee.sum) / fabs(seq_res.sum);
-            exmts_fpe6ee_esum = fabs(seq_res.sum - exmts_fpe6ee.sum) / fabs(seq_res.sum);
-            exmts_fpe8ee_esum = fabs(seq_res.sum - exmts_fpe8ee.sum) / fabs(seq_res.sum);
-            if ((exmts_fpe2_esum > eps) || (exmts_fpe4_esum > eps) || (exmts_fpe4ee_esum > eps) ||
-                (exmts_fpe6ee_esum > eps) || (exmts_fpe8ee_esum > eps)) {
-                is_pass = false;
-                printf("ERROR for inexact: %.16g\n", inexmts_esum);
-                printf("FAILED:\t %.16g %.16g \t %.16g \n\t\t%.16g \t %.16g \t %.16g\n",
-                       exmts_sacc_esum, exmts_fpe2_esum, exmts_fpe4_esum, exmts_fpe4ee_esum,
-                       exmts_fpe6ee_esum, exmts_fpe8ee_esum);
-                fperr << N << "," << initmode << ","
-                      << inexmts_esum << ","
-                      << exmts_sacc_esum << ","
-                      << exmts_fpe2_esum << ","
-                      << exmts_fpe4_esum <<","
-                      << exmts_fpe4ee_esum << ","
-                      << exmts_fpe6ee_esum << ","
-                      << exmts_fpe8ee_esum << endl;
-            }
-
-            fprintf(stderr, "\n");
-
-            if (is_pass)
-                printf("TestPassed; ALL OK!\n");
-            else
-                printf("TestFailed!\n");
+        bench_exmts[0] = pfp_bench("inexact", [&] { inex_mts = inexact_parallel_mts(N, a); }, opt);
+        bench_exmts[1] = pfp_bench("superacc", [&] { exmts_acc = exmts(N, a, 0, false); }, opt);
+        bench_exmts[2] = pfp_bench("fpe2", [&] { exmts_fpe2 = exmts(N, a, 2, false); }, opt);
+        bench_exmts[3] = pfp_bench("fpe4", [&] { exmts_fpe4 = exmts(N, a, 4, false); }, opt);
+        bench_exmts[4] = pfp_bench("fpe4ee", [&] { exmts_fpe4ee = exmts(N, a, 4, true); }, opt);
+        bench_exmts[5] = pfp_bench("fpe6ee", [&] { exmts_fpe6ee = exmts(N, a, 6, true); }, opt);
+        bench_exmts[6] = pfp_bench("fpe8ee", [&] { exmts_fpe8ee = exmts(N, a, 8, true); }, opt);
+
+        printf("  exsum whit FPE4ee               = %.16g\n", exsum_res);
+        printf("  exmts sequential                = %.16g  mts = %.16g\n", seq_res.sum, seq_res.mts);
+        printf("  exmts naive inexact             = %.16g  mts = %.16g\n", inex_mts.sum, inex_mts.mts);
+        printf("  exmts with superacc             = %.16g  mts = %.16g\n", exmts_acc.sum, exmts_acc.mts);
+        printf("  exmts with FPE2 and superacc    = %.16g  mts = %.16g\n", exmts_fpe2.sum, exmts_fpe2.mts);
+        printf("  exmts with FPE4 and superacc    = %.16g  mts = %.16g\n", exmts_fpe4.sum, exmts_fpe2.mts);
+        printf("  exmts with FPE4ee and superacc  = %.16g  mts = %.16g\n", exmts_fpe4ee.sum,
+               exmts_fpe4ee.mts);
+        printf("  exmts with FPE6ee and superacc  = %.16g  mts = %.16g\n", exmts_fpe6ee.sum,
+               exmts_fpe6ee.mts);
+        printf("  exmts with FPE8ee and superacc  = %.16g  mts = %.16g\n", exmts_fpe8ee.sum,
+               exmts_fpe8ee.mts);
+
+        double exmts_sacc_esum, exmts_fpe2_esum, exmts_fpe4_esum, exmts_fpe4ee_esum, exmts_fpe6ee_esum, exmts_fpe8ee_esum;
+        double inexmts_esum;
+        double exsum_res_esum;
+//        Compare the results to the sequential sum
+
+        exsum_res_esum = fabs(seq_res.sum - exsum_res) / fabs(seq_res.sum);
+        if(exsum_res_esum > eps) {
+            printf("FAILED for EXSUM: error of %.16g\n", exsum_res_esum);
         }
+
+        inexmts_esum = fabs(seq_res.sum - inex_mts.sum) / fabs(seq_res.sum);
+        exmts_sacc_esum = fabs(seq_res.sum - exmts_acc.sum) / fabs(seq_res.sum);
+        exmts_fpe2_esum = fabs(seq_res.sum - exmts_fpe2.sum) / fabs(seq_res.sum);
+        exmts_fpe4_esum = fabs(seq_res.sum - exmts_fpe4.sum) / fabs(seq_res.sum);
+        exmts_fpe4ee_esum = fabs(seq_res.sum - exmts_fpe4ee.sum) / fabs(seq_res.sum);
+        exmts_fpe6ee_esum = fabs(seq_res.sum - exmts_fpe6ee.sum) / fabs(seq_res.sum);
+        exmts_fpe8ee_esum = fabs(seq_res.sum - exmts_fpe8ee.sum) / fabs(seq_res.sum);
+        if ((exmts_fpe2_esum > eps) || (exmts_fpe4_esum > eps) || (exmts_fpe4ee_esum > eps) ||
+            (exmts_fpe6ee_esum > eps) || (exmts_fpe8ee_esum > eps)) {
+            is_pass = false;
+            printf("ERROR for inexact: %.16g\n", inexmts_esum);
+            printf("FAILED:\t %.16g %.16g \t %.16g \n\t\t%.16g \t %.16g \t %.16g\n",
+                   exmts_sacc_esum, exmts_fpe2_esum, exmts_fpe4_esum, exmts_fpe4ee_esum,
+                   exmts_fpe6ee_esum, exmts_fpe8ee_esum);
+            fperr << N << "," << initmode << ","
+                  << inexmts_esum << ","
+                  << exmts_sacc_esum << ","
+                  << exmts_fpe2_esum << ","
+                  << exmts_fpe4_esum <<","
+                  << exmts_fpe4ee_esum << ","
+                  << exmts_fpe6ee_esum << ","
+                  << exmts_fpe8ee_esum << endl;
+        }
+
+        fprintf(stderr, "\n");
+
+        if (is_pass)
+            printf("TestPassed; ALL OK!\n");
+        else
+            printf("TestFailed!\n");
+
+//        Speedups over the sequential implementation, from median times
         fp << N << "," << initmode;
         for(int exno = 0; exno < 7; exno++){
-            fp << "," << seqwtime * (NUM_RUNS / wtime_exmts[exno]);
+            fp << "," << seq_bench.median / bench_exmts[exno].median;
         }
         fp << endl;
+
+        fprintf(fpbench, "%d,%d,", N, initmode);
+        pfp_bench_csv(fpbench, seq_bench);
+        for(int exno = 0; exno < 7; exno++){
+            fprintf(fpbench, "%d,%d,", N, initmode);
+            pfp_bench_csv(fpbench, bench_exmts[exno]);
+        }
+
+        if (mapped)
+            dataset_close(a, specs[initmode]);
     }
+    fclose(fpbench);
     
     fp.flush();
     fp.close();
 
     fperr.flush();
     fperr.close();
-    free(a);
+    _mm_free(buffer);
 }
\ No newline at end of file
@@ -7,9 +7,13 @@
 
 #include "common.hpp"
 #include "pfpdefs.hpp"
+#include "pfpbench.hpp"
 #include "blas1.hpp"
 
 
+// MTS and sum with a plain OpenMP reduction, on the current number of threads
+__mts inexact_parallel_mts(int N, double* a);
+
 void m_test_mts(int argc, char** argv);
 
 #endif //PRECISE_PARALLEL_FP_TEST_MTS_H
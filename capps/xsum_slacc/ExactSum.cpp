@@ -211,6 +211,15 @@ double ExactSum::OnlineExactSum(double *num_list, int n)
 	return s;
 }
 
+double ExactSum::iFastSum(const double *num_list, int n, double *arena)
+{
+	if (n < 1) return .0;
+	// iFastSum stores the errors from [1], and its last sum at [n + 1]
+	for (int i = 0; i < n; i++)
+		arena[i + 1] = num_list[i];
+	return iFastSum(arena, n);
+}
+
 void ExactSum::AddNumber(double x)
 {
 	int i;
@@ -302,6 +311,24 @@ void ExactSum::AddArray(double *num_list, int n)
 	}
 }
 
+void ExactSum::AddSum(const ExactSum &other)
+{
+	// the accumulators of other hold its exact sum; AddNumber keeps
+	// the error-free bound on the number of summands
+	for (int i = 0; i < N2_EXPONENT; i++)
+		if (other.t_s[i] != .0)
+			AddNumber(other.t_s[i]);
+}
+
+int ExactSum::GetAccumulators(double *acc_list) const
+{
+	int i, j = 0;
+	for (i = 0; i < N2_EXPONENT; i++)
+		if (t_s[i] != .0)
+			acc_list[++j] = t_s[i];
+	return j;
+}
+
 double ExactSum::GetSum()
 {
 	int i, j = 0;
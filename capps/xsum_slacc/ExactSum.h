@@ -86,6 +86,12 @@ public:
 	//          users can call iFastSum if n < 2000, and OnlineExactSum otherwise
 	double OnlineExactSum(double *num_list, int n);
 
+	// Returns a correctly rounded sum, as iFastSum
+	// Note: a. the array starts from [0]
+	//       b. after execution, num_list does not change: it is copied to
+	//          arena, which holds at least n + 2 numbers, and is destroyed
+	double iFastSum(const double *num_list, int n, double *arena);
+
 
 	// Part B: Online Summation if summands are not given at once, i.e.,
 	//         users can feed a number or an array, and get a sum at any time
@@ -98,6 +104,15 @@ public:
 	// Adds an array, and is used with GetSum()
 	void AddArray(double *num_list, int n);
 
+	// Adds the numbers accumulated by another object, exactly, so that
+	// objects fed by different threads can be merged
+	void AddSum(const ExactSum &other);
+
+	// Copies the non-zero accumulators to acc_list, which holds at least
+	// N2_EXPONENT + 1 numbers, and returns their number
+	// Note: the list starts from [1]; its exact sum is the current sum
+	int GetAccumulators(double *acc_list) const;
+
 	// Returns the current sum
 	// Also see AddNumber()
 	double GetSum();
@@ -39,6 +39,9 @@ int xsum_debug = 0;
 #define OPT_SIMPLE_SQNORM 1 /*   operations done with simple FP arithmetic?   */
 #define OPT_SIMPLE_DOT 1
 
+#define OPT_SMALL_SIMD 1    /* Decode several values at once with AVX2 or
+                               AVX-512, when the compiler targets them?       */
+
 #define INLINE_SMALL 1      /* Inline more of the small accumulator routines? */
 #define INLINE_LARGE 1      /* Inline more of the large accumulator routines? */
 
@@ -488,6 +491,173 @@ void xsum_addv_no_carry (xsum_small_accumulator *restrict sacc,
 }
 
 
+/* ADD A VECTOR TO A SMALL ACCUMULATOR WITH SIMD, ASSUMING NO CARRY NEEDED.
+   Adds exactly n numbers from vec.  The exponents and mantissas of
+   XSUM_SIMD_LANES values are decoded at once, as in xsum_add1_no_carry.
+   Values in the same chunk would make a scatter-add conflict, and would
+   make successive scalar adds wait for each other, so each lane adds into
+   its own copy of the chunks, in lacc, which is interleaved so that chunk i
+   of lane j is at index i*XSUM_SIMD_LANES+j.  The copies of the chunks that
+   were used are then added to the accumulator and cleared; lacc must be all
+   zero on entry.  The lanes together get no more adds than the accumulator
+   would, so they can't overflow either.  A group of values that contains
+   an Inf or NaN is added one value at a time. */
+
+#if OPT_SMALL_SIMD && defined(__AVX512F__)
+# define XSUM_SIMD_LANES 8
+#elif OPT_SMALL_SIMD && defined(__AVX2__)
+# define XSUM_SIMD_LANES 4
+#endif
+
+#ifdef XSUM_SIMD_LANES
+
+#include <immintrin.h>
+
+static void xsum_addv_no_carry_simd (xsum_small_accumulator *restrict sacc,
+                                     xsum_schunk *restrict lacc,
+                                     const xsum_flt *restrict vec,
+                                     xsum_length n)
+{ xsum_length i;
+  int j, lo, hi;
+
+  lo = XSUM_SCHUNKS;
+  hi = -1;
+
+# if XSUM_SIMD_LANES == 8
+  { const __m512i mant_mask = _mm512_set1_epi64 (XSUM_MANTISSA_MASK);
+    const __m512i low_mask = _mm512_set1_epi64 (XSUM_LOW_MANTISSA_MASK);
+    const __m512i implicit = _mm512_set1_epi64 ((xsum_int)1 << XSUM_MANTISSA_BITS);
+    const __m512i lanes = _mm512_set_epi64 (7, 6, 5, 4, 3, 2, 1, 0);
+    const __m512i one = _mm512_set1_epi64 (1);
+    __m512i min_high = _mm512_set1_epi64 (XSUM_SCHUNKS);
+    __m512i max_high = _mm512_set1_epi64 (-1);
+
+    for (i = 0; i + 8 <= n; i += 8)
+    { __m512i ivalue, mantissa, exp, low_exp, high_exp, low, high, ix;
+      __mmask8 denorm, neg;
+
+      ivalue = _mm512_loadu_si512 ((const void *) (vec + i));
+      exp = _mm512_and_si512 (_mm512_srli_epi64 (ivalue, XSUM_MANTISSA_BITS),
+                              _mm512_set1_epi64 (XSUM_EXP_MASK));
+
+      if (_mm512_cmpeq_epi64_mask (exp, _mm512_set1_epi64 (XSUM_EXP_MASK)))
+      { for (j = 0; j < 8; j++) xsum_add1_no_carry (sacc, vec[i+j]);
+        continue;
+      }
+
+      /* Implicit 1 bit for normalized numbers; denormalized ones (and
+         zeros, which add nothing) have an exponent of 1. */
+
+      mantissa = _mm512_and_si512 (ivalue, mant_mask);
+      denorm = _mm512_cmpeq_epi64_mask (exp, _mm512_setzero_si512 ());
+      mantissa = _mm512_mask_or_epi64 (mantissa, ~denorm, mantissa, implicit);
+      exp = _mm512_mask_mov_epi64 (exp, denorm, one);
+
+      low_exp = _mm512_and_si512 (exp, _mm512_set1_epi64 (XSUM_LOW_EXP_MASK));
+      high_exp = _mm512_srli_epi64 (exp, XSUM_LOW_EXP_BITS);
+      low = _mm512_and_si512 (_mm512_sllv_epi64 (mantissa, low_exp), low_mask);
+      high = _mm512_srlv_epi64 (mantissa, _mm512_sub_epi64
+                 (_mm512_set1_epi64 (XSUM_LOW_MANTISSA_BITS), low_exp));
+
+      neg = _mm512_cmplt_epi64_mask (ivalue, _mm512_setzero_si512 ());
+      low = _mm512_mask_sub_epi64 (low, neg, _mm512_setzero_si512 (), low);
+      high = _mm512_mask_sub_epi64 (high, neg, _mm512_setzero_si512 (), high);
+
+      min_high = _mm512_min_epi64 (min_high, high_exp);
+      max_high = _mm512_max_epi64 (max_high, high_exp);
+
+      /* Lane-private chunks: the indexes of a vector never conflict. */
+
+      ix = _mm512_add_epi64 (_mm512_slli_epi64 (high_exp, 3), lanes);
+      _mm512_i64scatter_epi64 (lacc, ix, _mm512_add_epi64 (low,
+        _mm512_i64gather_epi64 (ix, lacc, 8)), 8);
+      ix = _mm512_add_epi64 (ix, _mm512_set1_epi64 (8));
+      _mm512_i64scatter_epi64 (lacc, ix, _mm512_add_epi64 (high,
+        _mm512_i64gather_epi64 (ix, lacc, 8)), 8);
+    }
+
+    lo = (int) _mm512_reduce_min_epi64 (min_high);
+    hi = (int) _mm512_reduce_max_epi64 (max_high);
+  }
+# else
+  { const __m256i mant_mask = _mm256_set1_epi64x (XSUM_MANTISSA_MASK);
+    const __m256i low_mask = _mm256_set1_epi64x (XSUM_LOW_MANTISSA_MASK);
+    const __m256i implicit = _mm256_set1_epi64x ((xsum_int)1 << XSUM_MANTISSA_BITS);
+    const __m256i one = _mm256_set1_epi64x (1);
+    const __m256i zero = _mm256_setzero_si256 ();
+    xsum_schunk lows[4], highs[4];
+    xsum_int ixs[4];
+
+    for (i = 0; i + 4 <= n; i += 4)
+    { __m256i ivalue, mantissa, exp, low_exp, high_exp, low, high, denorm, neg;
+
+      ivalue = _mm256_loadu_si256 ((const __m256i *) (vec + i));
+      exp = _mm256_and_si256 (_mm256_srli_epi64 (ivalue, XSUM_MANTISSA_BITS),
+                              _mm256_set1_epi64x (XSUM_EXP_MASK));
+
+      if (!_mm256_testz_si256 (_mm256_cmpeq_epi64 (exp, 
+                                 _mm256_set1_epi64x (XSUM_EXP_MASK)),
+                               _mm256_set1_epi64x (-1)))
+      { for (j = 0; j < 4; j++) xsum_add1_no_carry (sacc, vec[i+j]);
+        continue;
+      }
+
+      mantissa = _mm256_and_si256 (ivalue, mant_mask);
+      denorm = _mm256_cmpeq_epi64 (exp, zero);
+      mantissa = _mm256_or_si256 (mantissa, 
+                                  _mm256_andnot_si256 (denorm, implicit));
+      exp = _mm256_or_si256 (exp, _mm256_and_si256 (denorm, one));
+
+      low_exp = _mm256_and_si256 (exp, _mm256_set1_epi64x (XSUM_LOW_EXP_MASK));
+      high_exp = _mm256_srli_epi64 (exp, XSUM_LOW_EXP_BITS);
+      low = _mm256_and_si256 (_mm256_sllv_epi64 (mantissa, low_exp), low_mask);
+      high = _mm256_srlv_epi64 (mantissa, _mm256_sub_epi64
+                 (_mm256_set1_epi64x (XSUM_LOW_MANTISSA_BITS), low_exp));
+
+      /* Negate where the sign bit is set: (x ^ -1) + 1. */
+
+      neg = _mm256_cmpgt_epi64 (zero, ivalue);
+      low = _mm256_sub_epi64 (_mm256_xor_si256 (low, neg), neg);
+      high = _mm256_sub_epi64 (_mm256_xor_si256 (high, neg), neg);
+
+      _mm256_storeu_si256 ((__m256i *) lows, low);
+      _mm256_storeu_si256 ((__m256i *) highs, high);
+      _mm256_storeu_si256 ((__m256i *) ixs, high_exp);
+
+      /* Lane-private chunks: the four adds don't wait for each other. */
+
+      for (j = 0; j < 4; j++)
+      { int h = (int) ixs[j];
+        lacc[4*h+j] += lows[j];
+        lacc[4*h+4+j] += highs[j];
+        if (h < lo) lo = h;
+        if (h > hi) hi = h;
+      }
+    }
+  }
+# endif
+
+  /* Fold the lanes that were used into the accumulator. */
+
+  for (j = lo; j <= hi + 1; j++)
+  { xsum_schunk *p = lacc + j*XSUM_SIMD_LANES;
+    xsum_schunk c = 0;
+    int k;
+    for (k = 0; k < XSUM_SIMD_LANES; k++)
+    { c += p[k];
+      p[k] = 0;
+    }
+    sacc->chunk[j] += c;
+  }
+
+  for ( ; i < n; i++)
+  { xsum_add1_no_carry (sacc, vec[i]);
+  }
+}
+
+#endif
+
+
 /* ADD A VECTOR OF FLOATING-POINT NUMBERS TO A SMALL ACCUMULATOR.  Mixes
    calls of xsum_carry_propagate with calls of xsum_addv_no_carry to add 
    parts that are small enough that no carry will result.  Note that
@@ -502,6 +672,24 @@ void xsum_small_addv (xsum_small_accumulator *restrict sacc,
 
   if (n == 0) return;
 
+# ifdef XSUM_SIMD_LANES
+  if (n >= 4*XSUM_SIMD_LANES)
+  { xsum_schunk lacc[XSUM_SCHUNKS*XSUM_SIMD_LANES];
+    memset (lacc, 0, sizeof lacc);
+    while (n > 0)
+    { if (sacc->adds_until_propagate == 0)
+      { (void) xsum_carry_propagate(sacc);
+      }
+      m = n <= sacc->adds_until_propagate ? n : sacc->adds_until_propagate;
+      xsum_addv_no_carry_simd (sacc, lacc, vec, m);
+      sacc->adds_until_propagate -= m;
+      vec += m; 
+      n -= m;
+    }
+    return;
+  }
+# endif
+
   while (n > 1)
   { if (sacc->adds_until_propagate == 0)
     { (void) xsum_carry_propagate(sacc);
@@ -653,6 +841,31 @@ void xsum_small_add_dot (xsum_small_accumulator *restrict sacc,
 }
 
 
+/* ADD A SMALL ACCUMULATOR TO ANOTHER.  Carries are first propagated in
+   both, which leaves each chunk below 2^XSUM_LOW_MANTISSA_BITS in magnitude,
+   so that adding them chunk by chunk counts as a single add.  Inf and NaN
+   values are combined as if the terms had been added one at a time, so the
+   order in which accumulators are added doesn't matter.  The value held by
+   src is not changed. */
+
+void xsum_small_add_accumulator (xsum_small_accumulator *restrict dst,
+                                 xsum_small_accumulator *restrict src)
+{ int i;
+
+  (void) xsum_carry_propagate (dst);
+  (void) xsum_carry_propagate (src);
+
+  if (src->Inf != 0) xsum_small_add_inf_nan (dst, src->Inf);
+  if (src->NaN != 0) xsum_small_add_inf_nan (dst, src->NaN);
+
+  for (i = 0; i < XSUM_SCHUNKS; i++)
+  { dst->chunk[i] += src->chunk[i];
+  }
+
+  dst->adds_until_propagate -= 1;
+}
+
+
 /* RETURN THE RESULT OF ROUNDING A SMALL ACCUMULATOR.  The rounding mode 
    is to nearest, with ties to even.  The small accumulator may be modified 
    by this operation (by carry propagation being done), but the value it
@@ -1634,15 +1847,16 @@ void xsum_large_add_dot (xsum_large_accumulator *restrict lacc,
 }
 
 
-/* RETURN RESULT OF ROUNDING A LARGE ACCUMULATOR.  Rounding mode is to nearest,
-   with ties to even.  
-
-   This is done by adding all the chunks in the large accumulator to the
-   small accumulator, and then calling its rounding procedure. */
+/* TRANSFER A LARGE ACCUMULATOR TO ITS SMALL ACCUMULATOR.  All the chunks
+   in the large accumulator are added to the small accumulator within it,
+   which then holds the exact sum, and a pointer to it is returned.  The
+   chunks are cleared as they are added, so the large accumulator can still
+   be used afterwards. */
 
-xsum_flt xsum_large_round (xsum_large_accumulator *restrict lacc)
+xsum_small_accumulator *xsum_large_to_small (xsum_large_accumulator *restrict
+                                              lacc)
 {
-  if (xsum_debug) printf("Rounding large accumulator\n");
+  if (xsum_debug) printf("Transferring large accumulator to small\n");
 
 # if USE_USED_LARGE
   { 
@@ -1726,7 +1940,21 @@ xsum_flt xsum_large_round (xsum_large_accumulator *restrict lacc)
      by calling the small accumulator rounding function. */
 
 finish:
-  return xsum_small_round (&lacc->sacc);
+  return &lacc->sacc;
+}
+
+
+/* RETURN RESULT OF ROUNDING A LARGE ACCUMULATOR.  Rounding mode is to nearest,
+   with ties to even.  
+
+   This is done by adding all the chunks in the large accumulator to the
+   small accumulator, and then calling its rounding procedure. */
+
+xsum_flt xsum_large_round (xsum_large_accumulator *restrict lacc)
+{
+  if (xsum_debug) printf("Rounding large accumulator\n");
+
+  return xsum_small_round (xsum_large_to_small (lacc));
 }
 
 
@@ -114,6 +114,8 @@ void xsum_small_add_sqnorm (xsum_small_accumulator *restrict,
                             const xsum_flt *restrict, xsum_length);
 void xsum_small_add_dot (xsum_small_accumulator *restrict, 
                          const xsum_flt *, const xsum_flt *, xsum_length);
+void xsum_small_add_accumulator (xsum_small_accumulator *restrict,
+                                 xsum_small_accumulator *restrict);
 xsum_flt xsum_small_round (xsum_small_accumulator *restrict);
 void xsum_small_display (xsum_small_accumulator *restrict);
 int xsum_small_chunks_used (xsum_small_accumulator *restrict);
@@ -125,6 +127,7 @@ void xsum_large_add_sqnorm (xsum_large_accumulator *restrict,
                             const xsum_flt *restrict, xsum_length);
 void xsum_large_add_dot (xsum_large_accumulator *restrict, 
                          const xsum_flt *, const xsum_flt *, xsum_length);
+xsum_small_accumulator *xsum_large_to_small (xsum_large_accumulator *restrict);
 xsum_flt xsum_large_round (xsum_large_accumulator *restrict);
 void xsum_large_display (xsum_large_accumulator *restrict);
 int xsum_large_chunks_used (xsum_large_accumulator *restrict);